@@ -0,0 +1,93 @@
+/**
+ *	@file async_printer.hpp
+ *  @brief Header of \see AsyncPrinter class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/ConnectedComponents
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef INCLUDE_ASYNC_PRINTER_HPP_
+#define INCLUDE_ASYNC_PRINTER_HPP_
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "matrix.hpp"
+#include "terminal_renderer.hpp"
+
+/**
+ * This class prints the boolean matrix on the standard output from a background thread.
+ * The generation to print is not copied: the matrix lends its reading array ( see \ref Matrix::lend ), which
+ * the background thread converts into text while the next generation is computed, and it takes a spare array
+ * in its place. The arrays are handed over through atomic pointers, so the workers never wait for the output;
+ * when the background thread is still printing the previous generation, the new one is dropped.
+ * The generations can also be drawn by a \ref TerminalRenderer, which updates only what changed.
+ */
+class AsyncPrinter
+{
+public:
+	/**
+	 * Initializes a new instance of the \see AsyncPrinter class and starts its thread.
+	 * @param m			boolean matrix, see \ref Matrix.
+	 * @param every		print one iteration every <em>every</em> iterations.
+	 * @param text		<code>true</code> to print the matrix as text; <code>false</code> to call \see Matrix::print,
+	 * 					for matrices that already print asynchronously, as \ref MatrixG.
+	 * @param terminal	<code>true</code> to draw the text generations with a \ref TerminalRenderer.
+	 */
+	AsyncPrinter( Matrix* m, int every, bool text, bool terminal = false );
+
+	/**
+	 * Print the current configuration of the matrix, if the iteration is one of those to print.
+	 * It has to be called after each generation: it takes back the array lent at the previous one, if any,
+	 * and lends the current one, while the output is left to the background thread.
+	 * @param iteration_number	iteration that was completed.
+	 */
+	void publish( int iteration_number );
+
+	/// Destructor of the \see AsyncPrinter class; it waits that the lent generation is printed.
+	~AsyncPrinter();
+
+private:
+	Matrix* m;
+	const int every;
+	const bool text;
+	long dropped;
+	bool stop;
+
+	// Array that the matrix takes in place of the lent one, NULL while the background thread prints a generation.
+	std::atomic<bool*> spare;
+	// Generation lent to the background thread, with its iteration number; NULL once it has been taken.
+	std::atomic<bool*> lent;
+	int lent_iteration;
+	// Lent array that left the matrix, and number of its holders ( the matrix and the background thread ).
+	std::atomic<bool*> retired;
+	std::atomic<int> holders;
+	std::mutex mux;
+	std::condition_variable cv;
+	std::thread writer;
+	TerminalRenderer* terminal;
+
+	/// Release the lent array, on behalf of the matrix or of the background thread: the last holder makes it the spare one.
+	void release();
+
+	/// Body of the background thread: print the lent generations, until the object is destroyed.
+	void write_loop();
+};
+
+#endif /* INCLUDE_ASYNC_PRINTER_HPP_ */
@@ -23,22 +23,44 @@
 #define INCLUDE_BARRIER_HPP_
 
 #include <iostream>
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <climits>
+#if __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif // __linux__
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
 #include "matrix.hpp"
+#include "async_printer.hpp"
+#include "frame_exporter.hpp"
 
-/// This class implements the barrier synchronization model among workers.
+// Number of times a worker checks the barrier before sleeping, when each worker has its own core.
+#define BARRIER_SPIN 2000
+
+/**
+ * This class implements the barrier synchronization model among workers, without locks.
+ * Each worker reads the generation number and increments the counter of the arrived workers:
+ * the last one performs the "global" operations, resets the counter and moves on the generation,
+ * that is the sense of the barrier. The others spin for a while on the generation number
+ * and then sleep on it with a futex, so the kernel is involved only when a worker has to sleep.
+ */
 class Barrier
 {
 public:
 	/**
 	* Initializes a new instance of the \see Barrier class.
 	* When the barrier is reached by all the workers, some "global".
-	* operations are performed on the shared boolean matrix <em>m</em>: print and swap.
-	* @param m		boolean matrix, see \ref Matrix.
-	* @param nw		number of workers.
+	* operations are performed on the shared boolean matrix <em>m</em>: swap and print.
+	* @param m			boolean matrix, see \ref Matrix.
+	* @param nw			number of workers.
+	* @param printer	printer of the matrix, see \ref AsyncPrinter.
+	* @param exporter	exporter of the frames, see \ref FrameExporter, or <code>NULL</code>.
 	*/
-	Barrier( Matrix* m, int nw );
+	Barrier( Matrix* m, int nw, AsyncPrinter* printer, FrameExporter* exporter );
 
 	/**
 	* Apply the barrier, so every thread that will invoke <em>apply</em> will wait
@@ -48,10 +70,17 @@ public:
 	void apply( int iteration_number );
 
 private:
-	int num_workers, completed_workers;
+	const int num_workers;
+	// Number of times a worker checks the barrier before sleeping: zero when the workers share the cores,
+	// since spinning would only steal time from the workers that have not arrived yet.
+	int spin;
 	Matrix* m;
-	std::mutex mux;
-	std::condition_variable cv;
+	AsyncPrinter* printer;
+	FrameExporter* exporter;
+	std::atomic<int> completed_workers, generation, sleeping_workers;
+
+	/// Wait until the generation number is different from <em>current</em>.
+	void wait( int current );
 };
 
 #endif /* INCLUDE_BARRIER_HPP_ */
@@ -0,0 +1,101 @@
+/**
+ *	@file density_pyramid.hpp
+ *  @brief Header of \see DensityPyramid class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/ConnectedComponents
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef INCLUDE_DENSITY_PYRAMID_HPP_
+#define INCLUDE_DENSITY_PYRAMID_HPP_
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+
+// The side of the tiles of the first level is 2^TILE_BITS cells.
+#define TILE_BITS 3
+#define TILE_SIZE (1 << TILE_BITS)
+// Gray level of the blocks with the lowest density.
+#define MIN_GRAY 64
+
+/**
+ * Pyramid of the populations of a boolean matrix: level l holds the number of alive cells of each
+ * block of 2^(TILE_BITS + l) x 2^(TILE_BITS + l) cells, up to the level with a single block.
+ * The pyramid is updated from the tiles that the computation marked as changed ( see \see Matrix::track_tiles ):
+ * only they are counted again, and their difference is added to the blocks that contain them.
+ * An image of any zoom level is drawn reading only the blocks of the visible area.
+ */
+class DensityPyramid
+{
+public:
+	/**
+	 * Initializes a new instance of the \see DensityPyramid class.
+	 * @param height	number of rows of the boolean matrix.
+	 * @param width		number of columns of the boolean matrix.
+	 */
+	DensityPyramid( int height, int width );
+
+	/**
+	 * Update the pyramid with a new generation of the boolean matrix.
+	 * @param cells		first cell of the boolean matrix.
+	 * @param stride	distance between two rows of <em>cells</em>.
+	 * @param changes	bitmap of the tiles of TILE_SIZE x TILE_SIZE cells changed since the previous update, row by row;
+	 * 					it is cleared. All the tiles have to be marked at the first update.
+	 */
+	void update( const bool* cells, size_t stride, std::atomic<uint64_t>* changes );
+
+	/**
+	 * Return the zoom level that shows the whole matrix in an image.
+	 * @param width, height		size of the image, in pixels.
+	 * @return	the zoom level, see \see render.
+	 */
+	int fit( int width, int height ) const;
+
+	/**
+	 * Draw a gray image of an area of the boolean matrix: each pixel is the density of a block of 2^zoom x 2^zoom cells,
+	 * enlarged to pixel_size x pixel_size pixels. The blocks that are not empty are never darker than MIN_GRAY,
+	 * so that sparse patterns remain visible; the pixels outside the matrix are black.
+	 * @param cells, stride		last generation given to \see update.
+	 * @param zoom				zoom level.
+	 * @param pixel_size		side of each block, in pixels.
+	 * @param top, left			cell at the top-left corner of the image; they are aligned to the blocks.
+	 * @param image				image of width * height pixels.
+	 * @param width, height		size of the image, in pixels.
+	 */
+	void render( const bool* cells, size_t stride, int zoom, int pixel_size, long top, long left, unsigned char* image, int width, int height ) const;
+
+private:
+	const int rows, cols;
+	// Populations of the blocks of each level, with the number of blocks of each row.
+	std::vector< std::vector<uint32_t> > counts;
+	std::vector<long> blocks_per_row;
+
+	/**
+	 * Count the alive cells of a block.
+	 * @param cells		first cell of the boolean matrix.
+	 * @param stride	distance between two rows of <em>cells</em>.
+	 * @param i, j		top-left cell of the block.
+	 * @param side		side of the block.
+	 * @return	the number of alive cells.
+	 */
+	uint32_t count( const bool* cells, size_t stride, long i, long j, long side ) const;
+};
+
+#endif /* INCLUDE_DENSITY_PYRAMID_HPP_ */
@@ -0,0 +1,125 @@
+/**
+ *	@file frame_exporter.hpp
+ *  @brief Header of \see FrameExporter class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/ConnectedComponents
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef INCLUDE_FRAME_EXPORTER_HPP_
+#define INCLUDE_FRAME_EXPORTER_HPP_
+
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "matrix.hpp"
+#if OPENCV
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#endif // OPENCV
+
+// Number of snapshots that can wait to be encoded.
+#define EXPORT_QUEUE_SIZE 8
+// Frames per second of the exported videos.
+#define EXPORT_FPS 10
+
+/**
+ * This class exports the iterations of the boolean matrix as frames, without any display.
+ * The format depends on the extension of the path:
+ * 	- .y4m: a single raw YUV4MPEG2 stream ( gray, readable by ffmpeg );
+ * 	- .pgm: a sequence of PGM images;
+ * 	- .png: a sequence of PNG images ( OpenCV2 );
+ * 	- any other extension: a MJPG video ( OpenCV2 ).
+ * The paths of the sequences are obtained adding the iteration number before the extension.
+ * The matrix is copied into one of EXPORT_QUEUE_SIZE snapshot buffers, which are converted into images and
+ * written by the encoder threads; the frames of the streams are written in order. The simulation waits only
+ * when all the buffers are waiting to be encoded.
+ */
+class FrameExporter
+{
+public:
+	/**
+	 * Initializes a new instance of the \see FrameExporter class and starts the encoder threads.
+	 * @param m				boolean matrix, see \ref Matrix.
+	 * @param path			path of the output file.
+	 * @param scale			size of the side of a cell, in pixels.
+	 * @param encoders		number of encoder threads.
+	 */
+	FrameExporter( Matrix* m, const char* path, int scale, int encoders );
+
+	/**
+	 * Export the current configuration of the matrix as a frame.
+	 * It only copies the matrix, waiting only if all the snapshot buffers are in use.
+	 * @param iteration_number	iteration that was completed.
+	 */
+	void publish( int iteration_number );
+
+	/// Destructor of the \see FrameExporter class; it waits that all the frames are written.
+	~FrameExporter();
+
+private:
+	/// Supported formats.
+	enum Format { Y4M, PGM, PNG, VIDEO };
+
+	/// Snapshot waiting to be encoded.
+	struct Frame
+	{
+		long index;
+		int iteration_number;
+		bool* cells;
+	};
+
+	Matrix* m;
+	std::string path;
+	Format format;
+	const int scale, width, height;
+	long published, written;
+	bool stop;
+	FILE* stream;
+#if OPENCV
+	cv::VideoWriter video;
+#endif // OPENCV
+
+	std::vector<bool*> free_buffers;
+	std::deque<Frame> queue;
+	std::mutex mux;
+	std::condition_variable cv_free, cv_queue, cv_turn;
+	std::vector<std::thread> encoders;
+
+	/// Body of the encoder threads: convert the snapshots into images and write them, until the object is destroyed.
+	void encode_loop();
+
+	/**
+	 * Convert a snapshot into a gray image, where each cell is a square of scale pixels.
+	 * @param cells		snapshot of the boolean matrix.
+	 * @param image		image of width * height pixels.
+	 */
+	void render( const bool* cells, unsigned char* image ) const;
+
+	/**
+	 * Write an image as a frame of the output.
+	 * @param iteration_number	iteration of the image.
+	 * @param image				the image.
+	 */
+	void write( int iteration_number, unsigned char* image );
+};
+
+#endif /* INCLUDE_FRAME_EXPORTER_HPP_ */
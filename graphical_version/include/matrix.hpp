@@ -26,9 +26,29 @@
 #include <assert.h>
 #include <fstream>
 #include <climits>
+#include <cstring>
 #include <time.h>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
 
-/// This class is like a boolean matrix.
+// Minimum number of bytes of the input file assigned to each parsing thread.
+#define MIN_PARSE_BYTES (1 << 22)
+
+/**
+ * This class is like a boolean matrix.
+ * As the Grid of the xeon version, each matrix is a single array enlarged with a border,
+ * that contains the cells of the opposite side of the 2D toroidal matrix: in this way
+ * the neighbours of every cell are found at fixed offsets, without modulo operations.
+ */
 class Matrix
 {
 public:
@@ -45,6 +65,8 @@ public:
 	 * Initializes a new instance of the \see Matrix class.
 	 * Set up this matrix using the values written in a text file.
 	 * There are, actually, two matrixes: one used for reading, one used for writing.
+	 * The file is mapped in memory and validated and converted in a single pass,
+	 * splitting its rows among threads on newline boundaries.
 	 * @param input_path	the path of the input file.
 	 */
 	Matrix( const char *input_path );
@@ -75,14 +97,90 @@ public:
 	 * @param j			index of the column to set.
 	 * @param value		value that the element will take.
 	 */
-	virtual void set( int i, int j, bool value );
+	void set( int i, int j, bool value );
 
 	/**
 	 * Count the number of neighbors (the 8 adjacent cells) of a cell matrix set to <code>true</code>.
+	 * The border has to be up to date, see \see copyBorder.
 	 * @param i, j		indexes that identify the cell matrix in which compute this function.
 	 */
 	int countNeighbors( int i, int j ) const;
 
+	/**
+	 * Compute the next generation of the rows [start, end), writing it in the writing boolean matrix.
+	 * The border has to be up to date, see \see copyBorder.
+	 * If the tiles are tracked ( see \see track_tiles ), it also marks those whose cells changed.
+	 * @param start		index of the first row.
+	 * @param end		index of the row after the last one.
+	 */
+	void compute( int start, int end );
+
+	/**
+	 * Start recording which tiles of 2^bits x 2^bits cells are changed by \see compute, in a bitmap with a bit
+	 * for each tile, row by row; at the beginning all the tiles are marked as changed.
+	 * @param bits		logarithm of the side of the tiles.
+	 */
+	void track_tiles( int bits );
+
+	/**
+	 * Return the number of words of the bitmap of the changed tiles, see \see track_tiles.
+	 * @return	the number of words.
+	 */
+	size_t change_words() const;
+
+	/**
+	 * Exchange the bitmap of the changed tiles with a clear one, so that the tiles changed since the previous exchange
+	 * can be read while the next generation is computed. It has to be called between two generations.
+	 * @param clear		bitmap of \see change_words words, all zero, that now belongs to the matrix.
+	 * @return	the bitmap of the tiles changed since the previous exchange, that now belongs to the caller.
+	 */
+	std::atomic<uint64_t>* swap_changes( std::atomic<uint64_t>* clear );
+
+	/// Fill the border of the reading boolean matrix following the logic of the 2D toroidal matrix.
+	void copyBorder();
+
+	/**
+	 * Copy the reading boolean matrix, row by row, into a buffer.
+	 * @param dst		buffer of height() * width() elements.
+	 */
+	void snapshot( bool* dst ) const;
+
+	/**
+	 * Return the number of elements of the reading and writing arrays, border included.
+	 * @return	the size of the buffers given to \see lend.
+	 */
+	size_t buffer_size() const;
+
+	/**
+	 * Return the number of elements between two consecutive rows of the arrays.
+	 * @return	the stride of the rows.
+	 */
+	size_t row_stride() const;
+
+	/**
+	 * Return the first cell of the i-th row of an array of the matrix, as the one returned by \see lend.
+	 * @param buffer	the array.
+	 * @param i			index of the row.
+	 * @return	the pointer to the cell; the next ones of the row follow it.
+	 */
+	const bool* row( const bool* buffer, int i ) const;
+
+	/**
+	 * Lend the reading boolean matrix to a reader, without copying it: the reader can read it while the next
+	 * generation is computed, since it is only read. At the next \see swap the lent array leaves the matrix
+	 * and is replaced by <em>replacement</em>, instead of becoming the writing one; it can be taken back with \see reclaim.
+	 * It has to be called between two generations, after \see copyBorder, and at most once for each generation.
+	 * @param replacement	array of \see buffer_size elements, that now belongs to the matrix.
+	 * @return	the lent array.
+	 */
+	bool* lend( bool* replacement );
+
+	/**
+	 * Take back the array lent by \see lend, if it has left the matrix.
+	 * @return	the array, that now belongs to the caller; <code>NULL</code> if there is none, or if it is still the reading one.
+	 */
+	bool* reclaim();
+
 	/// Print the boolean matrix on the standard output.
 	virtual void print();
 
@@ -96,15 +194,75 @@ protected:
 	int rows, cols;
 
 private:
-	bool **read, **write;
+	bool *read, *write;
+	// Array that replaces the lent one at the next swap, and lent array that left the matrix, not yet reclaimed.
+	bool *replacement, *retired;
+	// Number of elements of a row, border included.
+	size_t stride;
+	// Bitmap of the tiles changed by compute, NULL if they are not tracked, with the side of the tiles and their number per row.
+	std::atomic<uint64_t>* changes;
+	int tile_bits;
+	long tiles_x;
+
+	/**
+	 * Return the position of the i-th row and j-th column in the arrays.
+	 * @param i, j		indexes of the cell matrix.
+	 * @return	the position of the cell matrix.
+	 */
+	inline size_t position( int i, int j ) const
+	{
+		return ( i + 1 ) * this->stride + j + 1;
+	}
+
+	/**
+	 * Compute the next generation of the cells [first, last) of the arrays.
+	 * @param first, last	positions of the cells.
+	 */
+	inline void compute_cells( size_t first, size_t last )
+	{
+		const bool* r = this->read;
+		bool* w = this->write;
+		for ( size_t pos = first, pos_top = first - this->stride, pos_bottom = first + this->stride; pos < last; pos++, pos_top++, pos_bottom++ )
+		{
+			int numNeighbors = r[pos_top - 1] + r[pos_top] + r[pos_top + 1] +
+							   r[pos - 1] + r[pos + 1] +
+							   r[pos_bottom - 1] + r[pos_bottom] + r[pos_bottom + 1];
+			// A cell is alive if it has 3 neighbors, or if it is alive and has 2 neighbors.
+			w[pos] = ( numNeighbors == 3 ) | ( r[pos] & ( numNeighbors == 2 ) );
+		}
+	}
+
+	/**
+	 * Mark the tiles of the i-th row whose cells changed in the new generation.
+	 * @param i		index of the row, already computed.
+	 */
+	void mark_changes( int i );
 
 	/**
 	 * Allocate space in the heap for the reading and writing boolean matrix.
+	 * Each matrix is allocated as a single contiguous buffer, with a border of one cell.
 	 * @param height	number of rows of the boolean matrix.
 	 * @param width		number of columns of the boolean matrix.
 	 */
 	void allocate( int height, int width );
 
+	/**
+	 * Convert a row of '0'/'1' characters into booleans, classifying 16 characters at a time with SSE2.
+	 * @param src		characters of the row.
+	 * @param dst		row of the boolean matrix to fill.
+	 * @param n			number of characters of the row.
+	 * @return	<code>true</code> if all the characters are '0' or '1', <code>false</code> otherwise.
+	 */
+	static bool convert_row( const char* src, bool* dst, size_t n );
+
+	/**
+	 * Find the first error of a malformed input file, print it and terminate the application.
+	 * @param data		content of the input file.
+	 * @param size		size of the content, trailing newlines excluded.
+	 * @param width		number of columns of the first row.
+	 */
+	static void parse_error( const char* data, size_t size, size_t width );
+
 	friend std::ostream& operator<<(std::ostream&, const Matrix&);
 };
 
@@ -23,11 +23,15 @@
 #define INCLUDE_MATRIXG_HPP_
 
 #include <assert.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <X11/Xlib.h>
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include "matrix.hpp"
+#include "density_pyramid.hpp"
 
 // White color.
 #define WHITE 255
@@ -35,8 +39,17 @@
 #define BLACK 0
 // Maximum time waited before showing the next frame.
 #define MAX_DELAY_SCREEN 10000
+// Maximum side of a cell on the screen, in pixels.
+#define MAX_PIXEL_SIZE 64
 
-/// Extension of \see Matrix class that allows to print the boolean matrix in a graphical way, using OpenCV2
+/**
+ * Extension of \see Matrix class that allows to print the boolean matrix in a graphical way, using OpenCV2.
+ * The computing threads only write the cells: \see print lends the last generation, with the tiles changed since
+ * the previous one, to a dedicated thread that turns it into a frame, shows it and adds it to the video.
+ * No copy of the matrix is made: a spare array takes the place of the lent one, which is given back by a later swap.
+ * A matrix larger than the screen is shown through a \ref DensityPyramid, where each pixel is the density
+ * of a block of cells; the keys + and - change the zoom, while w, a, s and d move the view.
+ */
 class MatrixG : public Matrix
 {
 public:
@@ -60,31 +73,57 @@ public:
 	MatrixG( const char* input_path, const char* output_video, int steps );
 
 	/**
-	 * Set the value of the i-th row and j-th column of the boolean matrix and of the screen image.
-	 * @param i			index of the row to set.
-	 * @param j			index of the column to set.
-	 * @param value		value that the element will take.
-	 */
-	void set( int i, int j, bool value ) override;
-
-	/**
-	 * Print the boolean matrix on OpenCV2 windows.
-	 * If <em>write_video</em> is set to <code>true</code>,
-	 * add the current image as a frame of the output video.
+	 * Lend the last generation to the rendering thread, that will show it on OpenCV2 windows.
+	 * It has to be called between two generations: it takes back the array lent at the previous call, if any.
+	 * If <em>write_video</em> is set to <code>true</code>, every generation becomes a frame of the output video,
+	 * so it waits until the rendering thread has finished the previous one; otherwise, the generation is dropped.
 	 */
 	void print() override;
 
-	/// Destructor of the \see MatrixG class.
+	/// Destructor of the \see MatrixG class; it waits that the last generation is rendered.
 	~MatrixG();
 
 private:
 	cv::Mat screen;
 	int pixel_size, screen_rate;
+	// Current view: zoom level ( see \see DensityPyramid::render ), top-left cell and size of the image in pixels.
+	DensityPyramid* pyramid;
+	int zoom, view_width, view_height;
+	long top, left;
 	bool write_video;
 	cv::VideoWriter video;
 
+	// Generation lent to the rendering thread and its changed tiles; the spare array and bitmap take their places.
+	bool *lent, *spare;
+	std::atomic<uint64_t> *lent_changes, *spare_changes;
+	// The lent array becomes spare when both the matrix and the rendering thread have released it.
+	int holders;
+	bool available, stop;
+	std::mutex mux;
+	std::condition_variable cond;
+	std::thread renderer;
+
 	/// Init all the private variables.
 	void init( const char* output_video, int steps );
+
+	/// Release the lent array, with <em>mux</em> held: the last holder makes it the spare one.
+	void release();
+
+	/// Body of the rendering thread: take the lent generations and render them, until the object is destroyed.
+	void render_loop();
+
+	/**
+	 * Turn a generation into the screen image, drawing the current view from the density pyramid, and show it.
+	 * @param cells		array of the generation, see \see Matrix::row.
+	 * @param changes	bitmap of the tiles changed since the previous rendered generation; it is cleared.
+	 */
+	void render( const bool* cells, std::atomic<uint64_t>* changes );
+
+	/**
+	 * Change the view depending on the key pressed by the user: zoom in and out keeping the center of the view, or move it.
+	 * @param key		the pressed key.
+	 */
+	void handle_key( int key );
 };
 
 #endif /* INCLUDE_MATRIXG_HPP_ */
@@ -0,0 +1,80 @@
+/**
+ *	@file terminal_renderer.hpp
+ *  @brief Header of \see TerminalRenderer class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/ConnectedComponents
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+
+#ifndef INCLUDE_TERMINAL_RENDERER_HPP_
+#define INCLUDE_TERMINAL_RENDERER_HPP_
+
+#include <string>
+#include <vector>
+#include "fco.hpp"
+
+// Cells of the matrix drawn by a single Braille character: 4 rows and 2 columns.
+#define GLYPH_ROWS 4
+#define GLYPH_COLS 2
+// Unchanged characters between two changed ones that are written again instead of moving the cursor.
+#define MAX_GLYPH_GAP 2
+
+/**
+ * This class draws the boolean matrix on a terminal that supports ANSI escape sequences and UTF-8.
+ * Each block of 4x2 cells is a Braille character, whose dots are the alive cells, so the matrix
+ * needs height / 4 rows and width / 2 columns of the terminal.
+ * Only the characters that changed since the previous frame are written, each run preceded by
+ * a cursor movement: the output grows with the activity of the matrix instead of its size.
+ */
+class TerminalRenderer
+{
+public:
+	/**
+	 * Initializes a new instance of the \see TerminalRenderer class.
+	 * @param height	number of rows of the boolean matrix.
+	 * @param width		number of columns of the boolean matrix.
+	 */
+	TerminalRenderer( int height, int width );
+
+	/**
+	 * Build the escape sequences that update the terminal from the previous frame to the given snapshot.
+	 * The first frame also clears the terminal. The cursor is left on the line below the status line.
+	 * @param cells				snapshot of the boolean matrix, row by row.
+	 * @param stride			number of elements between two consecutive rows of the snapshot.
+	 * @param iteration_number	iteration of the snapshot, shown in the status line.
+	 * @param out				string where the output is written.
+	 */
+	void draw( const bool* cells, size_t stride, int iteration_number, std::string& out );
+
+private:
+	const int rows, cols, glyph_rows, glyph_cols;
+	// Dots of the characters on the terminal and of those of the new frame.
+	std::vector<unsigned char> shown, current;
+	bool cleared;
+	fco::FCO style, status;
+
+	/**
+	 * Compute the dots of a character.
+	 * @param cells		snapshot of the boolean matrix.
+	 * @param stride	number of elements between two consecutive rows of the snapshot.
+	 * @param gi, gj	position of the character.
+	 * @return	the dots: bit k is the dot k + 1 of the Braille pattern.
+	 */
+	unsigned char dots( const bool* cells, size_t stride, int gi, int gj ) const;
+};
+
+#endif /* INCLUDE_TERMINAL_RENDERER_HPP_ */
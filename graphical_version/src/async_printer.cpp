@@ -0,0 +1,147 @@
+/**
+ *	@file async_printer.cpp
+ *  @brief Implementation of \see AsyncPrinter class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/ConnectedComponents
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "async_printer.hpp"
+
+AsyncPrinter::AsyncPrinter( Matrix* m, int every, bool text, bool terminal ) : every( std::max( every, 1 ) ), text( text )
+{
+	this->m = m;
+	this->terminal = ( text && terminal ) ? new TerminalRenderer( m->height(), m->width() ) : NULL;
+	this->dropped = 0;
+	this->stop = false;
+	this->spare = NULL;
+	this->lent = NULL;
+	this->lent_iteration = 0;
+	this->retired = NULL;
+	this->holders = 0;
+
+	if ( this->text )
+	{
+		this->spare = new bool[m->buffer_size()];
+		this->writer = std::thread( &AsyncPrinter::write_loop, this );
+	}
+}
+
+void AsyncPrinter::publish( int iteration_number )
+{
+	if ( !this->text )
+	{
+		if ( iteration_number % this->every != 0 ) return;
+		this->m->print();
+		std::cout << "Iteration " << iteration_number << " completed !!!" << std::endl;
+		return;
+	}
+
+	// The generation lent at the previous publication left the matrix with the last swap.
+	bool* buffer = this->m->reclaim();
+	if ( buffer != NULL )
+	{
+		this->retired.store( buffer );
+		this->release();
+	}
+	if ( iteration_number % this->every != 0 ) return;
+
+	// Without the spare array the writer is still printing the previous generation: drop this one.
+	bool* replacement = this->spare.exchange( NULL );
+	if ( replacement == NULL )
+	{
+		this->dropped++;
+		return;
+	}
+	this->holders.store( 2 );
+	this->lent_iteration = iteration_number;
+	this->lent.store( this->m->lend( replacement ) );
+
+	// The lock only orders the notification with the wait of the writer, which may be going to sleep.
+	{
+		std::lock_guard<std::mutex> lock( this->mux );
+	}
+	this->cv.notify_one();
+}
+
+void AsyncPrinter::release()
+{
+	if ( this->holders.fetch_sub( 1 ) == 1 )
+		this->spare.store( this->retired.exchange( NULL ) );
+}
+
+void AsyncPrinter::write_loop()
+{
+	int rows = this->m->height(), cols = this->m->width();
+	std::string header = "MATRIX (rows: " + std::to_string( rows ) + ", columns: " + std::to_string( cols ) + ") :\n";
+	std::string out( (size_t) rows * ( cols + 1 ), '\n' ), frame;
+
+	while ( true )
+	{
+		bool* cells;
+		{
+			std::unique_lock<std::mutex> lock( this->mux );
+			this->cv.wait( lock, [this]{ return this->lent.load() != NULL || this->stop; } );
+			cells = this->lent.exchange( NULL );
+			if ( cells == NULL ) break;
+		}
+		int iteration_number = this->lent_iteration;
+
+		// The lent array is only read, as by the workers that compute the next generation, then it is released before the output.
+		if ( this->terminal != NULL )
+		{
+			// Only the characters that changed since the last frame drawn.
+			this->terminal->draw( this->m->row( cells, 0 ), this->m->row_stride(), iteration_number, frame );
+			this->release();
+			std::cout.write( frame.data(), frame.size() );
+			std::cout.flush();
+		}
+		else
+		{
+			// Convert the whole matrix into text, then write it at once.
+			for ( int i = 0; i < rows; i++ )
+			{
+				char* line = &out[(size_t) i * ( cols + 1 )];
+				const bool* row = this->m->row( cells, i );
+				for ( int j = 0; j < cols; j++ )
+					line[j] = (char) ( '0' + row[j] );
+			}
+			this->release();
+			std::cout << header;
+			std::cout.write( out.data(), out.size() );
+			std::cout << "Iteration " << iteration_number << " completed !!!" << std::endl;
+		}
+	}
+}
+
+AsyncPrinter::~AsyncPrinter()
+{
+	if ( !this->text ) return;
+
+	// Let the writer print the lent generation and terminate.
+	{
+		std::lock_guard<std::mutex> lock( this->mux );
+		this->stop = true;
+		this->cv.notify_one();
+	}
+	this->writer.join();
+	if ( this->dropped > 0 )
+		std::cout << "Printer was late: " << this->dropped << " iterations were not printed." << std::endl;
+
+	// The last lent array, and the array that replaces it, still belong to the matrix.
+	delete[] this->spare.load();
+	delete this->terminal;
+}
@@ -21,33 +21,66 @@
 
 #include "barrier.hpp"
 
-Barrier::Barrier( Matrix* m, int nw )
+Barrier::Barrier( Matrix* m, int nw, AsyncPrinter* printer, FrameExporter* exporter ) : num_workers( nw )
 {
 	this->m = m;
-	this->num_workers = nw;
+	this->printer = printer;
+	this->exporter = exporter;
 	this->completed_workers = 0;
+	this->generation = 0;
+	this->sleeping_workers = 0;
+	this->spin = ( (unsigned int) nw <= std::thread::hardware_concurrency() ) ? BARRIER_SPIN : 0;
 }
 
 void Barrier::apply( int iteration_number )
 {
-	std::unique_lock<std::mutex> lock(this->mux);
-	this->completed_workers++;
+	// The generation cannot move on before this worker arrives, so it has to be read before.
+	int current = this->generation.load();
 
-	if ( this->completed_workers == this->num_workers )
+	if ( this->completed_workers.fetch_add( 1 ) + 1 == this->num_workers )
 	{
 		// It is the last worker that finished the computation.
 		// Reset the number of completed workers.
-		this->completed_workers = 0;
-		// Swap the reading and writing matrixes.
+		this->completed_workers.store( 0, std::memory_order_relaxed );
+		// Swap the reading and writing matrixes and fill the border of the new reading one.
 		this->m->swap();
-		// Print the result of the Game of Life iteration.
-		this->m->print();
-		// Print the iteration number that was completed by the worker.
-		std::cout << "Iteration " << iteration_number << " completed !!!" << std::endl;
-		// Notify all the workers about the end of the iteration.
-		this->cv.notify_all();
+		this->m->copyBorder();
+		// Hand the result of the Game of Life iteration to the printer, without waiting for the output.
+		this->printer->publish( iteration_number );
+		if ( this->exporter != NULL )
+			this->exporter->publish( iteration_number );
+		// Notify all the workers about the end of the iteration, waking up those that are sleeping.
+		this->generation.fetch_add( 1 );
+#if __linux__
+		if ( this->sleeping_workers.load() > 0 )
+			syscall( SYS_futex, (int*) &this->generation, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0 );
+#endif // __linux__
 	}
 	else
 		// Wait that all the workers finish this iteration.
-    	this->cv.wait(lock);
+		this->wait( current );
+}
+
+void Barrier::wait( int current )
+{
+	for ( int s = 0; s < this->spin; s++ )
+	{
+		if ( this->generation.load( std::memory_order_acquire ) != current ) return;
+#if __SSE2__
+		_mm_pause();
+#endif // __SSE2__
+	}
+
+	// The generation is checked again after announcing the sleep, so the last worker cannot miss this one:
+	// the futex sleeps only if the generation is still the current one.
+	this->sleeping_workers.fetch_add( 1 );
+	while ( this->generation.load() == current )
+	{
+#if __linux__
+		syscall( SYS_futex, (int*) &this->generation, FUTEX_WAIT_PRIVATE, current, NULL, NULL, 0 );
+#else
+		std::this_thread::yield();
+#endif // __linux__
+	}
+	this->sleeping_workers.fetch_sub( 1 );
 }
@@ -0,0 +1,120 @@
+/**
+ *	@file density_pyramid.cpp
+ *  @brief Implementation of \see DensityPyramid class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/ConnectedComponents
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "density_pyramid.hpp"
+
+DensityPyramid::DensityPyramid( int height, int width ) : rows( height ), cols( width )
+{
+	// Add levels until a single block covers the whole matrix.
+	for ( long side = TILE_SIZE; ; side *= 2 )
+	{
+		long bx = ( this->cols + side - 1 ) / side, by = ( this->rows + side - 1 ) / side;
+		this->counts.push_back( std::vector<uint32_t>( bx * by, 0 ) );
+		this->blocks_per_row.push_back( bx );
+		if ( bx == 1 && by == 1 ) break;
+	}
+}
+
+uint32_t DensityPyramid::count( const bool* cells, size_t stride, long i, long j, long side ) const
+{
+	uint32_t c = 0;
+	long last_i = std::min( i + side, (long) this->rows ), last_j = std::min( j + side, (long) this->cols );
+	for ( long r = i; r < last_i; r++ )
+	{
+		const bool* row = cells + r * stride;
+		for ( long k = j; k < last_j; k++ )
+			c += row[k];
+	}
+	return c;
+}
+
+void DensityPyramid::update( const bool* cells, size_t stride, std::atomic<uint64_t>* changes )
+{
+	long tiles_x = this->blocks_per_row[0], tiles = (long) this->counts[0].size();
+	size_t levels = this->counts.size();
+
+	for ( long w = 0; w < ( tiles + 63 ) / 64; w++ )
+	{
+		uint64_t bits = changes[w].load( std::memory_order_relaxed );
+		if ( bits == 0 ) continue;
+		changes[w].store( 0, std::memory_order_relaxed );
+		// The bits after the last tile are ignored.
+		for ( ; bits != 0; bits &= bits - 1 )
+		{
+			long tile = w * 64 + __builtin_ctzll( bits ), ty = tile / tiles_x, tx = tile % tiles_x;
+			if ( tile >= tiles ) break;
+
+			// Add the difference to the tile and to all the blocks that contain it.
+			uint32_t c = this->count( cells, stride, ty * TILE_SIZE, tx * TILE_SIZE, TILE_SIZE ), delta = c - this->counts[0][tile];
+			this->counts[0][tile] = c;
+			for ( size_t l = 1; l < levels; l++ )
+				this->counts[l][( ty >> l ) * this->blocks_per_row[l] + ( tx >> l )] += delta;
+		}
+	}
+}
+
+int DensityPyramid::fit( int width, int height ) const
+{
+	int zoom = 0;
+	while ( ( ( this->cols - 1 ) >> zoom ) + 1 > width || ( ( this->rows - 1 ) >> zoom ) + 1 > height )
+		zoom++;
+	return zoom;
+}
+
+void DensityPyramid::render( const bool* cells, size_t stride, int zoom, int pixel_size, long top, long left, unsigned char* image, int width, int height ) const
+{
+	long side = 1L << zoom;
+	top = top / side * side;
+	left = left / side * side;
+
+	for ( int py = 0; py < height; py++ )
+	{
+		unsigned char* line = image + (size_t) py * width;
+		// The rows of pixels of the same block are equal.
+		if ( py % pixel_size != 0 )
+		{
+			std::copy( line - width, line, line );
+			continue;
+		}
+
+		long i = top + ( py / pixel_size ) * side;
+		for ( int px = 0, bx = 0; px < width; px += pixel_size, bx++ )
+		{
+			long j = left + bx * side;
+			unsigned char value = 0;
+			if ( i < this->rows && j < this->cols )
+			{
+				if ( zoom == 0 ) value = cells[i * stride + j] ? 255 : 0;
+				else
+				{
+					// The small blocks are counted on the snapshot, the others are read from the pyramid;
+					// above the last level, the only block is the whole matrix.
+					size_t l = std::min( (size_t) std::max( zoom - TILE_BITS, 0 ), this->counts.size() - 1 );
+					uint64_t c = ( zoom < TILE_BITS ) ? this->count( cells, stride, i, j, side )
+								: this->counts[l][( i >> zoom ) * this->blocks_per_row[l] + ( j >> zoom )];
+					if ( c > 0 )
+						value = (unsigned char) std::max( (uint64_t) MIN_GRAY, ( c * 255 ) >> ( 2 * zoom ) );
+				}
+			}
+			std::fill( line + px, line + std::min( px + pixel_size, width ), value );
+		}
+	}
+}
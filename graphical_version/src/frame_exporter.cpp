@@ -0,0 +1,217 @@
+/**
+ *	@file frame_exporter.cpp
+ *  @brief Implementation of \see FrameExporter class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/ConnectedComponents
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "frame_exporter.hpp"
+
+FrameExporter::FrameExporter( Matrix* m, const char* path, int scale, int encoders )
+	: scale( std::max( scale, 1 ) ), width( m->width() * std::max( scale, 1 ) ), height( m->height() * std::max( scale, 1 ) )
+{
+	this->m = m;
+	this->path = path;
+	this->published = 0;
+	this->written = 0;
+	this->stop = false;
+	this->stream = NULL;
+
+	// Choose the format depending on the extension.
+	size_t dot = this->path.rfind( '.' );
+	std::string extension = ( dot == std::string::npos ) ? "" : this->path.substr( dot );
+	if ( extension == ".y4m" ) this->format = Y4M;
+	else if ( extension == ".pgm" ) this->format = PGM;
+	else if ( extension == ".png" ) this->format = PNG;
+	else this->format = VIDEO;
+
+#if !OPENCV
+	if ( this->format == PNG || this->format == VIDEO )
+	{
+		std::cerr << "Error: only .y4m and .pgm frames can be exported without OpenCV2." << std::endl;
+		exit( 1 );
+	}
+#endif // OPENCV
+
+	if ( this->format == Y4M )
+	{
+		this->stream = fopen( path, "wb" );
+		if ( this->stream == NULL )
+		{
+			std::cerr << "Error: it is not possible to create the file " << path << "." << std::endl;
+			exit( 1 );
+		}
+		fprintf( this->stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 Cmono\n", this->width, this->height, EXPORT_FPS );
+	}
+#if OPENCV
+	if ( this->format == VIDEO )
+	{
+		this->video.open( this->path, CV_FOURCC( 'M','J','P','G' ), EXPORT_FPS, cv::Size( this->width, this->height ), false );
+		if ( !this->video.isOpened() )
+		{
+			std::cerr << "Error: it is not possible to create the video " << path << "." << std::endl;
+			exit( 1 );
+		}
+	}
+#endif // OPENCV
+
+	size_t n = (size_t) m->height() * m->width();
+	for ( int b = 0; b < EXPORT_QUEUE_SIZE; b++ )
+		this->free_buffers.push_back( new bool[n] );
+	for ( int t = 0; t < std::max( encoders, 1 ); t++ )
+		this->encoders.push_back( std::thread( &FrameExporter::encode_loop, this ) );
+}
+
+void FrameExporter::publish( int iteration_number )
+{
+	// Take a free buffer, waiting only if all of them are waiting to be encoded.
+	bool* buffer;
+	{
+		std::unique_lock<std::mutex> lock( this->mux );
+		this->cv_free.wait( lock, [this]{ return !this->free_buffers.empty(); } );
+		buffer = this->free_buffers.back();
+		this->free_buffers.pop_back();
+	}
+
+	// The buffer belongs to this thread until it is queued, so the copy is made outside the lock.
+	this->m->snapshot( buffer );
+
+	std::lock_guard<std::mutex> lock( this->mux );
+	Frame f = { this->published++, iteration_number, buffer };
+	this->queue.push_back( f );
+	this->cv_queue.notify_one();
+}
+
+void FrameExporter::encode_loop()
+{
+	std::vector<unsigned char> image( (size_t) this->width * this->height );
+	bool ordered = ( this->format == Y4M || this->format == VIDEO );
+
+	while ( true )
+	{
+		Frame f;
+		{
+			std::unique_lock<std::mutex> lock( this->mux );
+			this->cv_queue.wait( lock, [this]{ return !this->queue.empty() || this->stop; } );
+			if ( this->queue.empty() ) break;
+			f = this->queue.front();
+			this->queue.pop_front();
+		}
+
+		this->render( f.cells, image.data() );
+		{
+			std::lock_guard<std::mutex> lock( this->mux );
+			this->free_buffers.push_back( f.cells );
+			this->cv_free.notify_one();
+		}
+
+		// The frames of a stream are written in order: the frames are taken in order from the queue,
+		// so the one that has to be written next is always held by an encoder.
+		if ( ordered )
+		{
+			std::unique_lock<std::mutex> lock( this->mux );
+			this->cv_turn.wait( lock, [this, &f]{ return this->written == f.index; } );
+		}
+		this->write( f.iteration_number, image.data() );
+		if ( ordered )
+		{
+			std::lock_guard<std::mutex> lock( this->mux );
+			this->written++;
+			this->cv_turn.notify_all();
+		}
+	}
+}
+
+void FrameExporter::render( const bool* cells, unsigned char* image ) const
+{
+	int cols = this->m->width(), rows = this->m->height();
+	for ( int i = 0; i < rows; i++ )
+	{
+		// Enlarge the cells of the row, then replicate the row scale times.
+		unsigned char* line = image + (size_t) i * this->scale * this->width;
+		const bool* row = cells + (size_t) i * cols;
+		for ( int j = 0; j < cols; j++ )
+			std::fill( line + j * this->scale, line + ( j + 1 ) * this->scale, (unsigned char) ( row[j] ? 255 : 0 ) );
+		for ( int r = 1; r < this->scale; r++ )
+			std::copy( line, line + this->width, line + (size_t) r * this->width );
+	}
+}
+
+void FrameExporter::write( int iteration_number, unsigned char* image )
+{
+	size_t size = (size_t) this->width * this->height;
+	if ( this->format == Y4M )
+	{
+		fputs( "FRAME\n", this->stream );
+		fwrite( image, 1, size, this->stream );
+		return;
+	}
+#if OPENCV
+	cv::Mat frame( this->height, this->width, CV_8UC1, image );
+	if ( this->format == VIDEO )
+	{
+		this->video << frame;
+		return;
+	}
+#endif // OPENCV
+
+	// Sequence of images: add the iteration number before the extension.
+	char number[16];
+	sprintf( number, "_%06d", iteration_number );
+	size_t dot = this->path.rfind( '.' );
+	std::string file_path = this->path.substr( 0, dot ) + number + this->path.substr( dot );
+	bool ok = false;
+	if ( this->format == PGM )
+	{
+		FILE* f = fopen( file_path.c_str(), "wb" );
+		if ( f != NULL )
+		{
+			fprintf( f, "P5\n%d %d\n255\n", this->width, this->height );
+			ok = ( fwrite( image, 1, size, f ) == size );
+			ok = ( fclose( f ) == 0 ) && ok;
+		}
+	}
+#if OPENCV
+	else ok = cv::imwrite( file_path, frame );
+#endif // OPENCV
+	if ( !ok )
+	{
+		std::cerr << "Error: it is not possible to write the frame " << file_path << "." << std::endl;
+		exit( 1 );
+	}
+}
+
+FrameExporter::~FrameExporter()
+{
+	// Let the encoders write the frames in the queue and terminate.
+	{
+		std::lock_guard<std::mutex> lock( this->mux );
+		this->stop = true;
+		this->cv_queue.notify_all();
+	}
+	for ( size_t t = 0; t < this->encoders.size(); t++ )
+		this->encoders[t].join();
+
+	if ( this->stream != NULL ) fclose( this->stream );
+#if OPENCV
+	this->video.release();
+#endif // OPENCV
+	std::cout << "Exported " << this->published << " frames to " << this->path << "." << std::endl;
+
+	for ( size_t b = 0; b < this->free_buffers.size(); b++ )
+		delete[] this->free_buffers[b];
+}
@@ -31,6 +31,8 @@
 #include "program_options.hpp"
 #include "matrix.hpp"
 #include "barrier.hpp"
+#include "async_printer.hpp"
+#include "frame_exporter.hpp"
 
 #if OPENCV
 #include "matrixG.hpp"
@@ -63,28 +65,7 @@ void compute( int id, Barrier* barrier, Matrix* m, int start, int end, int steps
 
 	for ( int k = 1; k <= steps; k++ )
 	{
-		for ( int i = start; i < end; i++ )
-		{
-			for ( int j = 0; j < m->width(); j++ )
-			{
-				int numNeighbors = m->countNeighbors(i, j);
-
-                // Alive Cell
-                if ( m->get(i, j) )
-                {
-					if (numNeighbors < 2) m->set(i, j, false); // Cell dies since is alone
-					else if (numNeighbors == 2 || numNeighbors == 3) m->set(i, j, true); // Cell stays alive
-					else m->set(i, j, false); // Cell dies for starvation
-				}
-                // Empty Cell
-                else
-                {
-					if (numNeighbors == 3) m->set(i, j, true); // A new cell is born
-					else m->set(i, j, false);
-                }
-			}
-		}
-
+		m->compute( start, end );
 		barrier->apply( k );
 	}
 }
@@ -103,15 +84,20 @@ int main( int argc, char** argv )
 		std::cout << "Usage: " << argv[0] << " [options] " << std::endl;
 		std::cout << "Possible options:" << std::endl;
 		std::cout << "\t -w " << num << ", --width " << num << " \t width of the matrix" << std::endl;
-		std::cout << "\t\t\t\t The maximum width has to be equal to the number of pixels of the screen width ;" << std::endl;
 		std::cout << "\t -h " << num << ", --height " << num << " \t height of the matrix" << std::endl;
-		std::cout << "\t\t\t\t The maximum height has to be equal to the number of pixels of the screen height ;" << std::endl;
 		std::cout << "\t -i " << file << ", --input " << file << " \t file where to retrieve the matrix" << std::endl;
 		std::cout << "\t\t\t\t --width and --height options will be ignored ; " << std::endl;
 		std::cout << "\t -s " << num << ", --steps " << num << " \t number of steps ;" << std::endl;
 		std::cout << "\t -t " << num << ", --thread " << num << " \t number of threads ;" << std::endl;
+		std::cout << "\t --print-every " << num << " \t print one iteration every " << num << " ( default 1 ) ;" << std::endl;
+		std::cout << "\t --terminal \t\t draw the matrix on the terminal, updating only what changed ;" << std::endl;
+		std::cout << "\t -e " << file << ", --export " << file << "  export every iteration as a frame, without display" << std::endl;
+		std::cout << "\t\t\t\t .y4m stream, .pgm or .png sequence, or video ; " << std::endl;
+		std::cout << "\t --scale " << num << " \t\t pixels of the side of a cell in the exported frames ( default 1 ) ;" << std::endl;
+		std::cout << "\t --encoders " << num << " \t threads that encode the exported frames ( default 2 ) ;" << std::endl;
 #if OPENCV
 		std::cout << "\t -g, --graphic \t\t activate the graphic mode ;" << std::endl;
+		std::cout << "\t\t\t\t + and - zoom, w, a, s and d move the view ; " << std::endl;
 		std::cout << "\t -o " << file << ", --output " << file << "  file where to save the generated video" << std::endl;
 		std::cout << "\t\t\t\t if not present, the video will be only displayed and not saved ; " << std::endl;
 #endif // OPENCV
@@ -125,6 +111,7 @@ int main( int argc, char** argv )
 	int height = po.get_int( "-h", "--height", 100 );
 	int steps = po.get_int( "-s", "--steps", 100 );
 	int nw = std::max( po.get_int( "-t", "--thread", std::thread::hardware_concurrency() ), 1 );
+	int print_every = po.get_int( "--print-every", 1 );
 	assert ( width > 0 && height > 0 && steps > 0 );
 	std::cout << "NUMBER OF CHOSEN THREADS = " << nw << " !!!" << std::endl;
 
@@ -154,13 +141,27 @@ int main( int argc, char** argv )
 #endif  // OPENCV
 
 	// Print initial configuration
-	m->print();
+#if OPENCV
+	bool text = !po.exists( "-g", "--graphic" );
+#else
+	bool text = true;
+#endif  // OPENCV
+	bool terminal = text && po.exists( "--terminal" );
+	if ( !terminal ) m->print();
+	AsyncPrinter* printer = new AsyncPrinter( m, print_every, text, terminal );
+	if ( terminal ) printer->publish( 0 );
+	FrameExporter* exporter = NULL;
+	if ( po.exists( "-e", "--export" ) )
+	{
+		exporter = new FrameExporter( m, po.get( "-e", "--export" ), po.get_int( "--scale", 1 ), po.get_int( "--encoders", 2 ) );
+		exporter->publish( 0 );
+	}
 
 	// Start the Game of Life
 	t1 = high_resolution_clock::now();
 	if (nw > 1)
 	{
-		Barrier* barrier = new Barrier( m, nw );
+		Barrier* barrier = new Barrier( m, nw, printer, exporter );
 		std::vector<std::thread> tid;
 
 		// Create and start the workers
@@ -181,12 +182,17 @@ int main( int argc, char** argv )
 	else
 	{
 		// Sequential version
-		Barrier* barrier = new Barrier( m, 1 );
+		Barrier* barrier = new Barrier( m, 1, printer, exporter );
 		compute( 1, barrier, m, 0, height, steps );
 	}
 	t2 = high_resolution_clock::now();
+	// Wait that the iterations still in the queue are printed.
+	delete printer;
+	delete exporter;
 	printTime( t1, t2, "complete Game of Life" );
 
+	// The graphical matrix waits that the last frame is rendered.
+	delete m;
 	return 0;
 }
 
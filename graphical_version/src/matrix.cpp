@@ -28,6 +28,12 @@ Matrix::Matrix( int height, int width )
 	this->rows = 0;
 	this->read = NULL;
 	this->write = NULL;
+	this->replacement = NULL;
+	this->retired = NULL;
+	this->stride = 0;
+	this->changes = NULL;
+	this->tile_bits = 0;
+	this->tiles_x = 0;
 
 	// Allocate the two matrixes
 	this->allocate( height, width );
@@ -38,99 +44,90 @@ Matrix::Matrix( int height, int width )
 	// Fill the matrix width random values
 	for (int i = 0; i < this->rows; i++)
 		for (int j = 0; j < this->cols; j++)
-			this->read[i][j] = (rand() % 100 + 1 > 50);
+			this->read[this->position( i, j )] = (rand() % 100 + 1 > 50);
+	this->copyBorder();
 }
 
 Matrix::Matrix( const char *input_path )
 {
-	std::ifstream f;
-
 	// Initialize private variables
 	this->cols = 0;
 	this->rows = 0;
 	this->read = NULL;
 	this->write = NULL;
-
-	// Starting matrix dimension
-	int width = 0, height = 1;
-
-	// Open the input file
-	f.open(input_path, std::ios::in);
-	if ( f.fail() )
+	this->replacement = NULL;
+	this->retired = NULL;
+	this->stride = 0;
+	this->changes = NULL;
+	this->tile_bits = 0;
+	this->tiles_x = 0;
+
+	// Open the input file and map it in memory
+	int fd = open( input_path, O_RDONLY );
+	struct stat st;
+	if ( fd < 0 || fstat( fd, &st ) != 0 )
 	{
 		std::cerr << "Error: it is not possible to open the file." << std::endl;
 		exit( 1 );
 	}
-	if ( f.peek() == EOF )
+	size_t size = (size_t) st.st_size;
+	if ( size == 0 )
 	{
 		std::cerr << "Error: the file is empty." << std::endl;
 		exit( 1 );
 	}
-
-	// Ignore until newline character
-	f.ignore( INT_MAX, '\n' );
-	// Count columns in first row
-	width = f.gcount() - 1;
-
-	// Consume ENTER if present
-    if ( f.peek() == 10 )
-		f.get();
-
-	while( !f.eof() && ( f.peek() != EOF) )
+	const char* data = (const char*) mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	if ( data == MAP_FAILED )
 	{
-		int cur_width;
-		// Start a new line
-		height++;
-		// Ignore until newline character
-		f.ignore( INT_MAX, '\n' );
-		// Count columns in current row
-		cur_width = f.gcount() - ( f.eof() ? 0 : 1 );
-
-		if ( cur_width != width )
-		{
-			std::cerr << "Error: number of columns at row n." << height << " (" << cur_width << " columns) ";
-			std::cerr << "is not equal to that of first row." << std::endl;
-			exit(1);
-		}
-
-		// Consume ENTER if present
-		if ( f.peek() == 10 )
-			f.get();
+		std::cerr << "Error: it is not possible to map the file in memory." << std::endl;
+		exit( 1 );
 	}
+	madvise( (void*) data, size, MADV_SEQUENTIAL );
 
-	// Allocate space for the matrix
-	this->allocate( height, width );
+	// Ignore the trailing newline characters
+	size_t end = size;
+	while ( end > 0 && data[end - 1] == '\n' )
+		end--;
 
-	// Restart reading file from beginning
-	f.seekg( 0, f.beg );
+	// The first row defines the number of columns: every row is made of width characters followed by a newline,
+	// so the file has to contain exactly height rows of (width + 1) characters, the last newline excluded.
+	const char* nl = (const char*) memchr( data, '\n', end );
+	size_t width = ( nl == NULL ) ? end : (size_t) ( nl - data ), stride = width + 1;
+	if ( width == 0 || ( end + 1 ) % stride != 0 || ( end + 1 ) / stride > INT_MAX || width > INT_MAX )
+		Matrix::parse_error( data, end, width );
+	int height = (int) ( ( end + 1 ) / stride );
 
-	// Fill the matrix
-	for ( int i = 0; i < this->rows; i++ )
+	// Allocate space for the matrix
+	this->allocate( height, (int) width );
+
+	// Validate and convert the rows in one pass, splitting them among threads on newline boundaries.
+	std::atomic<bool> valid( true );
+	int nt = (int) std::min( (size_t) std::max( std::thread::hardware_concurrency(), 1u ), std::max( end / MIN_PARSE_BYTES, (size_t) 1 ) );
+	nt = std::min( nt, height );
+	std::vector<std::thread> tid;
+	for ( int t = 0; t < nt; t++ )
 	{
-		for ( int j = 0; j < this->cols; j++ )
+		int first = (int) ( (long long) height * t / nt ), last = (int) ( (long long) height * (t + 1) / nt );
+		tid.push_back( std::thread( [=, &valid]
 		{
-            char tmp;
-            f.read( &tmp, sizeof(char) );
-            switch ( tmp )
-            {
-				case '0': this->read[i][j] = false; break;
-				case '1': this->read[i][j] = true; break;
-				case '\n': j--; break;
-				default:
-					std::cerr << "Error parsing file at line "<< i << " and column "<< j << ". ";
-					std::cerr << "Read " << tmp << " instead of 0, 1 or \\n. ";
-					std::cerr << "The matrix has to be composed of 0 and 1 only." << std::endl;
-					std::cerr << "Example : "  << std::endl;
-					std::cerr << "\t100\\n" << std::endl;
-					std::cerr << "\t010\\n" << std::endl;
-					std::cerr << "\t001\\n" << std::endl << std::endl;
-					exit( 1 );
-					break;
-            }
-		}
+			bool ok = true;
+			for ( int i = first; i < last && ok; i++ )
+			{
+				const char* line = data + i * stride;
+				ok = Matrix::convert_row( line, this->read + this->position( i, 0 ), width ) && ( i == height - 1 || line[width] == '\n' );
+			}
+			if ( !ok ) valid.store( false );
+		} ) );
 	}
+	for ( int t = 0; t < nt; t++ )
+		tid[t].join();
 
-	f.close();
+	if ( !valid.load() )
+		Matrix::parse_error( data, end, width );
+
+	munmap( (void*) data, size );
+	close( fd );
+	this->copyBorder();
 }
 
 int Matrix::width() const
@@ -147,41 +144,150 @@ bool Matrix::get( int i, int j ) const
 {
 	assert ( (i >= 0) && (j >= 0) && (i < this->rows) && (j < this->cols) );
 
-	return this->read[i][j];
+	return this->read[this->position( i, j )];
 }
 
 void Matrix::set( int i, int j, bool value )
 {
 	assert ( (i >= 0) && (j >= 0) && (i < this->rows) && (j < this->cols) );
 
-	this->write[i][j] = value;
+	this->write[this->position( i, j )] = value;
 }
 
 int Matrix::countNeighbors( int i, int j ) const
 {
 	assert ( (i >= 0) && (j >= 0) && (i < this->rows) && (j < this->cols) );
 
-    int c = 0;
+	size_t pos = this->position( i, j ), pos_top = pos - this->stride, pos_bottom = pos + this->stride;
+	return this->read[pos_top - 1] + this->read[pos_top] + this->read[pos_top + 1] +
+		   this->read[pos - 1] + this->read[pos + 1] +
+		   this->read[pos_bottom - 1] + this->read[pos_bottom] + this->read[pos_bottom + 1];
+}
 
-	c += this->read[(i + this->rows - 1) % this->rows][(j + this->cols - 1) % this->cols];
-	c += this->read[(i + this->rows - 1) % this->rows][j];
-	c += this->read[(i + this->rows - 1) % this->rows][(j + 1) % this->cols];
+void Matrix::compute( int start, int end )
+{
+	assert ( (start >= 0) && (start <= end) && (end <= this->rows) );
 
-	c += this->read[i][(j + this->cols - 1) % this->cols];
-	c += this->read[i][(j + 1) % this->cols];
+	if ( start == end ) return;
+	if ( this->changes == NULL )
+	{
+		// The rows are visited as a single range, border columns included: their values are garbage,
+		// but they are rewritten by copyBorder before being read.
+		this->compute_cells( this->position( start, 0 ), this->position( end - 1, this->cols - 1 ) + 1 );
+		return;
+	}
 
-	c += this->read[(i + 1) % this->rows][(j + this->cols - 1) % this->cols];
-	c += this->read[(i + 1) % this->rows][j];
-	c += this->read[(i + 1) % this->rows][(j + 1) % this->cols];
+	// Row by row, so that the changed tiles are found while the row is still in cache.
+	for ( int i = start; i < end; i++ )
+	{
+		this->compute_cells( this->position( i, 0 ), this->position( i, this->cols ) );
+		this->mark_changes( i );
+	}
+}
+
+void Matrix::mark_changes( int i )
+{
+	const bool *r = this->read + this->position( i, 0 ), *w = this->write + this->position( i, 0 );
+	long side = 1L << this->tile_bits, first_tile = ( (long) i >> this->tile_bits ) * this->tiles_x;
+	for ( long j = 0, tile = first_tile; j < this->cols; j += side, tile++ )
+	{
+		if ( memcmp( r + j, w + j, std::min( side, this->cols - j ) ) == 0 ) continue;
+		// The rows of a tile can belong to different workers: the bit is set atomically, and only once.
+		std::atomic<uint64_t>& word = this->changes[tile / 64];
+		uint64_t bit = 1ULL << ( tile % 64 );
+		if ( ( word.load( std::memory_order_relaxed ) & bit ) == 0 )
+			word.fetch_or( bit, std::memory_order_relaxed );
+	}
+}
+
+void Matrix::track_tiles( int bits )
+{
+	long side = 1L << bits;
+	this->tile_bits = bits;
+	this->tiles_x = ( this->cols + side - 1 ) / side;
+	delete[] this->changes;
+	this->changes = new std::atomic<uint64_t>[this->change_words()];
+	for ( size_t w = 0; w < this->change_words(); w++ )
+		this->changes[w] = ~0ULL;
+}
 
-    return c;
+size_t Matrix::change_words() const
+{
+	long side = 1L << this->tile_bits, tiles = this->tiles_x * ( ( this->rows + side - 1 ) / side );
+	return (size_t) ( tiles + 63 ) / 64;
+}
+
+std::atomic<uint64_t>* Matrix::swap_changes( std::atomic<uint64_t>* clear )
+{
+	std::atomic<uint64_t>* changed = this->changes;
+	this->changes = clear;
+	return changed;
+}
+
+void Matrix::copyBorder()
+{
+	size_t s = this->stride, last_row = this->rows * s;
+
+	// Fill the top and the bottom border with the last and the first row.
+	std::copy( this->read + last_row + 1, this->read + last_row + 1 + this->cols, this->read + 1 );
+	std::copy( this->read + s + 1, this->read + s + 1 + this->cols, this->read + last_row + s + 1 );
+
+	// Fill the left and the right border with the last and the first column, corners included.
+	for ( size_t pos = 0; pos <= last_row + s; pos += s )
+	{
+		this->read[pos] = this->read[pos + this->cols];
+		this->read[pos + this->cols + 1] = this->read[pos + 1];
+	}
 }
 
 void Matrix::swap()
 {
-	bool** tmp = this->read;
+	bool* tmp = this->read;
 	this->read  = this->write;
-	this->write = tmp;
+	// A lent array leaves the matrix, since it is still read by the reader.
+	if ( this->replacement != NULL )
+	{
+		this->retired = tmp;
+		this->write = this->replacement;
+		this->replacement = NULL;
+	}
+	else
+		this->write = tmp;
+}
+
+size_t Matrix::buffer_size() const
+{
+	return ( (size_t) this->rows + 2 ) * this->stride;
+}
+
+size_t Matrix::row_stride() const
+{
+	return this->stride;
+}
+
+const bool* Matrix::row( const bool* buffer, int i ) const
+{
+	return buffer + this->position( i, 0 );
+}
+
+bool* Matrix::lend( bool* replacement )
+{
+	assert ( this->replacement == NULL && this->retired == NULL );
+	this->replacement = replacement;
+	return this->read;
+}
+
+bool* Matrix::reclaim()
+{
+	bool* buffer = this->retired;
+	this->retired = NULL;
+	return buffer;
+}
+
+void Matrix::snapshot( bool* dst ) const
+{
+	for ( int i = 0; i < this->rows; i++ )
+		std::copy( this->read + this->position( i, 0 ), this->read + this->position( i, this->cols ), dst + (size_t) i * this->cols );
 }
 
 void Matrix::print()
@@ -191,7 +297,7 @@ void Matrix::print()
 	{
 		for ( int j = 0; j < this->cols; j++ )
 		{
-			if (this->read[i][j]) std::cout << "1";
+			if (this->read[this->position( i, j )]) std::cout << "1";
 			else std::cout << "0";
 		}
 		std::cout << std::endl;
@@ -202,28 +308,85 @@ void Matrix::allocate( int height, int width )
 {
 	assert ( (height > 0) && (width > 0) );
 
-	this->read = new bool*[height];
-	this->write = new bool*[height];
-
-	for ( int i = 0; i < height; i++ )
-	{
-		this->read[i] = new bool[width];
-		this->write[i] = new bool[width];
-	}
+	// Each matrix is a single contiguous buffer, enlarged with the border.
+	this->stride = (size_t) width + 2;
+	size_t size = ( (size_t) height + 2 ) * this->stride;
+	this->read = new bool[size]();
+	this->write = new bool[size]();
 
 	this->rows = height;
 	this->cols = width;
 }
 
-Matrix::~Matrix()
+bool Matrix::convert_row( const char* src, bool* dst, size_t n )
 {
-	for ( int i = 0; i < this->rows; i++ )
+	size_t j = 0;
+	unsigned char invalid = 0;
+#if __SSE2__
+	// Classify 16 characters at a time: after subtracting '0', the valid ones are 0 or 1,
+	// i.e. exactly the values that have to be stored in the boolean matrix.
+	const __m128i zero = _mm_set1_epi8( '0' ), one = _mm_set1_epi8( 1 );
+	__m128i bad = _mm_setzero_si128();
+	for ( ; j + 16 <= n; j += 16 )
 	{
-		delete[] this->read[i];
-		delete[] this->write[i];
+		__m128i v = _mm_sub_epi8( _mm_loadu_si128( (const __m128i*) (src + j) ), zero );
+		bad = _mm_or_si128( bad, _mm_xor_si128( _mm_max_epu8( v, one ), one ) );
+		_mm_storeu_si128( (__m128i*) (dst + j), v );
 	}
+	if ( _mm_movemask_epi8( _mm_cmpeq_epi8( bad, _mm_setzero_si128() ) ) != 0xFFFF )
+		return false;
+#endif // __SSE2__
+	for ( ; j < n; j++ )
+	{
+		unsigned char v = (unsigned char) ( src[j] - '0' );
+		invalid |= ( v > 1 );
+		dst[j] = ( v == 1 );
+	}
+	return ( invalid == 0 );
+}
+
+void Matrix::parse_error( const char* data, size_t size, size_t width )
+{
+	// Scan the file again, line by line, looking for the first error.
+	size_t pos = 0;
+	for ( int i = 0; pos < size; i++ )
+	{
+		const char* nl = (const char*) memchr( data + pos, '\n', size - pos );
+		size_t len = ( nl == NULL ) ? size - pos : (size_t) ( nl - data - pos );
+		for ( size_t j = 0; j < len; j++ )
+		{
+			char tmp = data[pos + j];
+			if ( tmp != '0' && tmp != '1' )
+			{
+				std::cerr << "Error parsing file at line "<< i << " and column "<< j << ". ";
+				std::cerr << "Read " << tmp << " instead of 0, 1 or \\n. ";
+				std::cerr << "The matrix has to be composed of 0 and 1 only." << std::endl;
+				std::cerr << "Example : "  << std::endl;
+				std::cerr << "\t100\\n" << std::endl;
+				std::cerr << "\t010\\n" << std::endl;
+				std::cerr << "\t001\\n" << std::endl << std::endl;
+				exit( 1 );
+			}
+		}
+		if ( len != width || len == 0 )
+		{
+			std::cerr << "Error: number of columns at row n." << (i + 1) << " (" << len << " columns) ";
+			std::cerr << "is not equal to that of first row." << std::endl;
+			exit( 1 );
+		}
+		pos += len + 1;
+	}
+	std::cerr << "Error: the matrix is too big." << std::endl;
+	exit( 1 );
+}
+
+Matrix::~Matrix()
+{
 	delete[] this->read;
 	delete[] this->write;
+	delete[] this->replacement;
+	delete[] this->retired;
+	delete[] this->changes;
 }
 
 std::ostream& operator<<(std::ostream &strm, const Matrix &m)
@@ -233,7 +396,7 @@ std::ostream& operator<<(std::ostream &strm, const Matrix &m)
 	{
 		for ( int j = 0; j < m.cols; j++ )
 		{
-			if (m.read[i][j]) strm << "1";
+			if (m.read[m.position( i, j )]) strm << "1";
 			else strm << "0";
 		}
 		strm << "\n";
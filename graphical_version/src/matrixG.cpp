@@ -37,41 +37,143 @@ MatrixG::MatrixG( const char* input_path, const char* output_video, int steps )
 	this->init( output_video, steps );
 }
 
-void MatrixG::set( int i, int j, bool value )
+void MatrixG::print()
 {
-	int ps = this->pixel_size;
-	Matrix::set( i, j, value );
-	this->screen( cv::Rect( j * ps, i * ps, ps, ps) ) = cv::Scalar::all( value ? WHITE : BLACK );
+	// The generation lent at the previous call left the matrix with the last swap.
+	bool* retired = this->reclaim();
+	std::unique_lock<std::mutex> lock( this->mux );
+	if ( retired != NULL ) this->release();
+
+	// Each generation is a frame of the video, so it waits for the rendering thread;
+	// otherwise, without the spare array the previous generation is still being rendered: drop this one.
+	if ( this->write_video )
+		this->cond.wait( lock, [this]{ return this->spare != NULL; } );
+	if ( this->spare == NULL ) return;
+
+	// The changed tiles keep accumulating in the matrix until a generation is lent.
+	this->lent = this->lend( this->spare );
+	this->lent_changes = this->swap_changes( this->spare_changes );
+	this->spare = NULL;
+	this->spare_changes = NULL;
+	this->holders = 2;
+	this->available = true;
+	this->cond.notify_all();
 }
 
-void MatrixG::print()
+void MatrixG::release()
 {
+	if ( --this->holders > 0 ) return;
+	this->spare = this->lent;
+	this->lent = NULL;
+	this->cond.notify_all();
+}
+
+void MatrixG::render_loop()
+{
+	// The window belongs to the thread that shows the images.
+	cv::namedWindow( "result", cv::WINDOW_AUTOSIZE );
+	cv::moveWindow( "result", 0, 0 );
+
+	while ( true )
+	{
+		const bool* cells;
+		std::atomic<uint64_t>* changes;
+		{
+			std::unique_lock<std::mutex> lock( this->mux );
+			this->cond.wait( lock, [this]{ return this->available || this->stop; } );
+			if ( !this->available ) break;
+			cells = this->lent;
+			changes = this->lent_changes;
+			this->available = false;
+		}
+		this->render( cells, changes );
+		{
+			// The bitmap has been cleared by the pyramid.
+			std::lock_guard<std::mutex> lock( this->mux );
+			this->spare_changes = changes;
+			this->release();
+		}
+	}
+}
+
+void MatrixG::render( const bool* cells, std::atomic<uint64_t>* changes )
+{
+	// Only the tiles that changed are counted again, and only the visible blocks are drawn.
+	const bool* first = this->row( cells, 0 );
+	this->pyramid->update( first, this->row_stride(), changes );
+	cv::Mat gray( this->view_height, this->view_width, CV_8UC1 );
+	this->pyramid->render( first, this->row_stride(), this->zoom, this->pixel_size, this->top, this->left, gray.data, this->view_width, this->view_height );
+	cv::cvtColor( gray, this->screen, cv::COLOR_GRAY2BGR );
+
 	cv::imshow( "result", this->screen );
-	cv::waitKey( this->screen_rate );
+	int key = cv::waitKey( this->screen_rate );
+	if ( key >= 0 )
+		this->handle_key( key & 0xFF );
 	if ( this->write_video )
 		this->video << this->screen;
 }
 
+void MatrixG::handle_key( int key )
+{
+	// Cells covered by the view, before the change.
+	long visible_rows = (long) ( this->view_height / this->pixel_size ) << this->zoom;
+	long visible_cols = (long) ( this->view_width / this->pixel_size ) << this->zoom;
+	long center_i = this->top + visible_rows / 2, center_j = this->left + visible_cols / 2;
+
+	switch ( key )
+	{
+		case '+': case '=':
+			if ( this->zoom > 0 ) this->zoom--;
+			else this->pixel_size = std::min( 2 * this->pixel_size, MAX_PIXEL_SIZE );
+			break;
+		case '-':
+			if ( this->pixel_size > 1 ) this->pixel_size /= 2;
+			else this->zoom = std::min( this->zoom + 1, this->pyramid->fit( this->view_width, this->view_height ) );
+			break;
+		case 'w': center_i -= visible_rows / 4; break;
+		case 's': center_i += visible_rows / 4; break;
+		case 'a': center_j -= visible_cols / 4; break;
+		case 'd': center_j += visible_cols / 4; break;
+		default: return;
+	}
+
+	// Keep the center of the view, inside the matrix.
+	visible_rows = (long) ( this->view_height / this->pixel_size ) << this->zoom;
+	visible_cols = (long) ( this->view_width / this->pixel_size ) << this->zoom;
+	this->top = std::max( 0L, std::min( center_i - visible_rows / 2, (long) this->rows - 1 ) );
+	this->left = std::max( 0L, std::min( center_j - visible_cols / 2, (long) this->cols - 1 ) );
+}
+
 void MatrixG::init( const char* output_video, int steps )
 {
 	Display* d = XOpenDisplay(NULL);
+	if ( d == NULL )
+	{
+		std::cerr << "Error: it is not possible to open the display, use --export to save the frames without it." << std::endl;
+		exit( 1 );
+	}
 	Screen*  s = DefaultScreenOfDisplay(d);
 	std::cout << "SCREEN : height = " << s->height << ", width = " << s->width << std::endl;
-	assert ( (this->cols  <= s->width) && (this->rows  <= s->height) );
-	this->pixel_size = std::min( ( s->width / this->cols ), ( s->height / this->rows ) );
 	this->screen_rate = std::max( 10, MAX_DELAY_SCREEN / steps );
-	int ps = this->pixel_size;
-	// Initialize the matrix image
-	this->screen = cv::Mat::zeros( this->rows * ps, this->cols * ps, CV_8UC3 );
 
-	// Set up the image with initial matrix configuration
-	for ( int i = 0; i < this->rows; i++ )
-		for ( int j = 0; j < this->cols; j++ )
-			this->screen( cv::Rect( j * ps, i * ps, ps, ps) ) = cv::Scalar::all( this->get(i, j) ? WHITE : BLACK );
+	// The pyramid is updated from the tiles changed by compute.
+	this->track_tiles( TILE_BITS );
 
-	// Create and move the windows where the result is shown
-	cv::namedWindow( "result", cv::WINDOW_AUTOSIZE );
-	cv::moveWindow( "result", 0, 0 );
+	// Start from the view of the whole matrix: if it is larger than the screen, each pixel is a block of cells.
+	this->pyramid = new DensityPyramid( this->rows, this->cols );
+	this->zoom = this->pyramid->fit( s->width, s->height );
+	long side = 1L << this->zoom, blocks_x = ( this->cols + side - 1 ) / side, blocks_y = ( this->rows + side - 1 ) / side;
+	this->pixel_size = (int) std::max( 1L, std::min( std::min( s->width / blocks_x, s->height / blocks_y ), (long) MAX_PIXEL_SIZE ) );
+	this->view_width = (int) blocks_x * this->pixel_size;
+	this->view_height = (int) blocks_y * this->pixel_size;
+	this->top = 0;
+	this->left = 0;
+	if ( this->zoom > 0 )
+		std::cout << "The matrix is shown with one pixel every " << side << "x" << side << " cells." << std::endl;
+	std::cout << "Press + and - to zoom, w, a, s and d to move." << std::endl;
+
+	// Initialize the matrix image
+	this->screen = cv::Mat::zeros( this->view_height, this->view_width, CV_8UC3 );
 
 	// If the psrite_video, set up the video
 	this->write_video = ( output_video != NULL );
@@ -81,12 +183,35 @@ void MatrixG::init( const char* output_video, int steps )
 			std::string( output_video ) + ".avi",
 			CV_FOURCC( 'M','J','P','G' ),
 			2, // FPS
-			cv::Size( this->cols * ps, this->rows * ps ) );
+			cv::Size( this->view_width, this->view_height ) );
 	}
+
+	// Start the rendering thread
+	this->lent = NULL;
+	this->spare = new bool[this->buffer_size()];
+	this->lent_changes = NULL;
+	this->spare_changes = new std::atomic<uint64_t>[this->change_words()];
+	for ( size_t w = 0; w < this->change_words(); w++ )
+		this->spare_changes[w] = 0;
+	this->holders = 0;
+	this->available = false;
+	this->stop = false;
+	this->renderer = std::thread( &MatrixG::render_loop, this );
 }
 
 MatrixG::~MatrixG()
 {
+	// Let the rendering thread show the last generation and terminate.
+	{
+		std::lock_guard<std::mutex> lock( this->mux );
+		this->stop = true;
+		this->cond.notify_all();
+	}
+	this->renderer.join();
+	// The lent array, if any, is still owned by the matrix.
+	delete[] this->spare;
+	delete[] this->spare_changes;
+	delete this->pyramid;
 	this->screen.release();
 	this->video.release();
 }
@@ -0,0 +1,97 @@
+/**
+ *	@file terminal_renderer.cpp
+ *  @brief Implementation of \see TerminalRenderer class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/ConnectedComponents
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+
+#include "terminal_renderer.hpp"
+
+TerminalRenderer::TerminalRenderer( int height, int width )
+	: rows( height ), cols( width ), glyph_rows( ( height + GLYPH_ROWS - 1 ) / GLYPH_ROWS ), glyph_cols( ( width + GLYPH_COLS - 1 ) / GLYPH_COLS ),
+	  style( fco::FG_LIGHT_GREEN ), status( fco::BOLD )
+{
+	// After clearing, the terminal shows only empty characters.
+	this->shown.assign( (size_t) this->glyph_rows * this->glyph_cols, 0 );
+	this->current.assign( (size_t) this->glyph_rows * this->glyph_cols, 0 );
+	this->cleared = false;
+}
+
+unsigned char TerminalRenderer::dots( const bool* cells, size_t stride, int gi, int gj ) const
+{
+	// Bit of the Braille pattern of each cell of the block, row by row.
+	static const unsigned char bit[GLYPH_ROWS][GLYPH_COLS] = { { 0x01, 0x08 }, { 0x02, 0x10 }, { 0x04, 0x20 }, { 0x40, 0x80 } };
+	unsigned char d = 0;
+	int i0 = gi * GLYPH_ROWS, j0 = gj * GLYPH_COLS;
+	for ( int r = 0; r < GLYPH_ROWS && i0 + r < this->rows; r++ )
+	{
+		const bool* row = cells + (size_t) ( i0 + r ) * stride;
+		for ( int c = 0; c < GLYPH_COLS && j0 + c < this->cols; c++ )
+			d |= row[j0 + c] ? bit[r][c] : 0;
+	}
+	return d;
+}
+
+void TerminalRenderer::draw( const bool* cells, size_t stride, int iteration_number, std::string& out )
+{
+	out.clear();
+	if ( !this->cleared )
+	{
+		out += "\033[2J";
+		this->cleared = true;
+	}
+
+	std::string run;
+	for ( int gi = 0; gi < this->glyph_rows; gi++ )
+	{
+		unsigned char* now = &this->current[(size_t) gi * this->glyph_cols];
+		unsigned char* before = &this->shown[(size_t) gi * this->glyph_cols];
+		for ( int gj = 0; gj < this->glyph_cols; gj++ )
+			now[gj] = this->dots( cells, stride, gi, gj );
+
+		int gj = 0;
+		while ( gj < this->glyph_cols )
+		{
+			if ( now[gj] == before[gj] ) { gj++; continue; }
+
+			// Collect a run of changed characters, including short gaps of unchanged ones.
+			int first = gj, last = gj;
+			for ( int k = gj + 1; k < this->glyph_cols && k - last <= MAX_GLYPH_GAP + 1; k++ )
+				if ( now[k] != before[k] ) last = k;
+
+			run.clear();
+			for ( int k = first; k <= last; k++ )
+			{
+				// UTF-8 encoding of the character U+2800 + dots.
+				run += (char) 0xE2;
+				run += (char) ( 0xA0 | ( now[k] >> 6 ) );
+				run += (char) ( 0x80 | ( now[k] & 0x3F ) );
+				before[k] = now[k];
+			}
+			out += "\033[" + std::to_string( gi + 1 ) + ";" + std::to_string( first + 1 ) + "H";
+			out += this->style.apply( run.c_str() );
+			gj = last + 1;
+		}
+	}
+
+	// Status line below the matrix, then leave the cursor on the next line.
+	std::string line = "Iteration " + std::to_string( iteration_number );
+	out += "\033[" + std::to_string( this->glyph_rows + 1 ) + ";1H";
+	out += this->status.apply( line.c_str() );
+	out += "\033[K\n";
+}
@@ -0,0 +1,152 @@
+/**
+ *	@file harness.cpp
+ *	@brief Contains the main() function of the benchmark that compares the data structures of the attempts.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+#include "layouts.h"
+#include "../include/program_options.h"
+
+#define RAND_MAX_HALF RAND_MAX/2
+#define DEFAULT_WARMUP 2
+#define DEFAULT_REPETITIONS 10
+
+int main( int argc, char** argv )
+{
+	ProgramOptions po( argc, argv );
+
+	// Print help message if the "--help" option is present.
+	if ( po.exists( "--help" ) )
+	{
+		std::cerr << "Usage: " << argv[0] << " [options] " << std::endl;
+		std::cerr << "Possible options:" << std::endl;
+		std::cerr << "\t --sizes LIST \t\t grid sizes, as side or WIDTHxHEIGHT ( default 1000 ) ;" << std::endl;
+		std::cerr << "\t --threads LIST \t number of threads, zero for the sequential version ( default 0,1,2,4 ) ;" << std::endl;
+		std::cerr << "\t --layouts LIST \t layouts among " << LAYOUT_NAMES << " ( default all ) ;" << std::endl;
+		std::cerr << "\t -i NUM, --iterations NUM \t generations computed by each sample ( default 100 ) ;" << std::endl;
+		std::cerr << "\t --warmup NUM \t\t samples discarded before measuring ( default " << DEFAULT_WARMUP << " ) ;" << std::endl;
+		std::cerr << "\t --reps NUM \t\t measured samples ( default " << DEFAULT_REPETITIONS << " ) ;" << std::endl;
+		std::cerr << "\t -s NUM, --seed NUM \t seed used to initialize the grid ( default 1 ) ;" << std::endl;
+		std::cerr << "\t --output FILE \t\t CSV file where to write the results ( default standard output ) ;" << std::endl;
+		std::cerr << "\t --help \t\t this help view ;" << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> sizes = po.get_list( "--sizes", "1000" );
+	std::vector<std::string> threads = po.get_list( "--threads", "0,1,2,4" );
+	std::vector<std::string> layouts = po.get_list( "--layouts", LAYOUT_NAMES );
+	unsigned int iterations = (unsigned int) po.get_number( "-i", "--iterations", 100 );
+	unsigned int warmup = (unsigned int) po.get_number( "--warmup", DEFAULT_WARMUP );
+	unsigned int reps = (unsigned int) po.get_number( "--reps", DEFAULT_REPETITIONS );
+	unsigned int seed = (unsigned int) po.get_number( "-s", "--seed", 1 );
+	const char* output = po.get( "--output" );
+	assert( iterations > 0 && reps > 0 );
+
+	std::ofstream file;
+	if ( output != NULL )
+	{
+		file.open( output );
+		if ( file.fail() )
+		{
+			std::cerr << "Error: it is not possible to create the file " << output << "." << std::endl;
+			return 1;
+		}
+	}
+	std::ostream& csv = ( output != NULL ) ? file : std::cout;
+	csv << "layout,width,height,threads,iterations,warmup,reps,bytes,median_us,mean_us,min_us,max_us,cells_per_s" << std::endl;
+	csv << std::fixed << std::setprecision( 1 );
+
+	for ( size_t s = 0; s < sizes.size(); s++ )
+	{
+		char* x = NULL;
+		size_t width = strtoul( sizes[s].c_str(), &x, 10 );
+		size_t height = ( *x == 'x' ) ? strtoul( x + 1, NULL, 10 ) : width;
+		if ( width == 0 || height == 0 )
+		{
+			std::cerr << "Error: invalid grid size " << sizes[s] << "." << std::endl;
+			return 1;
+		}
+
+		// Every layout starts from the same grid, and has to reach the same final grid.
+		std::vector<bool> initial( width * height ), reference;
+		srand( seed );
+		for ( size_t i = 0; i < initial.size(); i++ )
+			initial[i] = ( rand() > RAND_MAX_HALF );
+
+		for ( size_t n = 0; n < layouts.size(); n++ )
+			for ( size_t t = 0; t < threads.size(); t++ )
+			{
+				unsigned int nw = (unsigned int) std::atol( threads[t].c_str() );
+				Layout* l = create_layout( layouts[n], width, height );
+				if ( l == NULL )
+				{
+					std::cerr << "Error: unknown layout " << layouts[n] << "." << std::endl;
+					return 1;
+				}
+				if ( nw > 0 && !l->parallel() )
+				{
+					std::cerr << "Layout " << layouts[n] << " cannot be computed in parallel, skipped with " << nw << " threads." << std::endl;
+					delete l;
+					continue;
+				}
+
+				std::vector<double> samples;
+				for ( unsigned int r = 0; r < warmup + reps; r++ )
+				{
+					for ( size_t i = 0; i < height; i++ )
+						for ( size_t j = 0; j < width; j++ )
+							l->set( i, j, initial[i * width + j] );
+					double us = run_layout( l, height, nw, iterations );
+					if ( r >= warmup ) samples.push_back( us );
+				}
+
+				std::vector<bool> result( width * height );
+				for ( size_t i = 0; i < height; i++ )
+					for ( size_t j = 0; j < width; j++ )
+						result[i * width + j] = l->get( i, j );
+				if ( reference.empty() ) reference = result;
+				else if ( result != reference )
+				{
+					std::cerr << "Error: layout " << layouts[n] << " with " << nw << " threads computed a different grid." << std::endl;
+					return 1;
+				}
+
+				std::sort( samples.begin(), samples.end() );
+				size_t k = samples.size();
+				double median = ( k % 2 == 1 ) ? samples[k / 2] : ( samples[k / 2 - 1] + samples[k / 2] ) / 2, sum = 0;
+				for ( size_t i = 0; i < k; i++ ) sum += samples[i];
+				double cells = (double) width * height * iterations;
+
+				csv << layouts[n] << "," << width << "," << height << "," << nw << "," << iterations << "," << warmup << "," << reps << ",";
+				csv << l->bytes() << "," << median << "," << sum / k << "," << samples.front() << "," << samples.back() << ",";
+				csv << std::setprecision( 0 ) << cells / median * 1e6 << std::setprecision( 1 ) << std::endl;
+				std::cerr << width << "x" << height << " " << layouts[n] << " threads " << nw << ": median " << median << " us" << std::endl;
+				delete l;
+			}
+	}
+
+	return 0;
+}
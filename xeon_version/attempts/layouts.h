@@ -0,0 +1,462 @@
+/**
+ *	@file layouts.h
+ *	@brief Data structures of the attempts, as interchangeable implementations of the \see Layout interface.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_LAYOUTS_H
+#define GAMEOFLIFE_LAYOUTS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <bitset>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#if BOOST
+#include <boost/dynamic_bitset.hpp>
+#endif // BOOST
+
+#define BITSET_SIZE 64
+
+/// Names of the layouts accepted by \see create_layout.
+#if BOOST
+#define LAYOUT_NAMES "1m,array_bool,vector_bool,array_bitset,dynamic_bitset"
+#else
+#define LAYOUT_NAMES "1m,array_bool,vector_bool,array_bitset"
+#endif // BOOST
+
+/**
+ * Grid of Game of Life stored with a given data structure.
+ * The virtual functions work on whole rows, so the cost of the dispatch does not depend on the data structure,
+ * while the cells are accessed by the inline functions of the storage, see \see TwoMatrices.
+ * The positions are those of the original grid, without border: row in [0, height), column in [0, width).
+ */
+class Layout
+{
+public:
+	virtual ~Layout() { }
+
+	/**
+	 * Set a cell of the current generation.
+	 * @param i, j		row and column of the cell.
+	 * @param value		new state of the cell.
+	 */
+	virtual void set( size_t i, size_t j, bool value ) = 0;
+
+	/**
+	 * Return a cell of the current generation.
+	 * @param i, j		row and column of the cell.
+	 * @return	the state of the cell.
+	 */
+	virtual bool get( size_t i, size_t j ) const = 0;
+
+	/// Copy the cells of the toroidal neighbourhood into the border, before the generation is computed.
+	virtual void copy_border() = 0;
+
+	/**
+	 * Compute the next generation of a band of rows.
+	 * @param first, last		the band of rows [first, last).
+	 */
+	virtual void compute( size_t first, size_t last ) = 0;
+
+	/// Make the computed generation the current one.
+	virtual void end_generation() = 0;
+
+	/**
+	 * Check if disjoint bands of rows can be computed by different threads at the same time.
+	 * @return	<code>true</code> if the bands can be computed in parallel.
+	 */
+	virtual bool parallel() const
+	{
+		return true;
+	}
+
+	/**
+	 * Return the memory occupied by the cells.
+	 * @return	the size of the data structure, in bytes.
+	 */
+	virtual size_t bytes() const = 0;
+};
+
+/**
+ * Copy the toroidal neighbourhood into the border of a grid: the first and the last row, then the first and the last column.
+ * It is shared by all the layouts, which only differ for the storage of the cells.
+ * @param s					storage of the cells.
+ * @param origin			position of the top-left corner of the border.
+ * @param stride			distance between two rows.
+ * @param width, height		size of the original grid.
+ */
+template <class Storage>
+void copy_border( Storage& s, size_t origin, size_t stride, size_t width, size_t height )
+{
+	size_t top = origin, bottom = origin + ( height + 1 ) * stride;
+	for ( size_t j = 1; j <= width; j++ )
+	{
+		s.set( top + j, s.get( bottom - stride + j ) );
+		s.set( bottom + j, s.get( top + stride + j ) );
+	}
+	// The corners are copied with the columns, after the rows.
+	for ( size_t pos = top; pos <= bottom; pos += stride )
+	{
+		s.set( pos, s.get( pos + width ) );
+		s.set( pos + width + 1, s.get( pos + 1 ) );
+	}
+}
+
+/**
+ * Count the alive neighbours of a cell; it is shared by all the layouts.
+ * @param s			storage of the cells.
+ * @param pos		position of the cell.
+ * @param stride	distance between two rows.
+ * @return	the number of alive neighbours.
+ */
+template <class Storage>
+inline int count_neighbours( const Storage& s, size_t pos, size_t stride )
+{
+	return s.get( pos - stride - 1 ) + s.get( pos - stride ) + s.get( pos - stride + 1 )
+		 + s.get( pos - 1 ) + s.get( pos + 1 )
+		 + s.get( pos + stride - 1 ) + s.get( pos + stride ) + s.get( pos + stride + 1 );
+}
+
+/// Storage of 2.1m, 3.array_bool and 1.2m: one bool per cell.
+class BoolArray
+{
+public:
+	/// Distance between two rows is a multiple of ALIGNMENT cells.
+	static const size_t ALIGNMENT = 1;
+
+	BoolArray( size_t n ) : cells( new bool[n]() ), n( n ) { }
+	~BoolArray() { delete[] this->cells; }
+	inline bool get( size_t pos ) const { return this->cells[pos]; }
+	inline void set( size_t pos, bool value ) { this->cells[pos] = value; }
+	size_t bytes() const { return this->n; }
+
+private:
+	BoolArray( const BoolArray& );
+	bool* cells;
+	const size_t n;
+};
+
+/// Storage of 4.vector_bool: a bit per cell, in the words of std::vector<bool>.
+class BoolVector
+{
+public:
+	static const size_t ALIGNMENT = 64;
+
+	BoolVector( size_t n ) : cells( n, false ) { }
+	inline bool get( size_t pos ) const { return this->cells[pos]; }
+	inline void set( size_t pos, bool value ) { this->cells[pos] = value; }
+	size_t bytes() const { return ( this->cells.size() + 7 ) / 8; }
+
+private:
+	std::vector<bool> cells;
+};
+
+/// Storage of 5.array_bitset: an array of std::bitset of BITSET_SIZE cells.
+class BitsetArray
+{
+public:
+	static const size_t ALIGNMENT = BITSET_SIZE;
+
+	BitsetArray( size_t n ) : blocks( new std::bitset<BITSET_SIZE>[( n + BITSET_SIZE - 1 ) / BITSET_SIZE] ), n( n ) { }
+	~BitsetArray() { delete[] this->blocks; }
+	inline bool get( size_t pos ) const { return this->blocks[pos / BITSET_SIZE][pos % BITSET_SIZE]; }
+	inline void set( size_t pos, bool value ) { this->blocks[pos / BITSET_SIZE][pos % BITSET_SIZE] = value; }
+	size_t bytes() const { return ( this->n + BITSET_SIZE - 1 ) / BITSET_SIZE * sizeof( std::bitset<BITSET_SIZE> ); }
+
+private:
+	BitsetArray( const BitsetArray& );
+	std::bitset<BITSET_SIZE>* blocks;
+	const size_t n;
+};
+
+#if BOOST
+/// Storage of 6.dynamic_bitset: a boost::dynamic_bitset of 64-bit blocks.
+class DynamicBitset
+{
+public:
+	static const size_t ALIGNMENT = 64;
+
+	DynamicBitset( size_t n ) : cells( n ) { }
+	inline bool get( size_t pos ) const { return this->cells[pos]; }
+	inline void set( size_t pos, bool value ) { this->cells[pos] = value; }
+	size_t bytes() const { return this->cells.num_blocks() * sizeof( unsigned long long ); }
+
+private:
+	boost::dynamic_bitset<unsigned long long> cells;
+};
+#endif // BOOST
+
+/**
+ * Layout with two matrices, one for reading and one for writing, swapped at the end of each generation.
+ * The rows are padded to a multiple of Storage::ALIGNMENT cells, so the bit-packed storages never share
+ * a word between two rows and the bands of rows can be written by different threads.
+ */
+template <class Storage>
+class TwoMatrices : public Layout
+{
+public:
+	/**
+	 * Initializes a new instance of the \see TwoMatrices class, with all the cells dead.
+	 * @param width, height		size of the original grid.
+	 */
+	TwoMatrices( size_t width, size_t height )
+		: width( width ), height( height ),
+		  stride( ( width + 2 + Storage::ALIGNMENT - 1 ) / Storage::ALIGNMENT * Storage::ALIGNMENT )
+	{
+		this->read = new Storage( this->stride * ( height + 2 ) );
+		this->write = new Storage( this->stride * ( height + 2 ) );
+	}
+
+	~TwoMatrices()
+	{
+		delete this->read;
+		delete this->write;
+	}
+
+	void set( size_t i, size_t j, bool value )
+	{
+		this->read->set( ( i + 1 ) * this->stride + j + 1, value );
+	}
+
+	bool get( size_t i, size_t j ) const
+	{
+		return this->read->get( ( i + 1 ) * this->stride + j + 1 );
+	}
+
+	void copy_border()
+	{
+		::copy_border( *this->read, 0, this->stride, this->width, this->height );
+	}
+
+	void compute( size_t first, size_t last )
+	{
+		const Storage& r = *this->read;
+		Storage& w = *this->write;
+		for ( size_t i = first + 1; i <= last; i++ )
+		{
+			size_t pos = i * this->stride + 1, end = pos + this->width;
+			for ( ; pos < end; pos++ )
+			{
+				int numNeighbours = count_neighbours( r, pos, this->stride );
+				w.set( pos, numNeighbours == 3 || ( r.get( pos ) && numNeighbours == 2 ) );
+			}
+		}
+	}
+
+	void end_generation()
+	{
+		std::swap( this->read, this->write );
+	}
+
+	size_t bytes() const
+	{
+		return this->read->bytes() + this->write->bytes();
+	}
+
+private:
+	const size_t width, height, stride;
+	Storage* read;
+	Storage* write;
+};
+
+/**
+ * Layout of 2.1m: a single matrix with a spare row and column. Each cell is written onto its top-left neighbour,
+ * which has already been read, so the grid moves up-left by one cell; the next generation visits the cells
+ * backwards and writes them onto the bottom-right neighbour, moving the grid back.
+ * The order of the visit matters, so the bands of rows cannot be computed in parallel.
+ */
+class OneMatrix : public Layout
+{
+public:
+	/**
+	 * Initializes a new instance of the \see OneMatrix class, with all the cells dead.
+	 * @param width, height		size of the original grid.
+	 */
+	OneMatrix( size_t width, size_t height )
+		: width( width ), height( height ), stride( width + 3 ), cells( stride * ( height + 3 ) ), shifted( false ) { }
+
+	void set( size_t i, size_t j, bool value )
+	{
+		this->cells.set( this->origin() + ( i + 1 ) * this->stride + j + 1, value );
+	}
+
+	bool get( size_t i, size_t j ) const
+	{
+		return this->cells.get( this->origin() + ( i + 1 ) * this->stride + j + 1 );
+	}
+
+	void copy_border()
+	{
+		::copy_border( this->cells, this->origin(), this->stride, this->width, this->height );
+	}
+
+	void compute( size_t first, size_t last )
+	{
+		size_t origin = this->origin(), shift = this->stride + 1;
+		if ( this->shifted )
+		{
+			for ( size_t i = last; i > first; i-- )
+				for ( size_t pos = origin + i * this->stride + this->width; pos > origin + i * this->stride; pos-- )
+				{
+					int numNeighbours = count_neighbours( this->cells, pos, this->stride );
+					this->cells.set( pos + shift, numNeighbours == 3 || ( this->cells.get( pos ) && numNeighbours == 2 ) );
+				}
+		}
+		else
+		{
+			for ( size_t i = first + 1; i <= last; i++ )
+				for ( size_t pos = origin + i * this->stride + 1; pos <= origin + i * this->stride + this->width; pos++ )
+				{
+					int numNeighbours = count_neighbours( this->cells, pos, this->stride );
+					this->cells.set( pos - shift, numNeighbours == 3 || ( this->cells.get( pos ) && numNeighbours == 2 ) );
+				}
+		}
+	}
+
+	void end_generation()
+	{
+		this->shifted = !this->shifted;
+	}
+
+	bool parallel() const
+	{
+		return false;
+	}
+
+	size_t bytes() const
+	{
+		return this->cells.bytes();
+	}
+
+private:
+	/// Position of the top-left corner of the border: the grid is moved up-left when shifted.
+	size_t origin() const
+	{
+		return this->shifted ? 0 : this->stride + 1;
+	}
+
+	const size_t width, height, stride;
+	BoolArray cells;
+	bool shifted;
+};
+
+/**
+ * Create a layout by name.
+ * @param name				one of the names in LAYOUT_NAMES.
+ * @param width, height		size of the original grid.
+ * @return	the new layout, or <code>NULL</code> if the name is unknown.
+ */
+inline Layout* create_layout( const std::string& name, size_t width, size_t height )
+{
+	if ( name == "1m" ) return new OneMatrix( width, height );
+	if ( name == "array_bool" || name == "2m" ) return new TwoMatrices<BoolArray>( width, height );
+	if ( name == "vector_bool" ) return new TwoMatrices<BoolVector>( width, height );
+	if ( name == "array_bitset" ) return new TwoMatrices<BitsetArray>( width, height );
+#if BOOST
+	if ( name == "dynamic_bitset" ) return new TwoMatrices<DynamicBitset>( width, height );
+#endif // BOOST
+	return NULL;
+}
+
+/// Barrier among a fixed number of threads, reusable for every generation.
+class Barrier
+{
+public:
+	/**
+	 * Initializes a new instance of the \see Barrier class.
+	 * @param n		number of threads that have to reach the barrier.
+	 */
+	Barrier( unsigned int n ) : n( n ), count( 0 ), phase( 0 ) { }
+
+	/// Wait until all the threads have reached the barrier.
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock( this->mtx );
+		unsigned long p = this->phase;
+		if ( ++this->count == this->n )
+		{
+			this->count = 0;
+			this->phase++;
+			this->cv.notify_all();
+		}
+		else this->cv.wait( lock, [this, p]{ return this->phase != p; } );
+	}
+
+private:
+	const unsigned int n;
+	unsigned int count;
+	unsigned long phase;
+	std::mutex mtx;
+	std::condition_variable cv;
+};
+
+/**
+ * Compute <em>iterations</em> generations of a layout. The calling thread copies the border and ends the generations,
+ * while the bands of rows are computed by <em>nw</em> threads ( by the calling thread if <em>nw</em> is zero ).
+ * The threads are created before the measure starts.
+ * @param l				the layout.
+ * @param height		number of rows of the grid.
+ * @param nw			number of threads.
+ * @param iterations	number of generations.
+ * @return	the time spent, in microseconds.
+ */
+inline double run_layout( Layout* l, size_t height, unsigned int nw, unsigned int iterations )
+{
+	Barrier barrier( nw + 1 );
+	std::vector<std::thread> workers;
+	for ( unsigned int t = 0; t < nw; t++ )
+		workers.push_back( std::thread( [l, height, nw, iterations, t, &barrier]
+		{
+			// Bands of rows of the same size, the first ones with one row more.
+			size_t band = height / nw, rest = height % nw;
+			size_t first = t * band + std::min( (size_t) t, rest );
+			size_t last = first + band + ( t < rest ? 1 : 0 );
+			for ( unsigned int k = 0; k < iterations; k++ )
+			{
+				// Wait for the border, compute the band and signal its end.
+				barrier.wait();
+				l->compute( first, last );
+				barrier.wait();
+			}
+		} ) );
+
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+	for ( unsigned int k = 0; k < iterations; k++ )
+	{
+		l->copy_border();
+		if ( nw > 0 )
+		{
+			barrier.wait();
+			barrier.wait();
+		}
+		else l->compute( 0, height );
+		l->end_generation();
+	}
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+	for ( unsigned int t = 0; t < nw; t++ )
+		workers[t].join();
+	return (double) std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
+}
+
+#endif //GAMEOFLIFE_LAYOUTS_H
@@ -0,0 +1,93 @@
+/**
+ *	@file checkpoint.h
+ *	@brief Header of \see Checkpointer class.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_CHECKPOINT_H
+#define GAMEOFLIFE_CHECKPOINT_H
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <atomic>
+
+#include "snapshot_publisher.h"
+#include "pattern_io.h"
+
+// Time waited by the checkpoint thread before looking again for a new generation, in milliseconds.
+#define CHECKPOINT_POLL_MS 1
+
+/**
+ * Writes checkpoints of the grid as pattern files from a background thread, reading the snapshots of a
+ * \see SnapshotPublisher: the workers never wait for the checkpoints, and the serial phase does not grow.
+ * A checkpoint is written as soon as a generation multiple of <em>every</em> is published; if the thread is late,
+ * it writes the latest generation instead. The generation is added to the path before the extension.
+ */
+class Checkpointer
+{
+public:
+	/**
+	 * Initializes a new instance of the \see Checkpointer class and starts its thread.
+	 * @param publisher		where to read the generations.
+	 * @param reader		index of the reader used in <em>publisher</em>.
+	 * @param path			path of the pattern files ( RLE, .cells or .mc depending on the extension ).
+	 * @param every			write a checkpoint every <em>every</em> generations.
+	 */
+	Checkpointer( SnapshotPublisher* publisher, unsigned int reader, const char* path, unsigned int every );
+
+	/// Destructor of the \see Checkpointer class; it writes the last due checkpoint and terminates the thread.
+	~Checkpointer();
+
+private:
+	SnapshotPublisher* publisher;
+	const unsigned int reader, every;
+	std::string path;
+	// Generation of the next checkpoint and number of checkpoints written.
+	unsigned int next, written;
+	std::atomic<bool> stop;
+	std::thread writer;
+
+	/// Body of the thread: write the checkpoints until the object is destroyed.
+	void write_loop();
+
+	/// Write the latest generation, if a checkpoint is due.
+	void write_due();
+};
+
+/// Implementation of \see PatternGrid on a \see Snapshot, used to export it.
+class SnapshotPattern : public PatternGrid
+{
+public:
+	/**
+	 * Initializes a new instance of the \see SnapshotPattern class.
+	 * @param s		the \see Snapshot to wrap.
+	 */
+	SnapshotPattern( const Snapshot& s );
+
+	size_t height() const override;
+	size_t width() const override;
+	// The snapshots are read-only: the cells are never set.
+	void set_alive( size_t i, size_t j, size_t count ) override;
+	const bool* row( size_t i ) override;
+
+private:
+	const Snapshot& s;
+};
+
+#endif //GAMEOFLIFE_CHECKPOINT_H
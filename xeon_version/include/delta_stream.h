@@ -0,0 +1,200 @@
+/**
+ *	@file delta_stream.h
+ *	@brief Header of \see DeltaWriter and \see DeltaReader classes.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_DELTA_STREAM_H
+#define GAMEOFLIFE_DELTA_STREAM_H
+
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "grid.h"
+#include "pattern_io.h"
+
+// Identifier and version of the delta files.
+#define DELTA_MAGIC "GOLDELTA"
+#define DELTA_VERSION 1
+// Cells of a word of the bitmap of the grid.
+#define DELTA_WORD_BITS 64
+// Number of generations that can wait to be encoded.
+#define DELTA_QUEUE_SIZE 16
+#define DEFAULT_KEYFRAME_EVERY 100
+
+/// Cells changed by a generation in a word of DELTA_WORD_BITS cells of the \see Grid, border included.
+struct DeltaWord
+{
+	DeltaWord( unsigned long long word, unsigned long long mask ) : word(word), mask(mask) { }
+
+	/// Index of the word: it contains the cells from word * DELTA_WORD_BITS.
+	unsigned long long word;
+	/// Bit b is set if the cell word * DELTA_WORD_BITS + b changed.
+	unsigned long long mask;
+};
+
+/// Changes of a generation, as recorded by the kernel: the words are not sorted, and the same word can appear more times.
+typedef std::vector<DeltaWord> DeltaBuffer;
+
+/**
+ * Writes every generation of the grid into a file as the cells that changed ( the XOR of the reading and writing arrays ),
+ * collected by the kernel. A background thread sorts the changes, removes the border, encodes them and writes them,
+ * so the serial phase only hands over the buffer of the changes; it waits only if DELTA_QUEUE_SIZE generations are
+ * waiting to be written. The thread applies the changes to its own bitmap of the grid, from which it writes a keyframe
+ * ( the whole grid ) every <em>keyframe_every</em> generations, or when the keyframe is smaller, instead of the changes.
+ *
+ * The file starts with DELTA_MAGIC, the version and the keyframe interval ( 32 bits ) and the grid width and height
+ * ( 64 bits, border excluded ), followed by a record for each generation: the type ( 'K' keyframe or 'D' changes ),
+ * the generation ( 32 bits ), the size of the payload ( 64 bits ) and the payload. All the numbers are little-endian.
+ * The payload of a keyframe is the bitmap of the grid with the border, in words of DELTA_WORD_BITS cells; the payload
+ * of the changes is the list of the changed words, each one as the distance from the previous word ( varint ), a byte
+ * whose bit k tells if the k-th byte of the mask is not zero, and the bytes of the mask that are not zero.
+ */
+class DeltaWriter
+{
+public:
+	/**
+	 * Initializes a new instance of the \see DeltaWriter class, writing the current configuration as the first keyframe, and starts its thread.
+	 * @param g					the \see Grid object, in its initial configuration.
+	 * @param path				path of the output file.
+	 * @param keyframe_every	number of generations between two keyframes.
+	 */
+	DeltaWriter( Grid* g, const char* path, unsigned int keyframe_every );
+
+	/**
+	 * Queue the changes of a generation to be written.
+	 * @param generation	index of the generation, from one; the generations have to be recorded in order.
+	 * @param changes		changes of the generation; it is replaced by an empty buffer.
+	 */
+	void record( unsigned int generation, DeltaBuffer& changes );
+
+	/// Destructor of the \see DeltaWriter class; it waits that all the generations are written.
+	~DeltaWriter();
+
+private:
+	std::string path;
+	FILE* f;
+	const unsigned int keyframe_every;
+	// Bitmap of the grid after the last written generation, and bitmap of the cells that are not in the border.
+	std::vector<unsigned long long> state, interior;
+	std::vector<unsigned char> payload;
+	unsigned long long bytes, keyframes, generations;
+	bool stop;
+
+	std::vector<DeltaBuffer*> free_buffers;
+	std::deque< std::pair<unsigned int, DeltaBuffer*> > queue;
+	std::mutex mux;
+	std::condition_variable cv_free, cv_queue;
+	std::thread writer;
+
+	/// Body of the thread: encode and write the queued generations until the object is destroyed.
+	void write_loop();
+
+	/**
+	 * Apply the changes of a generation to the bitmap and write them, or the keyframe.
+	 * @param generation	index of the generation.
+	 * @param changes		changes of the generation.
+	 */
+	void encode( unsigned int generation, DeltaBuffer& changes );
+
+	/**
+	 * Write a record.
+	 * @param type			'K' for a keyframe, 'D' for changes.
+	 * @param generation	index of the generation.
+	 * @param data			payload of the record.
+	 * @param size			size of the payload.
+	 */
+	void write_record( char type, unsigned int generation, const void* data, unsigned long long size );
+};
+
+/**
+ * Reads a file written by \see DeltaWriter and reconstructs any of its generations, starting from the nearest
+ * previous keyframe and applying the changes of the following generations ( or the changes after the current
+ * generation, if it is nearer ). As a \see PatternGrid, the current generation can be exported with \see save_pattern.
+ */
+class DeltaReader : public PatternGrid
+{
+public:
+	/**
+	 * Initializes a new instance of the \see DeltaReader class, reading the index of the records of the file.
+	 * @param path		path of the delta file.
+	 */
+	DeltaReader( const char* path );
+
+	/**
+	 * Return the index of the last generation of the file.
+	 * @return	the index of the last generation.
+	 */
+	unsigned int last_generation() const;
+
+	/**
+	 * Return the number of keyframes of the file.
+	 * @return	the number of keyframes.
+	 */
+	unsigned int keyframes() const;
+
+	/**
+	 * Reconstruct a generation, which becomes the current one.
+	 * @param generation	index of the generation.
+	 * @return	<code>false</code> if the file does not contain it.
+	 */
+	bool seek( unsigned int generation );
+
+	size_t height() const override;
+	size_t width() const override;
+	// The generations are read-only: the cells are never set.
+	void set_alive( size_t i, size_t j, size_t count ) override;
+	const bool* row( size_t i ) override;
+
+	/// Destructor of the \see DeltaReader class.
+	~DeltaReader();
+
+private:
+	/// Position of a record in the file.
+	struct Record
+	{
+		char type;
+		unsigned int generation;
+		long offset;
+		unsigned long long size;
+	};
+
+	FILE* f;
+	size_t rows, cols;
+	std::vector<Record> records;
+	// Bitmap of the current generation, with the border, and the row returned by \see row.
+	std::vector<unsigned long long> state;
+	bool* line;
+	// Index of the record of the current generation, -1 if none.
+	long current;
+
+	/**
+	 * Apply a record to the bitmap.
+	 * @param r		index of the record.
+	 */
+	void apply( size_t r );
+};
+
+#endif //GAMEOFLIFE_DELTA_STREAM_H
@@ -0,0 +1,175 @@
+/**
+ *	@file frame_ring.h
+ *	@brief Header of \see FrameRing and \see FrameRingReader classes.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_FRAME_RING_H
+#define GAMEOFLIFE_FRAME_RING_H
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+#include "snapshot_publisher.h"
+
+// Identifier and version of the layout of the shared memory.
+#define FRAME_RING_MAGIC "GOLRING"
+#define FRAME_RING_VERSION 1
+#define DEFAULT_FRAME_RING_SLOTS 8
+// The header and the slots start on different cache lines.
+#define FRAME_RING_ALIGNMENT 64
+// Time waited by the exporting thread before looking again for a new generation, in microseconds.
+#define FRAME_RING_POLL_US 100
+
+/**
+ * Header at the beginning of the shared memory, followed by <em>slots</em> slots of <em>slot_bytes</em> bytes.
+ * Each slot starts with a \see FrameSlot, followed by a gray frame of width x height bytes, row by row.
+ */
+struct FrameRingHeader
+{
+	/// FRAME_RING_MAGIC, written when the rest of the header is ready.
+	char magic[8];
+	uint32_t version, slots;
+	/// Size of the frames, in pixels, and side of the block of cells of each pixel.
+	uint64_t width, height, scale;
+	/// Size of a slot, header included, and offset of the first slot from the beginning of the shared memory.
+	uint64_t slot_bytes, slots_offset;
+	/// Number of frames written: the latest one is in the slot ( frames - 1 ) % slots.
+	std::atomic<uint64_t> frames;
+	/// Different from zero when the simulation has ended and no other frame will be written.
+	std::atomic<uint32_t> finished;
+};
+
+/// Header of a slot of the ring, protected by a sequence lock.
+struct FrameSlot
+{
+	/// Odd while the frame is written; it changes every time the slot is reused.
+	std::atomic<uint64_t> sequence;
+	/// Generation of the frame.
+	uint64_t generation;
+};
+
+/**
+ * Exports the generations of the grid into a POSIX shared memory ring of frames, that any local process can map
+ * ( see \see FrameRingReader ). A background thread reads the snapshots of a \see SnapshotPublisher and writes each
+ * new generation into the next slot, optionally downsampled: each pixel is the density of a block of scale x scale cells.
+ * The slots are protected by sequence locks, so the simulation never waits for the consumers: a consumer that is
+ * too slow finds the sequence of its slot changed and reads a more recent frame.
+ */
+class FrameRing
+{
+public:
+	/**
+	 * Initializes a new instance of the \see FrameRing class, creating the shared memory, and starts its thread.
+	 * @param publisher		where to read the generations.
+	 * @param reader		index of the reader used in <em>publisher</em>.
+	 * @param name			name of the shared memory object ( as "/gol" ).
+	 * @param scale			side of the block of cells of each pixel.
+	 * @param slots			number of frames kept in the ring.
+	 * @param replace		<code>true</code> to remove an existing shared memory object with the same name;
+	 * 						otherwise it is an error, since it can be the ring of another simulation.
+	 */
+	FrameRing( SnapshotPublisher* publisher, unsigned int reader, const char* name, unsigned int scale, unsigned int slots, bool replace = false );
+
+	/// Destructor of the \see FrameRing class; it marks the ring as finished and removes its name.
+	~FrameRing();
+
+private:
+	SnapshotPublisher* publisher;
+	const unsigned int reader;
+	std::string name;
+	FrameRingHeader* header;
+	unsigned char* memory;
+	size_t size;
+	// Generation of the last frame written.
+	unsigned int last;
+	std::atomic<bool> stop;
+	std::thread writer;
+
+	/// Body of the thread: export the new generations until the object is destroyed.
+	void write_loop();
+
+	/// Write the latest generation into the next slot, if it is a new one.
+	void write_latest();
+};
+
+/// Maps a ring of frames written by \see FrameRing, in another process.
+class FrameRingReader
+{
+public:
+	/**
+	 * Initializes a new instance of the \see FrameRingReader class, mapping the shared memory read-only.
+	 * @param name		name of the shared memory object.
+	 */
+	FrameRingReader( const char* name );
+
+	/**
+	 * Return the header of the ring.
+	 * @return	the header of the ring.
+	 */
+	inline const FrameRingHeader* info() const
+	{
+		return this->header;
+	}
+
+	/**
+	 * Start reading the latest frame in place: the frame can be read until \see end_read tells whether it is valid.
+	 * @param generation	generation of the frame.
+	 * @param token			value to give to \see end_read.
+	 * @return	the frame, <code>NULL</code> if no frame has been written yet.
+	 */
+	const unsigned char* begin_read( uint64_t& generation, uint64_t& token ) const;
+
+	/**
+	 * Check that the frame given by \see begin_read has not been overwritten while it was read.
+	 * @param token		value returned by \see begin_read.
+	 * @return	<code>true</code> if the frame was read entirely before the writer reused its slot.
+	 */
+	bool end_read( uint64_t token ) const;
+
+	/**
+	 * Copy the latest valid frame.
+	 * @param frame			array of width x height bytes.
+	 * @param generation	generation of the frame.
+	 * @return	<code>false</code> if no frame has been written yet.
+	 */
+	bool copy_latest( unsigned char* frame, uint64_t& generation ) const;
+
+	/// Destructor of the \see FrameRingReader class.
+	~FrameRingReader();
+
+private:
+	const FrameRingHeader* header;
+	const unsigned char* memory;
+	size_t size;
+
+	/**
+	 * Return the header of a slot.
+	 * @param slot	index of the slot.
+	 * @return	the header of the slot, followed by its frame.
+	 */
+	inline const FrameSlot* slot_at( uint64_t slot ) const
+	{
+		return (const FrameSlot*) ( this->memory + this->header->slots_offset + slot * this->header->slot_bytes );
+	}
+};
+
+#endif //GAMEOFLIFE_FRAME_RING_H
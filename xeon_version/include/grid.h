@@ -61,6 +61,9 @@ public:
 	 */
 	void init( unsigned int seed );
 
+	/// Set all the cells of the reading array to <code>false</code>.
+	void clear();
+
 #if VECTORIZATION
 	/**
 	 * Set up this grid using random values.
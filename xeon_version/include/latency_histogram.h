@@ -0,0 +1,109 @@
+/**
+ *	@file latency_histogram.h
+ *	@brief Header of \see LatencyHistogram class.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_LATENCY_HISTOGRAM_H
+#define GAMEOFLIFE_LATENCY_HISTOGRAM_H
+
+#include <iostream>
+#include <string>
+#include <chrono>
+
+// Each power of two is split in 2^HISTOGRAM_SUB_BITS linear buckets, i.e. a relative error below 1 / 2^HISTOGRAM_SUB_BITS ( 3% ).
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+// Buckets needed to cover all the 64-bit values.
+#define HISTOGRAM_BUCKETS ( ( 64 - HISTOGRAM_SUB_BITS + 1 ) * HISTOGRAM_SUB_BUCKETS )
+
+/**
+ * Histogram of latencies with logarithmic buckets, as in HdrHistogram: the values smaller than HISTOGRAM_SUB_BUCKETS
+ * have their own bucket, while the others fall into one of the HISTOGRAM_SUB_BUCKETS linear buckets of their power of two.
+ * The buckets are a fixed array, so recording a value never allocates memory, and two histograms can be merged summing them.
+ */
+class LatencyHistogram
+{
+public:
+	/// Initializes a new, empty, instance of the \see LatencyHistogram class.
+	LatencyHistogram();
+
+	/**
+	 * Record a value.
+	 * @param value		the value, in nanoseconds.
+	 */
+	inline void record( unsigned long long value )
+	{
+		this->buckets[bucket_of( value )]++;
+		this->count++;
+		if ( value > this->max ) this->max = value;
+	}
+
+	/**
+	 * Record the interval between two time points.
+	 * @param t1	starting time.
+	 * @param t2	ending time.
+	 */
+	inline void record( std::chrono::high_resolution_clock::time_point t1, std::chrono::high_resolution_clock::time_point t2 )
+	{
+		this->record( (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>( t2 - t1 ).count() );
+	}
+
+	/**
+	 * Add the values of another histogram to this one.
+	 * @param h		the histogram to merge.
+	 * @return	this object.
+	 */
+	LatencyHistogram& operator+=( const LatencyHistogram& h );
+
+	/**
+	 * Return the value below which falls the given percentage of the recorded values,
+	 * i.e. the highest value of the bucket where the percentile falls.
+	 * @param percentile	percentage, between 0 and 100.
+	 * @return	the percentile, in nanoseconds; zero if the histogram is empty.
+	 */
+	unsigned long long percentile( double percentile ) const;
+
+	/**
+	 * Print the number of values, p50, p90, p99 and maximum, adding them also as section <em>name</em> of the metrics of the run.
+	 * @param name		name of the measured latency.
+	 */
+	void report( const char* name ) const;
+
+private:
+	/**
+	 * Return the index of the bucket of a value.
+	 * @param value		the value.
+	 * @return	the index of its bucket.
+	 */
+	static inline unsigned int bucket_of( unsigned long long value )
+	{
+		if ( value < HISTOGRAM_SUB_BUCKETS ) return (unsigned int) value;
+		unsigned int msb = 63 - (unsigned int) __builtin_clzll( value );
+		unsigned int shift = msb - HISTOGRAM_SUB_BITS;
+		return ( shift + 1 ) * HISTOGRAM_SUB_BUCKETS + (unsigned int) ( ( value >> shift ) - HISTOGRAM_SUB_BUCKETS );
+	}
+
+	unsigned long long buckets[HISTOGRAM_BUCKETS];
+	unsigned long long count, max;
+};
+
+/// Wall time of the generations of the run, from the dispatch of the first task to the end of end_generation.
+extern LatencyHistogram generation_latency;
+
+#endif //GAMEOFLIFE_LATENCY_HISTOGRAM_H
@@ -0,0 +1,96 @@
+/**
+ *	@file load_profile.h
+ *	@brief Header of \see LoadProfile class.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_LOAD_PROFILE_H
+#define GAMEOFLIFE_LOAD_PROFILE_H
+
+#include <iostream>
+#include <chrono>
+
+#define IMBALANCE_BINS 10
+
+/// Time accounting of a worker in a generation.
+struct WorkerSample
+{
+	/// Time spent computing tasks, in microseconds.
+	long busy;
+	/// Number of computed tasks.
+	unsigned int tasks;
+};
+
+/**
+ * This class records, for each generation, the work done by each worker and the time of the serial phase,
+ * in order to report the load imbalance at the end of the run.
+ * The buffers are allocated in advance and each worker writes only its own row, so no lock is needed.
+ */
+class LoadProfile
+{
+public:
+	/**
+	 * Initializes a new instance of the \see LoadProfile class.
+	 * @param nw			number of workers.
+	 * @param iterations	maximum number of generations.
+	 */
+	LoadProfile( unsigned int nw, unsigned int iterations );
+
+	/**
+	 * Account a task computed by a worker; it is called by the worker itself.
+	 * @param worker		worker identifier.
+	 * @param generation	index of the generation, starting from zero.
+	 * @param t1			starting time of the task.
+	 * @param t2			ending time of the task.
+	 */
+	inline void add_task( unsigned int worker, unsigned int generation,
+						  std::chrono::high_resolution_clock::time_point t1, std::chrono::high_resolution_clock::time_point t2 )
+	{
+		WorkerSample& s = this->samples[worker * this->iterations + generation];
+		s.busy += (long) std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
+		s.tasks++;
+	}
+
+	/**
+	 * Account a completed generation; it is called by the thread that executes the serial phase.
+	 * @param generation	index of the generation, starting from zero.
+	 * @param t1			starting time of the generation.
+	 * @param t2			starting time of the serial phase ( \see end_generation ).
+	 * @param t3			ending time of the generation.
+	 */
+	void add_generation( unsigned int generation, std::chrono::high_resolution_clock::time_point t1,
+						 std::chrono::high_resolution_clock::time_point t2, std::chrono::high_resolution_clock::time_point t3 );
+
+	/**
+	 * Print the load imbalance report: the max/mean busy ratio of the generations, the share of the serial phase
+	 * on the critical path and, for each worker, totals and the histogram of its busy fraction per generation.
+	 * The wait time of a worker is the part of the generation in which it was not computing.
+	 */
+	void report() const;
+
+	/// Destructor of the \see LoadProfile class.
+	~LoadProfile();
+
+private:
+	unsigned int nw, iterations, generations;
+	WorkerSample* samples;
+	// Total and serial time of each generation, in microseconds.
+	long *generation_time, *serial_time;
+};
+
+#endif //GAMEOFLIFE_LOAD_PROFILE_H
@@ -26,6 +26,9 @@
 
 #include "ff/farm.hpp"
 #include "task.h"
+#include "load_profile.h"
+#include "perf_counters.h"
+#include "tracer.h"
 #include "shared_functions.h"
 
 /// The Master coordinates the work of the \see Worker and performs the barrier on them at the end of each GOL iteration.
@@ -41,9 +44,25 @@ public:
 	 * @param start			start indexing to the Grid working area.
 	 * @param chunks		array of chunks size to assign to Workers.
 	 * @param num_tasks		number of task per Worker that it will generate for each generation.
+	 * @param recorder		where to record the statistics reduced from the tasks, <code>NULL</code> to not compute them.
+	 * @param profile		where to account the time of the generations, <code>NULL</code> to not account it.
+	 * @param perf			where to add the hardware counters of the Master thread, <code>NULL</code> to not count them.
+	 * @param trace			where to record the barriers and the end_generation phases, <code>NULL</code> to not trace them.
+	 * @param publisher		where to publish the completed generations, <code>NULL</code> if there are no readers.
+	 * @param deltas		where to record the changes collected from the Workers, <code>NULL</code> to not record them.
+	 * @param worker_changes	array of the <em>nw</em> buffers where the Workers append the cells changed by their tasks,
+	 * 							collected once per generation; <code>NULL</code> if the changes are not recorded.
 	 */
-	Master( ff::ff_loadbalancer* const lb, unsigned int nw, Grid* g, unsigned int iterations,
-			size_t start, size_t* chunks, unsigned int num_tasks );
+	Master( ff::ff_loadbalancer* const lb, unsigned int nw, Grid* g, unsigned int iterations, size_t start, size_t* chunks,
+			unsigned int num_tasks, StatsRecorder* recorder, LoadProfile* profile, PerfReport* perf, TraceBuffer* trace,
+			SnapshotPublisher* publisher, DeltaWriter* deltas = nullptr, DeltaBuffer* worker_changes = nullptr );
+
+	/**
+	 * FastFlow method of the \see ff::ff_node_t, executed by the Master thread before the first call of \see svc.
+	 * It opens the hardware counters of the thread, if they are requested.
+	 * @return	zero, i.e. no error.
+	 */
+	int svc_init();
 
 	/**
 	 * FastFlow method of the \see ff::ff_node_t.
@@ -51,8 +70,9 @@ public:
 	 * 		1. Distribute one task to each Worker.
 	 * 		2. When a Worker reply "DONE" the Master assigns it another task (On Demand).
 	 * 		   The task size is decreasing over time.
-	 * 		3. When all tasks are computed it executes the end_generation function on the Grid: swap, copyBorder, print.
-	 * 		4. IF ( the number of completed iterations is equal to <em>iterations</em> ). // End of GOL
+	 * 		3. When all tasks are computed it records the statistics reduced from the tasks, if enabled,
+	 * 		   and executes the end_generation function on the Grid: swap, copyBorder, print.
+	 * 		4. IF ( the number of completed iterations is equal to <em>iterations</em> OR a cycle stops the run ). // End of GOL
 	 * 			4.1 Send "End-Of-Stream" to all Workers.
 	 * 		4. Else
 	 * 			4.2 Start from point 1.
@@ -61,10 +81,19 @@ public:
 	 */
 	Task_t* svc( Task_t* task );
 
+	/**
+	 * FastFlow method of the \see ff::ff_node_t, executed by the Master thread at the end of the stream.
+	 * It adds the hardware counters of the thread to the report and closes them.
+	 */
+	void svc_end();
+
 private:
 	// Create a new task.
 	Task_t* create_new_task();
 
+	// Append the changes recorded by the Workers during the generation to changes, and clear them.
+	void collect_changes();
+
 	// Send one task of the current iteration to each worker; we know that #Tasks >= #Workers.
 	void send_one_task_x_worker();
 
@@ -73,14 +102,26 @@ private:
 
 	Grid* g;
 	size_t* chunks;
+	StatsRecorder* recorder;
+	GenerationStats stats;
+	LoadProfile* profile;
+	PerfReport* perf;
+	PerfCounters* counters;
+	TraceBuffer* trace;
+	SnapshotPublisher* publisher;
+	DeltaWriter* deltas;
+	DeltaBuffer changes;
+	DeltaBuffer* worker_changes;
 	ff::ff_loadbalancer* const lb;
 	const unsigned int iterations, num_workers, num_tasks;
 	const size_t start;
 	size_t start_chunk, end_chunk;
 	unsigned int completed_iterations, counter_complete_tasks, counter_sent_tasks;
-	long copyborder_time, barrier_time;
+	// Time of the end_generation and barrier phases ( only if \see take_all_time ).
+	TscAccumulator barrier_timer;
+	unsigned long long copyborder_time;
 	bool first_worker;
-	std::chrono::high_resolution_clock::time_point t1, t2;
+	std::chrono::high_resolution_clock::time_point t1, t2, generation_start;
 };
 
 #endif //GAMEOFLIFE_MASTER_H
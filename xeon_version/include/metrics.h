@@ -0,0 +1,115 @@
+/**
+ *	@file metrics.h
+ *	@brief Header of \see Metrics class.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_METRICS_H
+#define GAMEOFLIFE_METRICS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <chrono>
+
+/// This class collects the measures of a run ( configuration, phase times, generation times ) and writes them as a JSON record.
+class Metrics
+{
+public:
+	/**
+	 * Initializes a new instance of the \see Metrics class.
+	 * @param program	name of the executable.
+	 * @param width		number of grid columns.
+	 * @param height	number of grid rows.
+	 */
+	Metrics( const char* program, size_t width, size_t height );
+
+	/**
+	 * Add an entry to the configuration of the run.
+	 * @param name		name of the entry.
+	 * @param value		value of the entry.
+	 */
+	void set_config( const char* name, long value );
+
+	/**
+	 * Add a boolean entry to the configuration of the run.
+	 * @param name		name of the entry.
+	 * @param value		value of the entry.
+	 */
+	void set_config( const char* name, bool value );
+
+	/**
+	 * Add the time of a phase; if the phase is already present, the time is accumulated.
+	 * @param name		name of the phase, as printed by \see printTime.
+	 * @param duration	elapsed time, in microseconds.
+	 */
+	void add_phase( const char* name, long duration );
+
+	/**
+	 * Append the time of the next generation.
+	 * @param duration	elapsed time, in microseconds.
+	 */
+	void add_generation( long duration );
+
+	/**
+	 * Append the time of the next generation.
+	 * @param t1	starting time of the generation.
+	 * @param t2	ending time of the generation.
+	 */
+	void add_generation( std::chrono::high_resolution_clock::time_point t1, std::chrono::high_resolution_clock::time_point t2 );
+
+	/**
+	 * Return the throughput of the run, computed on the time of the complete Game of Life.
+	 * @return	the number of cells computed per second, zero if the time is not known yet.
+	 */
+	double cells_per_second() const;
+
+	/**
+	 * Add a section to the record, written as it is; if the section is already present, it is replaced.
+	 * @param name		name of the section.
+	 * @param json		value of the section, a valid JSON value.
+	 */
+	void set_section( const char* name, const std::string& json );
+
+	/**
+	 * Write the JSON record, together with cells per second and peak resident set size.
+	 * @param path	path of the output file.
+	 */
+	void write( const char* path ) const;
+
+private:
+	std::string program;
+	size_t width, height;
+	std::vector< std::pair<std::string, std::string> > config;
+	std::vector< std::pair<std::string, long> > phases;
+	std::vector<long> generations;
+	std::vector< std::pair<std::string, std::string> > sections;
+};
+
+/// Metrics of the running process, fed by \see printTime; <code>NULL</code> if they are not requested.
+extern Metrics* run_metrics;
+
+/**
+ * Quote a string for a JSON document, escaping the quotes, the backslashes and the control characters.
+ * @param s		the string.
+ * @return	the JSON string, quotes included.
+ */
+std::string json_string( const std::string& s );
+
+#endif //GAMEOFLIFE_METRICS_H
@@ -0,0 +1,123 @@
+/**
+ *	@file pattern_io.h
+ *	@brief Header of the functions that import and export GOL patterns ( RLE, plaintext .cells and Macrocell ).
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_PATTERN_IO_H
+#define GAMEOFLIFE_PATTERN_IO_H
+
+#include <iostream>
+
+#include "grid.h"
+
+/// Supported pattern file formats.
+enum PatternFormat
+{
+	RLE_FORMAT, /**< run length encoded format ( .rle ). */
+	CELLS_FORMAT, /**< plaintext format ( .cells ). */
+	MACROCELL_FORMAT /**< Golly quadtree format ( .mc ). */
+};
+
+/**
+ * Abstract view of a 2D toroidal grid, without border, used by the pattern parsers and writers.
+ * The parsers only set the alive cells, so the grid has to be cleared before loading a pattern.
+ */
+class PatternGrid
+{
+public:
+	/**
+	 * Return the number of grid rows.
+	 * @return	the number of grid rows.
+	 */
+	virtual size_t height() const = 0;
+
+	/**
+	 * Return the number of grid columns.
+	 * @return	the number of grid columns.
+	 */
+	virtual size_t width() const = 0;
+
+	/**
+	 * Set to <code>true</code> <em>count</em> consecutive cells of the i-th row, starting from the j-th column.
+	 * The run never crosses the end of the row.
+	 * @param i			row index.
+	 * @param j			column index of the first cell.
+	 * @param count		number of cells to set.
+	 */
+	virtual void set_alive( size_t i, size_t j, size_t count ) = 0;
+
+	/**
+	 * Return the i-th row of the grid; the pointer is valid until the next call.
+	 * @param i			row index.
+	 * @return	the array of <em>width()</em> cells of the row.
+	 */
+	virtual const bool* row( size_t i ) = 0;
+
+	virtual ~PatternGrid() { }
+};
+
+/// Implementation of \see PatternGrid on the reading array of a \see Grid object.
+class GridPattern : public PatternGrid
+{
+public:
+	/**
+	 * Initializes a new instance of the \see GridPattern class.
+	 * @param g		the \see Grid object to wrap.
+	 */
+	GridPattern( Grid* g );
+
+	size_t height() const override;
+	size_t width() const override;
+	void set_alive( size_t i, size_t j, size_t count ) override;
+	const bool* row( size_t i ) override;
+
+private:
+	Grid* g;
+};
+
+/**
+ * Detect the format of a pattern file from its extension ( .rle, .cells, .mc ).
+ * If the extension is unknown, the first meaningful line of the file is inspected.
+ * @param path		path of the pattern file.
+ * @return	the detected format.
+ */
+PatternFormat pattern_format( const char* path );
+
+/**
+ * Read a pattern file and place it into the grid, with its top-left corner at the given offset.
+ * The file is parsed as a stream and only the runs of alive cells are forwarded to the grid,
+ * so no dense copy of the pattern is ever built. Cells falling outside the grid wrap around
+ * following the logic of the 2D toroidal grid. The position stored by \see save_pattern into
+ * RLE files ( "#CXRLE Pos=" ) is added to the offset.
+ * @param path			path of the pattern file.
+ * @param grid			grid where to place the pattern.
+ * @param row_offset	row where to place the top-left corner of the pattern.
+ * @param col_offset	column where to place the top-left corner of the pattern.
+ */
+void load_pattern( const char* path, PatternGrid& grid, size_t row_offset, size_t col_offset );
+
+/**
+ * Write the grid into a pattern file, choosing the format from its extension ( RLE by default ).
+ * RLE and .cells files contain only the bounding box of the alive cells, so sparse grids stay small.
+ * @param path			path of the pattern file.
+ * @param grid			grid to export.
+ */
+void save_pattern( const char* path, PatternGrid& grid );
+
+#endif //GAMEOFLIFE_PATTERN_IO_H
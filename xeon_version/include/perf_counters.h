@@ -0,0 +1,150 @@
+/**
+ *	@file perf_counters.h
+ *	@brief Header of \see PerfCounters and \see PerfReport classes.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_PERF_COUNTERS_H
+#define GAMEOFLIFE_PERF_COUNTERS_H
+
+#include <iostream>
+#include <mutex>
+
+// Hardware events counted: cycles, instructions, LLC misses and branch misses.
+#define PERF_EVENTS 4
+// Bytes moved from memory by each LLC miss, used to estimate the memory traffic.
+#define CACHE_LINE_BYTES 64
+
+/**
+ * Phases of a run in which the counters are accumulated:
+ * PERF_KERNEL	the workers compute their tasks;
+ * PERF_SPIN	the workers wait for the next task ( the busy-looping on their flag );
+ * PERF_BARRIER	the thread that owns the workers scatters the tasks and waits for their completion;
+ * PERF_SERIAL	the thread that owns the workers executes the serial phase ( \see end_generation ).
+ */
+enum PerfPhase { PERF_KERNEL, PERF_SPIN, PERF_BARRIER, PERF_SERIAL, PERF_PHASES };
+
+/// Values of the hardware events, together with the elapsed time, accumulated in a phase.
+struct PerfValues
+{
+	PerfValues();
+
+	/// Value of each hardware event.
+	unsigned long long count[PERF_EVENTS];
+	/// Elapsed time, in nanoseconds.
+	unsigned long long time;
+
+	/**
+	 * Add the values of another object to this one.
+	 * @param v		the values to add.
+	 * @return	this object.
+	 */
+	PerfValues& operator+=( const PerfValues& v );
+};
+
+/**
+ * Hardware counters of the calling thread, opened through perf_event_open as a single group,
+ * so that all the events are read at the same time.
+ * The thread marks the boundaries of its phases calling \see stop, which adds to a phase
+ * what has been counted since the previous boundary.
+ * It has to be created, used and destroyed by the thread that it measures.
+ */
+class PerfCounters
+{
+public:
+	/// Initializes a new instance of the \see PerfCounters class, opening the counters of the calling thread.
+	PerfCounters();
+
+	/**
+	 * Return if the counters have been opened; when the machine does not expose them ( e.g. a virtual machine ),
+	 * or perf_event_paranoid forbids their use, the other methods do nothing.
+	 * @return	<code>true</code> if the counters are available.
+	 */
+	bool available() const;
+
+	/**
+	 * Return the error that prevented the counters to be opened.
+	 * @return	the <em>errno</em> of perf_event_open, zero if they are available.
+	 */
+	int error() const;
+
+	/// Mark the beginning of a phase, discarding what has been counted so far.
+	void start();
+
+	/**
+	 * Mark the end of a phase, which is also the beginning of the next one.
+	 * @param phase		phase to which add what has been counted since the previous boundary.
+	 */
+	void stop( PerfPhase phase );
+
+	/**
+	 * Return the values accumulated in a phase.
+	 * @param phase		the phase.
+	 * @return	the accumulated values.
+	 */
+	const PerfValues& total( PerfPhase phase ) const;
+
+	/// Close the counters.
+	~PerfCounters();
+
+private:
+	/**
+	 * Read the current values of the counters, scaled if the kernel multiplexed them.
+	 * @param v		where to store the values.
+	 */
+	void read( PerfValues& v ) const;
+
+	// File descriptors of the events, -1 if the event is not supported; the first one is the group leader.
+	int fd[PERF_EVENTS];
+	// Position of each event in the group read, -1 if the event is not supported.
+	int slot[PERF_EVENTS];
+	int members, err;
+	PerfValues last, totals[PERF_PHASES];
+};
+
+/// This class sums the \see PerfCounters of all threads and prints them per phase, adding them also to the metrics of the run.
+class PerfReport
+{
+public:
+	/// Initializes a new instance of the \see PerfReport class.
+	PerfReport();
+
+	/**
+	 * Add the counters of a thread; it is called by each thread before destroying its counters.
+	 * @param c		counters of the thread.
+	 */
+	void add( const PerfCounters& c );
+
+	/**
+	 * Print, for each phase, the hardware events, the IPC and the memory traffic estimated from the LLC misses,
+	 * in bytes per cell and in GB/s; the same values are added to the metrics of the run, if they are collected.
+	 * If no thread could open its counters, it only prints a warning.
+	 * @param cells		number of computed cells, i.e. grid size multiplied by the number of generations.
+	 */
+	void report( unsigned long long cells ) const;
+
+private:
+	std::mutex mutex;
+	PerfValues totals[PERF_PHASES];
+	// Number of threads that contributed to each phase.
+	unsigned int threads[PERF_PHASES];
+	unsigned int missing;
+	int err;
+};
+
+#endif //GAMEOFLIFE_PERF_COUNTERS_H
@@ -0,0 +1,65 @@
+/**
+ *	@file probes.h
+ *	@brief USDT static probes placed at generation, task and barrier boundaries.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_PROBES_H
+#define GAMEOFLIFE_PROBES_H
+
+/*
+ * When the USDT flag is on, each probe is a single nop instruction plus a note in the ELF file ( provider "gol" ),
+ * so it costs nothing until a tracer attaches to it; for example:
+ * 		bpftrace -e 'usdt:./build/GOL_thread:gol:task_end { @[arg0] = count(); }' -p PID
+ * 		perf probe -x build/GOL_thread sdt_gol:barrier_enter
+ * Without the flag the probes disappear, so <sys/sdt.h> ( systemtap-sdt-dev ) is needed only to enable them.
+ */
+#if USDT
+#include <sys/sdt.h>
+
+/// A generation starts: generation index ( from one ).
+#define PROBE_GENERATION_START( generation ) DTRACE_PROBE1( gol, generation_start, generation )
+/// A generation ends, after end_generation: generation index ( from one ).
+#define PROBE_GENERATION_END( generation ) DTRACE_PROBE1( gol, generation_end, generation )
+/// A task is assigned to a worker: worker identifier, starting and ending index of the task.
+#define PROBE_TASK_DISPATCH( worker, start, end ) DTRACE_PROBE3( gol, task_dispatch, worker, start, end )
+/// A worker starts computing a task: worker identifier, starting and ending index of the task.
+#define PROBE_TASK_START( worker, start, end ) DTRACE_PROBE3( gol, task_start, worker, start, end )
+/// A worker ends computing a task: worker identifier, starting and ending index of the task.
+#define PROBE_TASK_END( worker, start, end ) DTRACE_PROBE3( gol, task_end, worker, start, end )
+/// The thread that scatters the tasks receives a completed task: worker identifier.
+#define PROBE_TASK_COMPLETE( worker ) DTRACE_PROBE1( gol, task_complete, worker )
+/// The thread that scatters the tasks enters the barrier: generation index ( from one ).
+#define PROBE_BARRIER_ENTER( generation ) DTRACE_PROBE1( gol, barrier_enter, generation )
+/// The thread that scatters the tasks exits the barrier: generation index ( from one ).
+#define PROBE_BARRIER_EXIT( generation ) DTRACE_PROBE1( gol, barrier_exit, generation )
+
+#else
+
+#define PROBE_GENERATION_START( generation )
+#define PROBE_GENERATION_END( generation )
+#define PROBE_TASK_DISPATCH( worker, start, end )
+#define PROBE_TASK_START( worker, start, end )
+#define PROBE_TASK_END( worker, start, end )
+#define PROBE_TASK_COMPLETE( worker )
+#define PROBE_BARRIER_ENTER( generation )
+#define PROBE_BARRIER_EXIT( generation )
+
+#endif // USDT
+
+#endif //GAMEOFLIFE_PROBES_H
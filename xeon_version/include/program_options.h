@@ -26,6 +26,8 @@
 #include <iostream>
 #include <assert.h>
 #include <algorithm>
+#include <string>
+#include <vector>
 
 /// This class mangages the program options.
 class ProgramOptions
@@ -78,6 +80,15 @@ public:
 	 */
 	long get_number( const std::string& option1, const std::string& option2, long default_value ) const;
 
+	/**
+	 * Retrieve the comma separated list of values of the option we want to retrieve.
+	 * A value written as FIRST:STEP:LAST is expanded into the numbers from FIRST to LAST with the given step.
+	 * @param option			option to looking for and to retrieve.
+	 * @param default_value		list to use if the option is not found.
+	 * @return					the values of the list.
+	 */
+	std::vector<std::string> get_list( const std::string& option, const char* default_value ) const;
+
 private:
 	int argc;
 	char** argv;
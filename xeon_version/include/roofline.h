@@ -0,0 +1,112 @@
+/**
+ *	@file roofline.h
+ *	@brief Header of \see Roofline class.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_ROOFLINE_H
+#define GAMEOFLIFE_ROOFLINE_H
+
+#include <iostream>
+#include <string>
+
+#include "metrics.h"
+
+// Number of doubles of each array of the triad microkernel ( 32 MB ), much larger than the last level cache.
+#define ROOFLINE_ELEMENTS (1 << 22)
+// Iterations of the integer microkernel executed by each thread.
+#define ROOFLINE_INT_ITERATIONS (1 << 22)
+// Repetitions of each microkernel, the best one is kept as in STREAM.
+#define ROOFLINE_REPS 5
+// Integer operations of a cell: seven additions of the neighbours, two comparisons, one and, one or.
+#define GOL_OPS_PER_CELL 11
+
+/**
+ * Model of the work of a cell for a kernel: the bytes of each array that it moves from and to memory, counting one byte
+ * per cell for each array read or written and one for the write-allocate of each array written, the neighbour rows
+ * being cache hits, and the integer operations.
+ */
+struct KernelModel
+{
+	/// Name of the kernel.
+	std::string kernel;
+	/// Bytes per cell read, written and loaded by the write-allocate.
+	double read, write, allocate;
+	/// Integer operations per cell.
+	double ops;
+
+	/**
+	 * Return the bytes per cell moved by the kernel.
+	 * @return	the sum of the read, written and write-allocated bytes.
+	 */
+	double bytes() const { return this->read + this->write + this->allocate; }
+};
+
+/**
+ * Build the model of the kernel used by the run.
+ * @param vectorization		<code>true</code> if the generations are computed with the vectorized kernel.
+ * @param statistics		<code>true</code> if the kernel also computes the statistics.
+ * @param deltas			<code>true</code> if the changes of each generation are recorded.
+ * @param out_of_core		<code>true</code> if the grid is streamed band by band from the backing file.
+ * @return	the model of the kernel.
+ */
+KernelModel kernel_model( bool vectorization, bool statistics, bool deltas, bool out_of_core );
+
+/**
+ * This class measures the roofs of the machine with STREAM-like microkernels, i.e. the sustainable memory bandwidth
+ * ( triad ) and the peak integer throughput, and compares them with the throughput of the GOL run,
+ * reporting how far the kernel is from the memory and the compute limit.
+ */
+class Roofline
+{
+public:
+	/**
+	 * Initializes a new instance of the \see Roofline class, running the microkernels and printing the roofs.
+	 * @param nt		number of threads that run the microkernels, i.e. the threads of the GOL run.
+	 * @param model		model of the kernel of the run, see \see kernel_model.
+	 */
+	Roofline( unsigned int nt, const KernelModel& model );
+
+	/**
+	 * Replace the bytes per cell of the model with the traffic measured by the hardware counters of the kernel.
+	 * @param bytes_per_cell	bytes moved from memory per computed cell ( LLC misses times the cache line ).
+	 */
+	void set_measured_traffic( double bytes_per_cell );
+
+	/**
+	 * Print the bytes per cell, telling if they are measured or modelled, the cells per second and the percentage of
+	 * the bandwidth and of the compute roof, adding them also as "roofline" section to the metrics.
+	 * @param metrics	metrics of the run, from which the cells per second are computed.
+	 */
+	void report( Metrics& metrics ) const;
+
+private:
+	unsigned int nt;
+	KernelModel model;
+	// Bytes per cell measured by the hardware counters, negative if they are not available.
+	double measured_bytes;
+	// Sustainable memory bandwidth, in bytes per second.
+	double bandwidth;
+	// Peak integer throughput, in operations per second.
+	double int_ops;
+};
+
+/// Roofs of the machine, measured at the start of the run; <code>NULL</code> if the roofline mode is not requested.
+extern Roofline* run_roofline;
+
+#endif //GAMEOFLIFE_ROOFLINE_H
@@ -30,12 +30,71 @@
 
 #include "program_options.h"
 #include "grid.h"
+#include "pattern_io.h"
+#include "statistics.h"
+#include "metrics.h"
+#include "roofline.h"
+#include "tsc_timer.h"
+#include "latency_histogram.h"
+#include "snapshot_publisher.h"
+#include "checkpoint.h"
+#include "frame_ring.h"
+#include "delta_stream.h"
 #if DEBUG
 #include "matrix.h"
 #endif // DEBUG
 
 #define MAX_PRINTABLE_GRID 32
 #define MIN_BLOCK_SIZE 1024
+#define DEFAULT_BAND_ROWS 256
+#define DEFAULT_CHECKPOINT_EVERY 100
+
+/// Optional settings, retrieved from the program options, that enable additional features of the application.
+struct Settings
+{
+	Settings() : store_path(NULL), band_rows(DEFAULT_BAND_ROWS), pattern_path(NULL), pattern_row(0), pattern_col(0), export_path(NULL), stats_path(NULL), stop_on_cycle(false), metrics_path(NULL), latency(false), imbalance(false), perf(false), trace_path(NULL), roofline(false), checkpoint_path(NULL), checkpoint_every(DEFAULT_CHECKPOINT_EVERY), shm_name(NULL), shm_scale(1), shm_slots(DEFAULT_FRAME_RING_SLOTS), shm_replace(false), delta_path(NULL), keyframe_every(DEFAULT_KEYFRAME_EVERY) { }
+
+	/// Path of the backing file used by the out-of-core version, <code>NULL</code> to keep the grid in memory.
+	const char* store_path;
+	/// Number of rows of each band streamed through memory by the out-of-core version.
+	size_t band_rows;
+	/// Path of the pattern file ( RLE, .cells or Macrocell ) used to initialize the grid, <code>NULL</code> for a random grid.
+	const char* pattern_path;
+	/// Row and column where to place the top-left corner of the pattern.
+	size_t pattern_row, pattern_col;
+	/// Path of the pattern file where to export the final configuration, <code>NULL</code> to not export it.
+	const char* export_path;
+	/// Path of the file where to write the statistics of each generation, <code>NULL</code> to not compute them.
+	const char* stats_path;
+	/// If <code>true</code>, the computation ends as soon as the grid falls into a cycle.
+	bool stop_on_cycle;
+	/// Path of the JSON file where to write the metrics of the run, <code>NULL</code> to not collect them.
+	const char* metrics_path;
+	/// If <code>true</code>, the percentiles of the latency of the generations are printed at the end of the run.
+	bool latency;
+	/// If <code>true</code>, the parallel versions account the work of each worker and print the load imbalance report.
+	bool imbalance;
+	/// If <code>true</code>, the in-memory versions count the hardware events of each thread per phase and print them.
+	bool perf;
+	/// Path of the Chrome trace JSON file where the parallel versions write the timeline of their threads, <code>NULL</code> to not trace them.
+	const char* trace_path;
+	/// If <code>true</code>, the roofs of the machine are measured before the run and compared with its throughput.
+	bool roofline;
+	/// Path of the pattern files where a background thread writes the checkpoints of the grid, <code>NULL</code> to not write them.
+	const char* checkpoint_path;
+	/// Number of generations between two checkpoints.
+	unsigned int checkpoint_every;
+	/// Name of the shared memory where a background thread exports the frames of the generations, <code>NULL</code> to not export them.
+	const char* shm_name;
+	/// Side of the block of cells of each pixel of the exported frames, and number of frames kept in the shared memory.
+	unsigned int shm_scale, shm_slots;
+	/// <code>true</code> to remove an existing shared memory object with the same name, as the ring of a crashed run.
+	bool shm_replace;
+	/// Path of the file where to write the cells changed by each generation, <code>NULL</code> to not record them.
+	const char* delta_path;
+	/// Number of generations between two keyframes of the delta file.
+	unsigned int keyframe_every;
+};
 
 inline unsigned long long pow3( unsigned long long x )
 {
@@ -73,42 +132,163 @@ void compute_generation( Grid* g, size_t start, size_t end );
 void compute_generation_vect( Grid* g, int* numNeighbours, size_t start, size_t end );
 #endif // VECTORIZATION
 
+/**
+ * Version of \see compute_generation that also accumulates the births and deaths of the working area into <em>stats</em>.
+ * The counters are kept in registers and added to <em>stats</em> only at the end.
+ * @param g					shared object of \see Grid class.
+ * @param start				index of starting working area.
+ * @param end				index of ending working area.
+ * @param stats				statistics of the worker.
+ */
+void compute_generation( Grid* g, size_t start, size_t end, GenerationStats& stats );
+
+#if VECTORIZATION
+/**
+ * Vectorized version of \see compute_generation that also accumulates the births and deaths of the working area into <em>stats</em>.
+ * @param g					shared object of \see Grid class.
+ * @param numNeighbours		array where to store the computed neighbours counting.
+ * @param start				index of starting working area.
+ * @param end				index of ending working area.
+ * @param stats				statistics of the worker.
+ */
+void compute_generation_vect( Grid* g, int* numNeighbours, size_t start, size_t end, GenerationStats& stats );
+#endif // VECTORIZATION
+
+/**
+ * Version of \see compute_generation that also records the cells that changed into <em>changes</em>.
+ * The working area is computed in blocks aligned to the words of DELTA_WORD_BITS cells, and a word is added
+ * to <em>changes</em> only if some of its cells changed.
+ * @param g					shared object of \see Grid class.
+ * @param start				index of starting working area.
+ * @param end				index of ending working area.
+ * @param changes			changes of the worker.
+ */
+void compute_generation( Grid* g, size_t start, size_t end, DeltaBuffer& changes );
+
+/**
+ * Record into <em>changes</em> the cells of the working area that changed, after one of the other kernels computed it.
+ * @param g					shared object of \see Grid class.
+ * @param start				index of starting working area.
+ * @param end				index of ending working area.
+ * @param changes			changes of the worker.
+ */
+void record_changes( Grid* g, size_t start, size_t end, DeltaBuffer& changes );
+
+/**
+ * Compute a generation on the working area, choosing the kernel depending on the vectorization flag and on the statistics.
+ * @param g					shared object of \see Grid class.
+ * @param numNeighbours		array used by the vectorized kernel, it can be <code>NULL</code> if <em>vectorization</em> is <code>false</code>.
+ * @param vectorization		<code>true</code> if the vectorized kernel has to be used.
+ * @param start				index of starting working area.
+ * @param end				index of ending working area.
+ * @param stats				statistics of the worker, <code>NULL</code> to not compute them.
+ * @param changes			changes of the worker, <code>NULL</code> to not record them.
+ */
+void compute_chunk( Grid* g, int* numNeighbours, bool vectorization, size_t start, size_t end, GenerationStats* stats, DeltaBuffer* changes = NULL );
+
 /**
  * Sequential version of GOL
  * @param g					the \see Grid object.
  * @param iterations		number of iterations.
  * @param vectorization		<code>true</code> if the code has to be vectorized.
+ * @param settings			optional settings of the application.
  * @return	<code>true</code> if the result of GOL is correct, <code>false</code> otherwise.
  */
-bool sequential_version( Grid* g, unsigned int iterations, bool vectorization );
+bool sequential_version( Grid* g, unsigned int iterations, bool vectorization, const Settings& settings );
+
+/**
+ * Out-of-core version of GOL, where the grid is kept in a backing file and streamed through memory band by band.
+ * @param settings			settings containing the backing file path and the band size.
+ * @param vectorization, width, height, seed, iterations	external variables.
+ * @return	<code>true</code> if the result of GOL is correct, <code>false</code> otherwise.
+ */
+bool out_of_core_version( const Settings& settings, bool vectorization, size_t width, size_t height, unsigned int seed, unsigned int iterations );
+
+/// <code>true</code> if the copy border and barrier phases are measured: TAKE_ALL_TIME flag on or metrics JSON requested.
+extern bool take_all_time;
 
 /**
  * It is the phase that we decided to not parallelize.
- * This includes: swap(), copyBorder() and print().
+ * This includes: swap(), copyBorder(), print() and the publication of the generation to the readers.
  * So this phase is executed by the last thread that reached the barrier
  * at the end of the computation of a generation.
  * @param g						the \see Grid object.
  * @param current_iteration		current GOL iteration, needed during DEBUG.
- * @return	time needed to compute it, in microseconds.
+ * @param publisher				where to publish the generation, <code>NULL</code> if there are no readers.
+ * @return	time needed to compute it, in ticks of \see TscTimer ( only if \see take_all_time ).
  */
-long end_generation( Grid* g, unsigned int current_iteration );
+unsigned long long end_generation( Grid* g, unsigned int current_iteration, SnapshotPublisher* publisher = NULL );
 
 /**
  * Shows the program options if flag "--help" is present and
- * properly configure the variables: vectorization, num_chunks, width, height, seed, iterations, nw.
+ * properly configure the variables: vectorization, num_chunks, width, height, seed, iterations, nw, settings.
  * @param argc	number of external arguments.
  * @param argv	array of external arguments.
- * @param vectorization, num_chunks, width, height, seed, iterations, nw	variables to configure.
+ * @param vectorization, num_chunks, width, height, seed, iterations, nw, settings	variables to configure.
  * @return	<code>true</code> if no error has occurred, <code>false</code> otherwise.
  */
-bool menu( int argc, char** argv, bool& vectorization, unsigned int& num_chunks, size_t& width, size_t& height, unsigned int& seed, unsigned int& iterations, unsigned int& nw );
+bool menu( int argc, char** argv, bool& vectorization, unsigned int& num_chunks, size_t& width, size_t& height, unsigned int& seed, unsigned int& iterations, unsigned int& nw, Settings& settings );
 
 /**
  * Initialization Phase.
- * @param vectorization, width, height, seed	external variables.
+ * The grid is filled with random values or, if present in the settings, with the given pattern.
+ * @param vectorization, width, height, seed, settings	external variables.
  * @param g		the \see Grid object that we want to initialize.
  */
-void initialization( bool vectorization, size_t width, size_t height, unsigned int seed, Grid*& g );
+void initialization( bool vectorization, size_t width, size_t height, unsigned int seed, const Settings& settings, Grid*& g );
+
+/**
+ * Create the object that records the statistics of each generation, if they are needed by the settings
+ * ( a statistics file or the cycle detection ), computing the statistics of the initial configuration.
+ * @param g				the grid in its initial configuration.
+ * @param iterations	number of iterations.
+ * @param settings		optional settings of the application.
+ * @return	the new \see StatsRecorder object, <code>NULL</code> if the statistics are not needed.
+ */
+StatsRecorder* create_recorder( PatternGrid& g, unsigned int iterations, const Settings& settings );
+
+/**
+ * Create the object that publishes the generations to the readers that need them, as the checkpoints and the shared memory.
+ * @param g				the grid in its initial configuration.
+ * @param settings		optional settings of the application.
+ * @return	the new \see SnapshotPublisher object, <code>NULL</code> if there are no readers.
+ */
+SnapshotPublisher* create_publisher( Grid* g, const Settings& settings );
+
+/**
+ * Create the object that writes the checkpoints, if they are requested by the settings.
+ * @param publisher		where to read the generations, see \see create_publisher.
+ * @param settings		optional settings of the application.
+ * @return	the new \see Checkpointer object, <code>NULL</code> if the checkpoints are not requested.
+ */
+Checkpointer* create_checkpointer( SnapshotPublisher* publisher, const Settings& settings );
+
+/**
+ * Create the object that exports the frames into the shared memory, if it is requested by the settings.
+ * @param publisher		where to read the generations, see \see create_publisher.
+ * @param settings		optional settings of the application.
+ * @return	the new \see FrameRing object, <code>NULL</code> if the shared memory is not requested.
+ */
+FrameRing* create_frame_ring( SnapshotPublisher* publisher, const Settings& settings );
+
+/**
+ * Create the object that records the changes of each generation, if they are requested by the settings.
+ * It has to be created before the first generation, since it writes the initial configuration.
+ * @param g				the \see Grid object.
+ * @param settings		optional settings of the application.
+ * @return	the new \see DeltaWriter object, <code>NULL</code> if the changes are not requested.
+ */
+DeltaWriter* create_delta_writer( Grid* g, const Settings& settings );
+
+/**
+ * Finalization Phase.
+ * Print the percentiles of the generation latency and, if present in the settings, export the final configuration
+ * of the grid as a pattern file, write the time series of the statistics and the metrics of the run.
+ * @param g				the \see Grid object.
+ * @param settings		optional settings of the application.
+ * @param recorder		statistics of the generations, <code>NULL</code> if they have not been computed.
+ */
+void finalization( PatternGrid& g, const Settings& settings, const StatsRecorder* recorder );
 
 
 /**
@@ -118,8 +298,16 @@ void initialization( bool vectorization, size_t width, size_t height, unsigned i
  */
 void setup_working_variable(  Grid* g, unsigned int& num_tasks, unsigned int& nw, size_t& start, size_t*& chunks );
 
+/**
+ * Record the wall time of a generation into \see generation_latency and, if they are collected, into the metrics of the run.
+ * @param t1	starting time of the generation.
+ * @param t2	ending time of the generation.
+ */
+void record_generation( std::chrono::high_resolution_clock::time_point t1, std::chrono::high_resolution_clock::time_point t2 );
+
 /**
  * Print the elapsed time in appropriate unit depending on its value or in microseconds if MACHINE_TIME flag is on.
+ * The time is also added to the metrics of the run, if they are collected.
  * @param duration	elapsed time
  * @param msg		message to print together with the elapsed time.
  */
@@ -0,0 +1,115 @@
+/**
+ *	@file snapshot_publisher.h
+ *	@brief Header of \see SnapshotPublisher class.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_SNAPSHOT_PUBLISHER_H
+#define GAMEOFLIFE_SNAPSHOT_PUBLISHER_H
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+
+#include "grid.h"
+
+/// A completed generation, as seen by a reader of \see SnapshotPublisher.
+struct Snapshot
+{
+	/// Cells of the generation, with the border: the cell (i, j) is at ( i + 1 ) * width + j + 1.
+	const bool* cells;
+	/// Size of the grid, border included ( as \see Grid::width and \see Grid::height ).
+	size_t width, height;
+	/// Index of the generation, zero for the initial configuration.
+	unsigned int generation;
+};
+
+/**
+ * Publishes the completed generations of a \see Grid to concurrent readers, without copies nor locks.
+ * Besides the two arrays of the grid, it keeps one spare array for each reader. At the end of each generation
+ * the reading array of the grid ( the generation just completed, which the workers only read ) becomes the
+ * latest snapshot, and the grid gets as new writing array one that no reader is holding: so the workers never
+ * wait for the readers, and a reader can keep a snapshot as long as it needs while the next ones are computed.
+ * A reader announces the array it is going to read before reading it, and checks that it is still the latest one:
+ * the publisher looks at the announcements only after publishing the new snapshot, so either it sees the
+ * announcement or the reader sees the new snapshot and tries again.
+ */
+class SnapshotPublisher
+{
+public:
+	/**
+	 * Initializes a new instance of the \see SnapshotPublisher class, publishing the current configuration as generation zero.
+	 * @param g			the \see Grid object, with the border already copied.
+	 * @param readers	number of readers, each one identified by an index between zero and <em>readers</em> - 1.
+	 */
+	SnapshotPublisher( Grid* g, unsigned int readers );
+
+	/**
+	 * Publish the reading array of the grid as the latest snapshot and replace the writing array with one not held by any reader.
+	 * It has to be called in the serial phase, after the swap and the copy of the border ( \see end_generation ).
+	 * @param generation	index of the completed generation.
+	 */
+	void publish( unsigned int generation );
+
+	/**
+	 * Return the index of the latest published generation.
+	 * @return	the index of the generation.
+	 */
+	inline unsigned int latest_generation() const
+	{
+		return this->published.load( std::memory_order_acquire );
+	}
+
+	/**
+	 * Get the latest snapshot; the reader can read it until \see release, while the next generations are computed.
+	 * @param reader	index of the reader.
+	 * @return	the latest snapshot.
+	 */
+	Snapshot acquire( unsigned int reader );
+
+	/**
+	 * Give back the snapshot obtained by \see acquire.
+	 * @param reader	index of the reader.
+	 */
+	void release( unsigned int reader );
+
+	/// Destructor of the \see SnapshotPublisher class; it frees the arrays that are not used by the grid.
+	~SnapshotPublisher();
+
+private:
+	Grid* g;
+	const unsigned int readers;
+	// All the arrays, with the generation that each one contains.
+	std::vector<bool*> buffers;
+	std::vector<unsigned int> generations;
+	// Index of the latest snapshot, with its generation, and index of the array held by each reader ( -1 for none ).
+	std::atomic<int> latest;
+	std::atomic<unsigned int> published;
+	std::atomic<int>* held;
+	// Arrays that cannot be written in the next generation, computed by \see publish.
+	std::vector<bool> busy;
+
+	/**
+	 * Return the index of an array.
+	 * @param buffer	one of the arrays.
+	 * @return	its index in <em>buffers</em>.
+	 */
+	int index_of( const bool* buffer ) const;
+};
+
+#endif //GAMEOFLIFE_SNAPSHOT_PUBLISHER_H
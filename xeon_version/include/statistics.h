@@ -0,0 +1,141 @@
+/**
+ *	@file statistics.h
+ *	@brief Header of \see GenerationStats struct and \see StatsRecorder class.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_STATISTICS_H
+#define GAMEOFLIFE_STATISTICS_H
+
+#include <iostream>
+#include <vector>
+
+#include "grid.h"
+#include "pattern_io.h"
+
+#define CYCLE_HISTORY 256
+
+/**
+ * Zobrist key of a cell, i.e. a pseudo-random 64-bit value obtained mixing its index ( splitmix64 finalizer ).
+ * The hash of a generation is the XOR of the keys of its alive cells.
+ * @param pos	index of the cell in the \see Grid, border included.
+ * @return	the key of the cell.
+ */
+inline unsigned long long zobrist_key( unsigned long long pos )
+{
+	pos += 0x9E3779B97F4A7C15ULL;
+	pos = ( pos ^ ( pos >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+	pos = ( pos ^ ( pos >> 27 ) ) * 0x94D049BB133111EBULL;
+	return pos ^ ( pos >> 31 );
+}
+
+/**
+ * Counters of a GOL generation.
+ * The workers accumulate births, deaths and the XOR of the keys of the changed cells inside the kernel
+ * and they are reduced at the barrier, while population and hash are derived from the ones
+ * of the previous generation by \see StatsRecorder.
+ */
+struct GenerationStats
+{
+	GenerationStats() : population(0), births(0), deaths(0), hash(0), key_offset(0) { }
+
+	/// Number of alive cells.
+	unsigned long long population;
+	/// Number of cells that were born in this generation.
+	unsigned long long births;
+	/// Number of cells that died in this generation.
+	unsigned long long deaths;
+	/// Zobrist hash of the generation; inside the kernel it is the XOR of the keys of the changed cells.
+	unsigned long long hash;
+	/// Offset added to the cell indexes by the kernel before computing their keys, used when the \see Grid is only a band of the whole grid.
+	size_t key_offset;
+
+	/// Set all the counters to zero, <em>key_offset</em> excluded.
+	void reset();
+
+	/**
+	 * Add the counters of another object to this one.
+	 * @param s		the counters to add.
+	 * @return	this object.
+	 */
+	GenerationStats& operator+=( const GenerationStats& s );
+};
+
+/**
+ * This class records the \see GenerationStats of every generation and writes them as a time series.
+ * It also keeps the hashes of the last CYCLE_HISTORY generations, in order to detect when the grid
+ * falls into a cycle ( a still life has period one ).
+ */
+class StatsRecorder
+{
+public:
+	/**
+	 * Initializes a new instance of the \see StatsRecorder class.
+	 * @param iterations	number of generations that will be recorded, besides the initial one.
+	 * @param initial		population and hash of the initial configuration ( generation zero ).
+	 * @param stop_on_cycle	<code>true</code> if the computation has to end as soon as a cycle is detected.
+	 */
+	StatsRecorder( unsigned int iterations, const GenerationStats& initial, bool stop_on_cycle );
+
+	/**
+	 * Append the counters of the next generation to the time series and look for a cycle.
+	 * The first time that a cycle is detected, the transient length and the period are printed.
+	 * @param s		counters accumulated by the kernel; population and hash are computed from the previous generation.
+	 * @return	<code>true</code> if the computation has to end, since a cycle was detected and <em>stop_on_cycle</em> is set.
+	 */
+	bool record( GenerationStats s );
+
+	/**
+	 * Return the number of recorded generations, the initial one excluded.
+	 * @return	the number of computed generations.
+	 */
+	unsigned int generations() const;
+
+	/**
+	 * Write the time series on a file, in JSON format if the path ends with ".json", in CSV format otherwise.
+	 * @param path	path of the output file.
+	 */
+	void write( const char* path ) const;
+
+private:
+	std::vector<GenerationStats> series;
+	unsigned long long history[CYCLE_HISTORY];
+	unsigned int period;
+	bool stop_on_cycle;
+};
+
+/**
+ * Compute population and hash of a grid; it is used only once, for the initial configuration.
+ * The keys are computed on the indexes that the cells have in a \see Grid, i.e. with the border.
+ * @param g		the grid to scan.
+ * @return	the statistics of the grid.
+ */
+GenerationStats initial_statistics( PatternGrid& g );
+
+/**
+ * The kernel computes also the cells of the left and right borders, which are then overwritten by copyBorder().
+ * Remove their contribution from the statistics, scanning only the border cells of the given working area.
+ * It has to be called before the swap of the \see Grid, i.e. before \see end_generation.
+ * @param g				the \see Grid object.
+ * @param start			index of starting working area.
+ * @param end			index of ending working area.
+ * @param stats			statistics accumulated by the kernel on the working area.
+ */
+void exclude_border( Grid* g, size_t start, size_t end, GenerationStats& stats );
+
+#endif //GAMEOFLIFE_STATISTICS_H
@@ -0,0 +1,162 @@
+/**
+ *	@file stream_grid.h
+ *	@brief Header of \see StreamGrid class.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_STREAM_GRID_H
+#define GAMEOFLIFE_STREAM_GRID_H
+
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <sys/types.h>
+
+#include "grid.h"
+#include "pattern_io.h"
+#include "statistics.h"
+
+// Number of band windows kept in memory: one being read, one being computed, one being written.
+#define NUM_WINDOWS 3
+
+/**
+ * This class represent a GOL grid (2D toroidal grid) too big to be kept in memory.
+ * The grid is stored in a file that contains two planes ( one for reading, one for writing ),
+ * each one made of <em>height</em> rows of <em>width</em> booleans, without any border.
+ * A generation is computed streaming bands of rows through a small set of \see Grid windows:
+ * a read-ahead thread loads the next band ( plus its predecessor and successor rows ),
+ * the calling thread computes it, and a write-behind thread stores the result into the other plane.
+ * The two threads live as long as the object and pass the windows through \see BandQueue objects:
+ * the read-ahead thread waits on a queue of requests, one for each generation.
+ * It implements \see PatternGrid, so patterns can be loaded into and exported from the reading plane.
+ */
+class StreamGrid : public PatternGrid
+{
+public:
+	/**
+	 * Initializes a new instance of the \see StreamGrid class.
+	 * The backing file is created ( or truncated ) in order to contain the two planes.
+	 * @param path				path of the backing file.
+	 * @param height			number of grid rows.
+	 * @param width				number of grid columns.
+	 * @param band_rows			number of rows of each band kept in memory.
+	 */
+	StreamGrid( const char* path, size_t height, size_t width, size_t band_rows );
+
+	/**
+	 * Set up this grid using random values.
+	 * The random sequence is consumed in the same order of \see Grid::init,
+	 * so the same seed produces the same initial configuration of the in-memory version.
+	 * @param seed				seed used to initialize the grid.
+	 */
+	void init( unsigned int seed );
+
+	/**
+	 * Compute a generation of Game of Life, streaming all the bands of the reading plane
+	 * and writing the result onto the writing plane. At the end the two planes are swapped.
+	 * @param vectorization		<code>true</code> if the vectorized kernel has to be used.
+	 * @param stats				where to accumulate births and deaths of the generation, <code>NULL</code> to not compute them.
+	 * @return	time spent by the calling thread waiting for the read-ahead thread, in ticks of \see TscTimer.
+	 */
+	unsigned long long stream_generation( bool vectorization, GenerationStats* stats );
+
+	/**
+	 * Copy the reading plane into the reading array of an in-memory \see Grid of the same size,
+	 * configuring also its border.
+	 * @param g			the \see Grid object to fill.
+	 */
+	void store( Grid* g ) const;
+
+	/**
+	 * Return the number of grid columns.
+	 * @return	the number of grid columns.
+	 */
+	size_t width() const override;
+
+	/**
+	 * Return the number of grid rows.
+	 * @return	the number of grid rows.
+	 */
+	size_t height() const override;
+
+	/**
+	 * Set to <code>true</code> <em>count</em> consecutive cells of the i-th row of the reading plane.
+	 * @param i			row index.
+	 * @param j			column index of the first cell.
+	 * @param count		number of cells to set.
+	 */
+	void set_alive( size_t i, size_t j, size_t count ) override;
+
+	/**
+	 * Read the i-th row of the reading plane.
+	 * @param i			row index.
+	 * @return	the internal buffer containing the row, valid until the next call.
+	 */
+	const bool* row( size_t i ) override;
+
+	/// Destructor of the \see StreamGrid class.
+	~StreamGrid();
+
+private:
+	// A band of rows loaded into a window: rows [first, first + count) of the grid.
+	// A band without window is a request of the read-ahead stage, or the termination of a stage if its count is zero.
+	struct Band
+	{
+		Grid* window;
+		size_t first, count;
+	};
+
+	// Minimal blocking queue used to pass bands between the pipeline stages ( bounded by the NUM_WINDOWS windows in circulation ).
+	class BandQueue
+	{
+	public:
+		void push( const Band& b );
+		Band pop();
+	private:
+		std::deque<Band> items;
+		std::mutex mux;
+		std::condition_variable cv;
+	};
+
+	// Read-ahead stage: for each request, load every band of the reading plane into a free window.
+	void read_ahead();
+
+	// Write-behind stage: store each computed band into the writing plane and release its window.
+	void write_behind();
+
+	// Read <em>count</em> bytes of the file starting from <em>offset</em>.
+	void read_bytes( bool* dst, size_t count, off_t offset ) const;
+
+	// Write <em>count</em> bytes of the file starting from <em>offset</em>.
+	void write_bytes( const bool* src, size_t count, off_t offset ) const;
+
+	// Return the file offset of the i-th row of the given plane.
+	off_t row_offset( int plane, size_t i ) const;
+
+	int fd, read_plane;
+	size_t rows, cols, band_rows, num_bands;
+	// Buffers used by row() and set_alive().
+	bool *row_buffer, *alive_row;
+	Grid* windows[NUM_WINDOWS];
+	BandQueue requests, free_windows, loaded_bands, computed_bands;
+	std::thread reader, writer;
+};
+
+#endif //GAMEOFLIFE_STREAM_GRID_H
@@ -23,11 +23,17 @@
 
 #include <iostream>
 
+#include "statistics.h"
+
 // Task message passed between \see Master and \see Worker.
 struct Task_t
 {
-	Task_t ( size_t start, size_t end) : start(start), end(end) { }
+	Task_t ( size_t start, size_t end, unsigned int generation ) : start(start), end(end), generation(generation) { }
 	const size_t start, end;
+	// Index of the generation of the task, starting from zero.
+	const unsigned int generation;
+	// Births and deaths of the working area, filled by the Worker when the statistics are enabled.
+	GenerationStats stats;
 };
 
 #endif //GAMEOFLIFE_TASK_H
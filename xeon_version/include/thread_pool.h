@@ -0,0 +1,130 @@
+/**
+ *	@file thread_pool.h
+ *	@brief Header of \see ThreadPool class.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_THREAD_POOL_H
+#define GAMEOFLIFE_THREAD_POOL_H
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "grid.h"
+#include "statistics.h"
+#include "load_profile.h"
+#include "perf_counters.h"
+#include "tracer.h"
+#include "delta_stream.h"
+
+#define LOOSE_SOME_TIME 1000
+
+/**
+ * Pool of threads that computes the GOL generations using low level threading mechanisms.
+ * Each thread busy-waits on its own atomic flag; the thread that owns the pool assigns the tasks
+ * on demand to the first free thread and then waits all of them at the barrier.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * Initializes a new instance of the \see ThreadPool class, creating and starting the threads.
+	 * @param g					shared object of \see Grid class.
+	 * @param nw				number of threads.
+	 * @param vectorization		<code>true</code> if the threads have to use the vectorized kernel.
+	 * @param statistics		<code>true</code> if the threads have to accumulate the statistics of the generations.
+	 * @param profile			where the threads account their work, <code>NULL</code> to not account it.
+	 * @param perf				where the threads add their hardware counters, <code>NULL</code> to not count them.
+	 * @param tracer			where the threads record their tasks and the owner its barriers, <code>NULL</code> to not trace them.
+	 * @param deltas			<code>true</code> if the threads have to record the cells changed by the generations.
+	 */
+	ThreadPool( Grid* g, unsigned int nw, bool vectorization, bool statistics, LoadProfile* profile, PerfReport* perf, Tracer* tracer, bool deltas = false );
+
+	/**
+	 * Compute a generation, splitting the working area in <em>num_tasks</em> chunks
+	 * and assigning them on demand to the first free thread; then wait all threads.
+	 * @param start			index of starting working area.
+	 * @param chunks		size of each task.
+	 * @param num_tasks		number of tasks.
+	 * @return	time spent in the barrier phase, in ticks of \see TscTimer ( only if \see take_all_time ).
+	 */
+	unsigned long long run_generation( size_t start, const size_t* chunks, unsigned int num_tasks );
+
+	/**
+	 * Add the statistics accumulated by the threads during the last generation to <em>stats</em> and reset them.
+	 * It has to be called after \see run_generation, when all threads are free.
+	 * @param stats		where to reduce the statistics of the threads.
+	 */
+	void reduce_statistics( GenerationStats& stats );
+
+	/**
+	 * Append the changes recorded by the threads during the last generation to <em>changes</em> and clear them.
+	 * It has to be called after \see run_generation, when all threads are free.
+	 * @param changes	where to collect the changes of the threads.
+	 */
+	void collect_changes( DeltaBuffer& changes );
+
+	/// Terminate the threads and wait for them.
+	~ThreadPool();
+
+private:
+	/**
+	 * Function executed by the thread.
+	 * @param id	thread identifier.
+	 */
+	void thread_body( int id );
+
+	/**
+	 * Find the first thread free ( not busy ).
+	 * We remind that each thread has its own element of the busy array, shared only with the pool owner.
+	 * It scan this busy array, looking for the first thread free, until it finds one.
+	 * @return	the index of the free thread.
+	 */
+	int find_first_thread_free() const;
+
+	/**
+	 * Wait until all threads have finish their jobs.
+	 * It wait the termination of the first thread, than wait for the second, and so on.
+	 * @return	time spent waiting, in ticks of \see TscTimer ( only if \see take_all_time ).
+	 */
+	unsigned long long barrier() const;
+
+	Grid* g;
+	unsigned int nw;
+	bool vectorization;
+	// Index of the current generation, read by the threads to account their work.
+	unsigned int generation;
+	LoadProfile* profile;
+	PerfReport* perf;
+	Tracer* tracer;
+	// If busy[i] is true, means that the i-th thread has received a task or is still computing its task.
+	std::atomic<bool>* busy;
+	// If true, all thread has to terminate their execution.
+	std::atomic<bool> terminate;
+	// Index of the starting and ending working area of each thread.
+	size_t *starts, *ends;
+	// Statistics of each thread, NULL if they are not computed.
+	GenerationStats* worker_stats;
+	// Changes recorded by each thread, NULL if they are not recorded.
+	DeltaBuffer* worker_changes;
+	std::vector<std::thread> tid;
+};
+
+#endif //GAMEOFLIFE_THREAD_POOL_H
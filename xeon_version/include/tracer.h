@@ -0,0 +1,133 @@
+/**
+ *	@file tracer.h
+ *	@brief Header of \see TraceBuffer and \see Tracer classes.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_TRACER_H
+#define GAMEOFLIFE_TRACER_H
+
+#include <iostream>
+#include <chrono>
+
+// Number of events kept by each thread; when a buffer is full, the oldest events are overwritten.
+#define TRACE_CAPACITY 16384
+
+/// A traced interval of a thread: a task, a barrier or an end_generation.
+struct TraceEvent
+{
+	/// Name of the event, a string literal.
+	const char* name;
+	/// Beginning and end of the event, in nanoseconds from the creation of the \see Tracer.
+	long long begin, end;
+	/// Index of the generation, starting from zero.
+	unsigned int generation;
+	/// Number of cells of the task, zero for the other events.
+	size_t cells;
+};
+
+/// Ring buffer of the events of a single thread; only its thread writes on it, so no lock is needed.
+class TraceBuffer
+{
+public:
+	/**
+	 * Initializes a new instance of the \see TraceBuffer class.
+	 * @param origin	time point from which the timestamps are computed.
+	 */
+	TraceBuffer( std::chrono::high_resolution_clock::time_point origin );
+
+	/**
+	 * Record an event.
+	 * @param name			name of the event, a string literal.
+	 * @param t1			beginning of the event.
+	 * @param t2			end of the event.
+	 * @param generation	index of the generation, starting from zero.
+	 * @param cells			number of cells of the task, zero for the other events.
+	 */
+	inline void add( const char* name, std::chrono::high_resolution_clock::time_point t1, std::chrono::high_resolution_clock::time_point t2,
+					 unsigned int generation, size_t cells = 0 )
+	{
+		TraceEvent& e = this->events[this->count % TRACE_CAPACITY];
+		e.name = name;
+		e.begin = (long long) std::chrono::duration_cast<std::chrono::nanoseconds>( t1 - this->origin ).count();
+		e.end = (long long) std::chrono::duration_cast<std::chrono::nanoseconds>( t2 - this->origin ).count();
+		e.generation = generation;
+		e.cells = cells;
+		this->count++;
+	}
+
+	/**
+	 * Write the recorded events, from the oldest to the newest, as Chrome trace events;
+	 * each event is preceded by a comma, since it always follows the metadata events.
+	 * @param out		output stream.
+	 * @param tid		thread identifier of the events.
+	 */
+	void write( std::ostream& out, unsigned int tid ) const;
+
+	/**
+	 * Return the number of events overwritten because the buffer was full.
+	 * @return	the number of lost events.
+	 */
+	unsigned long long dropped() const;
+
+	/// Destructor of the \see TraceBuffer class.
+	~TraceBuffer();
+
+private:
+	std::chrono::high_resolution_clock::time_point origin;
+	TraceEvent* events;
+	unsigned long long count;
+};
+
+/**
+ * This class collects the timeline of a parallel run: one \see TraceBuffer for the thread that
+ * scatters the tasks ( index zero ) and one for each worker ( index <em>id</em> + 1 ).
+ * At the end of the run the timeline is written in the Chrome trace JSON format, readable
+ * by chrome://tracing and by Perfetto.
+ */
+class Tracer
+{
+public:
+	/**
+	 * Initializes a new instance of the \see Tracer class.
+	 * @param nw	number of workers.
+	 */
+	Tracer( unsigned int nw );
+
+	/**
+	 * Return the buffer of a thread.
+	 * @param index		zero for the thread that scatters the tasks, worker identifier plus one for the workers.
+	 * @return	the buffer of the thread.
+	 */
+	TraceBuffer* buffer( unsigned int index );
+
+	/**
+	 * Write the timeline in the Chrome trace JSON format.
+	 * @param path		path of the output file.
+	 */
+	void write( const char* path ) const;
+
+	/// Destructor of the \see Tracer class.
+	~Tracer();
+
+private:
+	unsigned int nw;
+	TraceBuffer** buffers;
+};
+
+#endif //GAMEOFLIFE_TRACER_H
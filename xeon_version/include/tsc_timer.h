@@ -0,0 +1,122 @@
+/**
+ *	@file tsc_timer.h
+ *	@brief Header of \see TscTimer and \see TscAccumulator classes.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#ifndef GAMEOFLIFE_TSC_TIMER_H
+#define GAMEOFLIFE_TSC_TIMER_H
+
+#include <iostream>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TSC_AVAILABLE 1
+#endif
+
+// Duration of the calibration against the monotonic clock, in microseconds.
+#define TSC_CALIBRATION_US 20000
+
+/**
+ * Timer based on the time stamp counter, read with a single rdtsc instruction instead of a call to the clock,
+ * used by the TAKE_ALL_TIME measures that are taken several times per generation.
+ * The intervals are kept in ticks and converted in microseconds only when they are printed, so the short
+ * phases of small grids are not truncated; the conversion factor is measured by \see calibrate.
+ * On the architectures without time stamp counter the ticks are the nanoseconds of the monotonic clock.
+ */
+class TscTimer
+{
+public:
+	/**
+	 * Measure the ticks per microsecond against the monotonic clock; only the first call calibrates the timer.
+	 * It also warns if the counter is not invariant, i.e. if its frequency changes with the processor one.
+	 */
+	static void calibrate();
+
+	/**
+	 * Return the current value of the counter.
+	 * @return	the current time, in ticks.
+	 */
+	static inline unsigned long long now()
+	{
+#if TSC_AVAILABLE
+		return __rdtsc();
+#else
+		return (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch() ).count();
+#endif // TSC_AVAILABLE
+	}
+
+	/**
+	 * Convert an interval in microseconds, calibrating the timer if it has not been done yet.
+	 * @param ticks		the interval, in ticks.
+	 * @return	the interval, in microseconds.
+	 */
+	static long microseconds( unsigned long long ticks );
+
+private:
+	static double ticks_per_us;
+};
+
+/// Accumulator of the intervals of a phase; it has to be used by a single thread, so it needs no synchronization.
+class TscAccumulator
+{
+public:
+	/// Initializes a new instance of the \see TscAccumulator class.
+	TscAccumulator() : begin(0), total(0) { }
+
+	/// Mark the beginning of an interval.
+	inline void start()
+	{
+		this->begin = TscTimer::now();
+	}
+
+	/**
+	 * Mark the end of the interval, adding it to the total.
+	 * @return	the interval, in ticks.
+	 */
+	inline unsigned long long stop()
+	{
+		unsigned long long interval = TscTimer::now() - this->begin;
+		this->total += interval;
+		return interval;
+	}
+
+	/**
+	 * Return the sum of the intervals.
+	 * @return	the sum of the intervals, in ticks.
+	 */
+	unsigned long long ticks() const
+	{
+		return this->total;
+	}
+
+	/**
+	 * Return the sum of the intervals.
+	 * @return	the sum of the intervals, in microseconds.
+	 */
+	long microseconds() const
+	{
+		return TscTimer::microseconds( this->total );
+	}
+
+private:
+	unsigned long long begin, total;
+};
+
+#endif //GAMEOFLIFE_TSC_TIMER_H
@@ -25,6 +25,10 @@
 #include <ff/farm.hpp>
 #include "grid.h"
 #include "task.h"
+#include "load_profile.h"
+#include "perf_counters.h"
+#include "tracer.h"
+#include "delta_stream.h"
 #include "shared_functions.h"
 
 /// This Worker computes GOL generations until \see Master command.
@@ -38,8 +42,21 @@ public:
 	 * @param id			Worker identifier.
 	 * @param g				shared object of the \see Grid class
 	 * @param vectorization	<code>true</code> if we want to execute the vectorized version.
+	 * @param statistics	<code>true</code> if the Worker has to accumulate births and deaths into the tasks.
+	 * @param profile		where the Worker accounts its tasks, <code>NULL</code> to not account them.
+	 * @param perf			where the Worker adds its hardware counters, <code>NULL</code> to not count them.
+	 * @param trace			where the Worker records its tasks, <code>NULL</code> to not trace them.
+	 * @param changes		where the Worker appends the cells changed by its tasks, <code>NULL</code> to not record them;
+	 * 						the \see Master collects it at the end of each generation.
 	 */
-	Worker( int id, Grid* g, bool vectorization);
+	Worker( int id, Grid* g, bool vectorization, bool statistics, LoadProfile* profile, PerfReport* perf, TraceBuffer* trace, DeltaBuffer* changes = NULL );
+
+	/**
+	 * FastFlow method of the \see ff::ff_node_t, executed by the Worker thread before the first task.
+	 * It opens the hardware counters of the thread, if they are requested.
+	 * @return	zero, i.e. no error.
+	 */
+	int svc_init();
 
 	/**
 	 * FastFlow method of the \see ff::ff_node_t.
@@ -49,6 +66,12 @@ public:
 	 */
 	Task_t* svc( Task_t* task );
 
+	/**
+	 * FastFlow method of the \see ff::ff_node_t, executed by the Worker thread after the End-Of-Stream.
+	 * It adds the hardware counters of the thread to the report and closes them.
+	 */
+	void svc_end();
+
 	/**
 	 * Destructor of the \see Worker class.
 	 * If vectorization is <code>true</code>, we delete the additional array created during initialization.
@@ -57,9 +80,14 @@ public:
 
 private:
 	int id;
-	bool vectorization;
+	bool vectorization, statistics;
 	Grid* g;
 	int* numNeighbours;
+	LoadProfile* profile;
+	PerfReport* perf;
+	PerfCounters* counters;
+	TraceBuffer* trace;
+	DeltaBuffer* changes;
 };
 
 #endif //GAMEOFLIFE_WORKER_H
\ No newline at end of file
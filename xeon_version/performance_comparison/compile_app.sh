@@ -16,4 +16,4 @@ scp $BUILD_DIR/GOL_thread $BUILD_DIR/GOL_ff $MIC:
 
 # one copy on XEON HOST
 make cleanall
-make MACHINE_TIME="true"
\ No newline at end of file
+make MACHINE_TIME="true" all gol_bench gol_bench_ff
\ No newline at end of file
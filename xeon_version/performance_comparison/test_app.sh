@@ -19,8 +19,7 @@
 
 #!/bin/bash
 
-# FIXED VARIABLES
-NUMBER='^[0-9]+$'
+# Thin wrapper around GOL_bench: the sweep over the number of threads, the repetitions and the statistics are computed by the benchmark.
 
 # VARIABLES TO SET
 WORKING_DIR=~/Project
@@ -46,126 +45,19 @@ FASTFLOW_VERSION=$7
 OUTPUT_FILE=$8
 
 echo "TEST: SEED: $SEED, SIDE: $SIDE, GRAIN_HOST: $GRAIN_HOST, GRAIN_PHI: $GRAIN_PHI, VECT: $VECTORIZATION, FF:$FASTFLOW_VERSION, OUTPUT_FILE:$OUTPUT_FILE."
-echo "TEST: SEED: $SEED, SIDE: $SIDE, GRAIN_HOST: $GRAIN_HOST, GRAIN_PHI: $GRAIN_PHI, VECT: $VECTORIZATION, FF:$FASTFLOW_VERSION, OUTPUT_FILE:$OUTPUT_FILE." > $PERFORM_DIR/$OUTPUT_FILE
 
-if [ "$VECTORIZATION" = "true" ]; then VECT="-v"; fi
-if [ "$FASTFLOW_VERSION" = "true" ]; then TARGET="GOL_ff"; else TARGET="GOL_thread"; fi
+if [ "$VECTORIZATION" = "true" ]; then KERNEL="vect"; else KERNEL="scalar"; fi
+if [ "$FASTFLOW_VERSION" = "true" ]; then TARGET="GOL_bench_ff"; SCHEDULER="ff"; else TARGET="GOL_bench"; SCHEDULER="thread"; fi
+OPTIONS="--kernels $KERNEL --schedulers $SCHEDULER -s $SEED --sizes $SIDE -i $ITERATIONS --reps $NUM_VALUES"
 
-###################################
-# perfomance program on XEON HOST #
-###################################
-echo -e "XEON HOST" >> $PERFORM_DIR/$OUTPUT_FILE
-echo -e "NUM THREADS\tINIT PHASE\tCOPY BORDER\tCREATING THREADS\tBARRIER PHASE\tCOMPLETE GOL" >> $PERFORM_DIR/$OUTPUT_FILE
+# perfomance program on XEON HOST
+echo "XEON HOST"
+$BUILD_DIR/$TARGET $OPTIONS --grains $GRAIN_HOST --threads 0:1:16 --output $PERFORM_DIR/${OUTPUT_FILE%.*}_host.csv
+if [ $? != 0 ]; then echo -e "\033[1;31mError XEON HOST! \033[0m"; exit 1; fi
 
-echo -n "XEON HOST Computed: "
+# perfomance program on XEON PHI
+echo "XEON PHI"
+ssh $MIC ./$TARGET $OPTIONS --grains $GRAIN_PHI --threads 0,1,10:10:240 > $PERFORM_DIR/${OUTPUT_FILE%.*}_phi.csv
+if [ $? != 0 ]; then echo -e "\033[1;31mError XEON PHI! \033[0m"; exit 1; fi
 
-for numthreads in $(seq 0 16)
-do
-	echo -n "$numthreads" >> $PERFORM_DIR/$OUTPUT_FILE
-
-    for j in $(seq 1 $NUM_VALUES)
-    do
-        output=$($BUILD_DIR/$TARGET $VECT -s $SEED -g $GRAIN_HOST -w $SIDE -h $SIDE -i $ITERATIONS -t $numthreads)
-
-        init[$j]=$(echo $output | sed 's/T/\nT/g' | grep "initialization phase" | tr -dc '0-9')
-        if ! [[ ${init[$j]} =~ $NUMBER ]]; then echo -e "\033[1;31mError init! \033[0m"; exit 1; fi
-
-        copyborder[$j]=$(echo $output | sed 's/T/\nT/g' | grep "copy border" | tr -dc '0-9')
-        if ! [[ ${copyborder[$j]} =~ $NUMBER ]]; then echo -e "\033[1;31mError copyborder! \033[0m"; exit 1; fi
-
-        if [ $numthreads -gt 0 ]; then
-            thread[$j]=$(echo $output | sed 's/T/\nT/g' | grep "creating threads" | tr -dc '0-9')
-            if ! [[ ${thread[$j]} =~ $NUMBER ]]; then echo -e "\033[1;31mError thread! \033[0m"; exit 1; fi
-
-            barrier[$j]=$(echo $output | sed 's/T/\nT/g' | grep "barrier phase" | tr -dc '0-9')
-            if ! [[ ${barrier[$j]} =~ $NUMBER ]]; then echo -e "\033[1;31mError barrier! \033[0m"; exit 1; fi
-        fi
-
-        gol[$j]=$(echo $output | sed 's/T/\nT/g' | grep "complete Game of Life" | tr -dc '0-9')
-        if ! [[ ${gol[$j]} =~ $NUMBER ]]; then echo -e "\033[1;31mError GOL! \033[0m"; exit 1; fi
-    done
-
-    init=$($PERFORM_DIR/avg_time.sh ${init[@]})
-    if [ $? != 0 ]; then echo -e "\033[1;31mError init avg_time.sh! \033[0m"; exit 1; fi
-    copyborder=$($PERFORM_DIR/avg_time.sh ${copyborder[@]})
-    if [ $? != 0 ]; then echo -e "\033[1;31mError copyborder avg_time.sh! \033[0m"; exit 1; fi
-    if [ $numthreads -gt 0 ]; then
-        thread=$($PERFORM_DIR/avg_time.sh ${thread[@]})
-        if [ $? != 0 ]; then echo -e "\033[1;31mError thread avg_time.sh! \033[0m"; exit 1; fi
-        barrier=$($PERFORM_DIR/avg_time.sh ${barrier[@]})
-        if [ $? != 0 ]; then echo -e "\033[1;31mError barrier avg_time.sh! \033[0m"; exit 1; fi
-    else
-        thread=0
-        barrier=0
-    fi
-    gol=$($PERFORM_DIR/avg_time.sh ${gol[@]})
-    if [ $? != 0 ]; then echo -e "\033[1;31mError GOL avg_time.sh! \033[0m"; exit 1; fi
-
-	# print performances
-	echo -e "\t$init\t$copyborder\t$thread\t$barrier\t$gol" >> $PERFORM_DIR/$OUTPUT_FILE
-
-	# print computed input
-	echo -n "$numthreads, "
-done
-
-echo -e "\033[1;92mDone !\033[0m"
-
-###################################
-# perfomance program on XEON PHI #
-###################################
-echo -e "\nXEON PHI" >> $PERFORM_DIR/$OUTPUT_FILE
-echo -e "NUM THREADS\tINIT PHASE\tCOPY BORDER\tCREATING THREADS\tBARRIER PHASE\tCOMPLETE GOL" >> $PERFORM_DIR/$OUTPUT_FILE
-
-echo -n "XEON PHI Computed: "
-
-iter=(0 1 $(seq 10 10 240))
-for numthreads in ${iter[@]}
-do
-	echo -n "$numthreads" >> $PERFORM_DIR/$OUTPUT_FILE
-
-	for j in $(seq 1 $NUM_VALUES)
-	do
-		output=$(ssh $MIC ./$TARGET $VECT -s $SEED -g $GRAIN_PHI -w $SIDE -h $SIDE -i $ITERATIONS -t $numthreads)
-
-		init[$j]=$(echo $output | sed 's/T/\nT/g' | grep "initialization phase" | tr -dc '0-9')
-		if ! [[ ${init[$j]} =~ $NUMBER ]]; then echo -e "\033[1;31mError XEON PHI init! \033[0m"; exit 1; fi
-
-		copyborder[$j]=$(echo $output | sed 's/T/\nT/g' | grep "copy border" | tr -dc '0-9')
-		if ! [[ ${copyborder[$j]} =~ $NUMBER ]]; then echo -e "\033[1;31mError XEON PHI copyborder! \033[0m"; exit 1; fi
-
-		if [ $numthreads -gt 0 ]; then
-			thread[$j]=$(echo $output | sed 's/T/\nT/g' | grep "creating threads" | tr -dc '0-9')
-			if ! [[ ${thread[$j]} =~ $NUMBER ]]; then  echo -e "\033[1;31mError XEON PHI thread! \033[0m"; exit 1; fi
-		    barrier[$j]=$(echo $output | sed 's/T/\nT/g' | grep "barrier phase" | tr -dc '0-9')
-		    if ! [[ ${barrier[$j]} =~ $NUMBER ]]; then echo -e "\033[1;31mError XEON PHI barrier! \033[0m"; exit 1; fi
-		fi
-
-		gol[$j]=$(echo $output | sed 's/T/\nT/g' | grep "complete Game of Life" | tr -dc '0-9')
-		if ! [[ ${gol[$j]} =~ $NUMBER ]]; then echo -e "\033[1;31mError XEON PHI GOL! \033[0m"; exit 1; fi
-	done
-
-	init=$($PERFORM_DIR/avg_time.sh ${init[@]})
-	if [ $? != 0 ]; then echo -e "\033[1;31mError XEON PHI init avg_time.sh! \033[0m"; exit 1; fi
-	copyborder=$($PERFORM_DIR/avg_time.sh ${copyborder[@]})
-	if [ $? != 0 ]; then echo -e "\033[1;31mError XEON PHI copyborder avg_time.sh! \033[0m"; exit 1; fi
-	if [ $numthreads -gt 0 ]; then
-		thread=$($PERFORM_DIR/avg_time.sh ${thread[@]})
-		if [ $? != 0 ]; then echo -e "\033[1;31mError XEON PHI thread avg_time.sh! \033[0m"; exit 1; fi
-		barrier=$($PERFORM_DIR/avg_time.sh ${barrier[@]})
-	    if [ $? != 0 ]; then echo -e "\033[1;31mError XEON PHI barrier avg_time.sh! \033[0m"; exit 1; fi
-	else
-		thread=0
-		barrier=0
-	fi
-	gol=$($PERFORM_DIR/avg_time.sh ${gol[@]})
-	if [ $? != 0 ]; then echo -e "\033[1;31mError XEON PHI GOL avg_time.sh! \033[0m"; exit 1; fi
-
-	# print performances
-	echo -e "\t$init\t$copyborder\t$thread\t$barrier\t$gol" >> $PERFORM_DIR/$OUTPUT_FILE
-
-	# print computed input
-	echo -n "$numthreads, "
-done
-
-echo -e "\033[1;92mDone !\033[0m"
-echo -e  "\033[1;92mTEST CORRECTLY COMPLETED !\033[0m"
\ No newline at end of file
+echo -e  "\033[1;92mTEST CORRECTLY COMPLETED !\033[0m"
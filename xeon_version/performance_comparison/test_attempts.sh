@@ -17,40 +17,19 @@
 #	limitations under the License.
 # -----------------------------------------------------------------------------------
 
-#  -----------------------------------------------------------------------------------
-#	Author: Federico Conte (draxent)
-#
-#	Copyright 2015 Federico Conte
-#	https://github.com/Draxent/GameOfLife
-#
-#	Licensed under the Apache License, Version 2.0 (the "License");
-#	you may not use this file except in compliance with the License.
-#	You may obtain a copy of the License at
-#	
-#	http://www.apache.org/licenses/LICENSE-2.0
-#
-#	Unless required by applicable law or agreed to in writing, software
-#	distributed under the License is distributed on an "AS IS" BASIS,
-#	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-#	See the License for the specific language governing permissions and
-#	limitations under the License.
-# -----------------------------------------------------------------------------------
-
 #!/bin/bash
 
-# FIXED VARIABLES
-NUMBER='^[0-9]+$'
+# Thin wrapper around GOL_bench: the layouts of the attempts are compared through its --layouts option.
 
 # VARIABLES TO SET
 WORKING_DIR=~/Project
-START=100
-STEP=100
-END=1000
+SIDES=100:100:1000
+ITERATIONS=100
 NUM_VALUES=10
 
 # DERIVATE VARIABLES
 PERFORM_DIR=$WORKING_DIR/performance_comparison
-SOURCE_DIR=$WORKING_DIR/attempts
+BUILD_DIR=$WORKING_DIR/build
 
 if [ $# -lt 1 ]; then
 	echo "Usage: $0 testtype"
@@ -58,87 +37,20 @@ if [ $# -lt 1 ]; then
 fi
 
 if [ $1 -eq 1 ]; then
-	OUTPUT_FILE="perf_1vs2_2.txt"
-	PROGS=("1.2m" "2.1m")
-	OPT_BOOSTS=("false" "false")
+	OUTPUT_FILE="perf_1vs2_2"
+	LAYOUTS="1m,grid"
 else
-	OUTPUT_FILE="perf_data_structure_2.txt"
-	PROGS=("3.array_bool" "4.vector_bool" "5.array_bitset" "6.dynamic_bitset")
-	OPT_BOOSTS=("false" "false" "false" "true")
+	OUTPUT_FILE="perf_data_structure_2"
+	LAYOUTS="array_bool,vector_bool,array_bitset,dynamic_bitset"
 fi
+OPTIONS="--layouts $LAYOUTS --kernels scalar --threads 0 --sizes $SIDES -i $ITERATIONS --reps $NUM_VALUES"
 
-echo -e -n "SIDE\t#CELLS" > $PERFORM_DIR/$OUTPUT_FILE
-
-# enter in the source directory
-cd $SOURCE_DIR
-
-i=0
-for prog in ${PROGS[*]}
-do
-	# one copy on XEON PHI
-	rm $prog
-	make TARGET=$prog BOOST=${OPT_BOOSTS[$i]} MIC="true"
-	scp $prog mic0:
-	
-	# one copy on XEON HOST
-	rm $prog
-	make TARGET=$prog BOOST=${OPT_BOOSTS[$i]}
-	
-	# print label on file
-	echo -e -n "\t${prog}\t${prog}_phi" >> $PERFORM_DIR/$OUTPUT_FILE
-	
-	i=$(($i + 1))
-done
-# endline
-echo "" >> $PERFORM_DIR/$OUTPUT_FILE
-
-echo -n "Computed: "
-
-for i in $(seq $START $STEP $END)
-do
-	cells=$(($i * $i))
-	echo -e -n "$i\t$cells" >> $PERFORM_DIR/$OUTPUT_FILE
-	
-	for prog in ${PROGS[*]}
-	do
-		# perfomance program on XEON HOST
-		for j in $(seq 1 $NUM_VALUES)
-		do
-			results[$j]=$(./$prog $i $STEP)
-			if ! [[ ${results[$j]} =~ $NUMBER ]]; then
-				echo -e "\033[1;31mError! \033[0m"
-				exit 1
-			fi
-		done
-		result1=$($PERFORM_DIR/avg_time.sh ${results[*]})
-		if [ $? != 0 ]; then
-			echo -e "\033[1;31mError! \033[0m"
-			exit 1
-		fi
+# perfomance program on XEON HOST
+$BUILD_DIR/GOL_bench $OPTIONS --output $PERFORM_DIR/${OUTPUT_FILE}.csv
+if [ $? != 0 ]; then echo -e "\033[1;31mError! \033[0m"; exit 1; fi
 
-		# perfomance program on XEON PHI
-		for j in $(seq 1 $NUM_VALUES)
-		do
-			results[$j]=$(ssh mic0 ./$prog $i $STEP)
-			if ! [[ ${results[$j]} =~ $NUMBER ]]; then
-				echo -e "\033[1;31mError! \033[0m"
-				exit 1
-			fi
-		done
-		result2=$($PERFORM_DIR/avg_time.sh ${results[*]})
-		if [ $? != 0 ]; then
-			echo -e "\033[1;31mError! \033[0m"
-			exit 1
-		fi
-		
-		# print performances
-		echo -e -n "\t${result1}\t${result2}" >> $PERFORM_DIR/$OUTPUT_FILE	
-	done
-	
-	# endline
-	echo "" >> $PERFORM_DIR/$OUTPUT_FILE
-	# print computed input
-	echo -n "$i, "
-done
+# perfomance program on XEON PHI
+ssh mic0 ./GOL_bench $OPTIONS > $PERFORM_DIR/${OUTPUT_FILE}_phi.csv
+if [ $? != 0 ]; then echo -e "\033[1;31mError! \033[0m"; exit 1; fi
 
-echo -e "\033[1;92mDone !\033[0m"
\ No newline at end of file
+echo -e "\033[1;92mDone !\033[0m"
@@ -19,8 +19,7 @@
 
 #!/bin/bash
 
-# FIXED VARIABLES
-NUMBER='^[0-9]+$'
+# Thin wrapper around GOL_bench: the sweep over the number of tasks is computed by the benchmark.
 
 # VARIABLES TO SET
 WORKING_DIR=~/Project
@@ -48,40 +47,16 @@ FASTFLOW_VERSION=$9
 OUTPUT_FILE=${10}
 
 echo "TEST: MIC: $MIC, SEED: $SEED, SIDE: $SIDE, START_GRAIN: $START_GRAIN, STEP_GRAIN: $STEP_GRAIN, STOP_GRAIN: $STOP_GRAIN, NW: $NW, VECT: $VECTORIZATION, FF:$FASTFLOW_VERSION, OUTPUT_FILE:$OUTPUT_FILE."
-echo "TEST: MIC: $MIC, SEED: $SEED, SIDE: $SIDE, START_GRAIN: $START_GRAIN, STEP_GRAIN: $STEP_GRAIN, STOP_GRAIN: $STOP_GRAIN, NW: $NW, VECT: $VECTORIZATION, FF:$FASTFLOW_VERSION, OUTPUT_FILE:$OUTPUT_FILE." > $PERFORM_DIR/$OUTPUT_FILE
 
-if [ "$VECTORIZATION" = "true" ]; then VECT="-v"; fi
-if [ "$FASTFLOW_VERSION" = "true" ]; then TARGET="GOL_ff"; else TARGET="GOL_thread"; fi
+if [ "$VECTORIZATION" = "true" ]; then KERNEL="vect"; else KERNEL="scalar"; fi
+if [ "$FASTFLOW_VERSION" = "true" ]; then TARGET="GOL_bench_ff"; SCHEDULER="ff"; else TARGET="GOL_bench"; SCHEDULER="thread"; fi
+OPTIONS="--kernels $KERNEL --schedulers $SCHEDULER -s $SEED --sizes $SIDE -i $ITERATIONS --reps $NUM_VALUES --threads $NW --grains 0,$START_GRAIN:$STEP_GRAIN:$STOP_GRAIN"
 
-###################################
-# perfomance program on XEON HOST #
-###################################
-echo -e "GRAIN\tCOMPLETE GOL" >> $PERFORM_DIR/$OUTPUT_FILE
-echo -n "Computed: "
-
-iter=(0 $(seq $START_GRAIN $STEP_GRAIN $STOP_GRAIN))
-for grain in ${iter[@]}
-do
-	echo -n "$grain" >> $PERFORM_DIR/$OUTPUT_FILE
-
-    for j in $(seq 1 $NUM_VALUES)
-    do
-    	if [ "$MIC" = "NULL" ]; then
-    		output=$($BUILD_DIR/$TARGET $VECT -s $SEED -g $grain -w $SIDE -h $SIDE -i $ITERATIONS -t $NW)
-    	else
-    		output=$(ssh $MIC ./$TARGET $VECT -s $SEED -g $grain -w $SIDE -h $SIDE -i $ITERATIONS -t $NW)
-    	fi
-        gol[$j]=$(echo $output | sed 's/T/\nT/g' | grep "complete Game of Life" | tr -dc '0-9')
-        if ! [[ ${gol[$j]} =~ $NUMBER ]]; then echo -e "\033[1;31mError GOL! \033[0m"; exit 1; fi
-    done
-    gol=$($PERFORM_DIR/avg_time.sh ${gol[@]})
-    if [ $? != 0 ]; then echo -e "\033[1;31mError GOL avg_time.sh! \033[0m"; exit 1; fi
-
-	# print performances
-	echo -e "\t$gol" >> $PERFORM_DIR/$OUTPUT_FILE
-	# print computed input
-	echo -n "$grain, "
-done
+if [ "$MIC" = "NULL" ]; then
+	$BUILD_DIR/$TARGET $OPTIONS --output $PERFORM_DIR/$OUTPUT_FILE
+else
+	ssh $MIC ./$TARGET $OPTIONS > $PERFORM_DIR/$OUTPUT_FILE
+fi
+if [ $? != 0 ]; then echo -e "\033[1;31mError GOL! \033[0m"; exit 1; fi
 
-echo -e "\033[1;92mDone !\033[0m"
-echo -e  "\033[1;92mTEST CORRECTLY COMPLETED !\033[0m"
\ No newline at end of file
+echo -e  "\033[1;92mTEST CORRECTLY COMPLETED !\033[0m"
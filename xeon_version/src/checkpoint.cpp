@@ -0,0 +1,93 @@
+/**
+ *	@file checkpoint.cpp
+ *  @brief Implementation of \see Checkpointer class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+
+#include "../include/checkpoint.h"
+
+Checkpointer::Checkpointer( SnapshotPublisher* publisher, unsigned int reader, const char* path, unsigned int every )
+	: publisher(publisher), reader(reader), every( std::max( every, 1u ) ), path(path)
+{
+	this->next = this->every;
+	this->written = 0;
+	this->stop.store( false );
+	this->writer = std::thread( &Checkpointer::write_loop, this );
+}
+
+void Checkpointer::write_loop()
+{
+	while ( !this->stop.load() )
+	{
+		if ( this->publisher->latest_generation() >= this->next )
+			this->write_due();
+		else
+			std::this_thread::sleep_for( std::chrono::milliseconds( CHECKPOINT_POLL_MS ) );
+	}
+}
+
+void Checkpointer::write_due()
+{
+	if ( this->publisher->latest_generation() < this->next ) return;
+
+	// The snapshot stays valid until it is released, while the workers compute the next generations.
+	Snapshot s = this->publisher->acquire( this->reader );
+	char number[16];
+	sprintf( number, "_%06u", s.generation );
+	size_t dot = this->path.rfind( '.' );
+	if ( dot == std::string::npos ) dot = this->path.size();
+	std::string file_path = this->path.substr( 0, dot ) + number + this->path.substr( dot );
+	SnapshotPattern sp( s );
+	save_pattern( file_path.c_str(), sp );
+	this->publisher->release( this->reader );
+
+	this->written++;
+	this->next = ( s.generation / this->every + 1 ) * this->every;
+}
+
+Checkpointer::~Checkpointer()
+{
+	this->stop.store( true );
+	this->writer.join();
+	// The last generations can be published after the last look of the thread.
+	this->write_due();
+	std::cout << "Written " << this->written << " checkpoints to " << this->path << "." << std::endl;
+}
+
+SnapshotPattern::SnapshotPattern( const Snapshot& s ) : s(s) { }
+
+size_t SnapshotPattern::height() const
+{
+	return this->s.height - 2;
+}
+
+size_t SnapshotPattern::width() const
+{
+	return this->s.width - 2;
+}
+
+void SnapshotPattern::set_alive( size_t, size_t, size_t ) { }
+
+const bool* SnapshotPattern::row( size_t i )
+{
+	return this->s.cells + (i + 1) * this->s.width + 1;
+}
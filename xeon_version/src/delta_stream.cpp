@@ -0,0 +1,355 @@
+/**
+ *	@file delta_stream.cpp
+ *  @brief Implementation of \see DeltaWriter and \see DeltaReader classes.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <cstring>
+#include <algorithm>
+
+#include "../include/delta_stream.h"
+
+/**
+ * Order the changes by word.
+ * @param a, b		the changes to compare.
+ * @return	<code>true</code> if <em>a</em> comes before <em>b</em>.
+ */
+static inline bool word_order( const DeltaWord& a, const DeltaWord& b )
+{
+	return a.word < b.word;
+}
+
+DeltaWriter::DeltaWriter( Grid* g, const char* path, unsigned int keyframe_every )
+	: path(path), keyframe_every( std::max( keyframe_every, 1u ) )
+{
+	this->f = fopen( path, "wb" );
+	if ( this->f == NULL )
+	{
+		std::cerr << "Error: it is not possible to create the file " << path << "." << std::endl;
+		exit( 1 );
+	}
+	this->bytes = 0;
+	this->keyframes = 0;
+	this->generations = 0;
+	this->stop = false;
+
+	// Bitmaps of the initial configuration and of the cells outside the border.
+	size_t words = ( g->size() + DELTA_WORD_BITS - 1 ) / DELTA_WORD_BITS;
+	this->state.assign( words, 0 );
+	this->interior.assign( words, 0 );
+	for ( size_t i = 1; i < g->height() - 1; i++ )
+	{
+		for ( size_t j = 1; j < g->width() - 1; j++ )
+		{
+			size_t pos = i * g->width() + j;
+			unsigned long long bit = 1ULL << ( pos % DELTA_WORD_BITS );
+			this->interior[pos / DELTA_WORD_BITS] |= bit;
+			if ( g->Read[pos] ) this->state[pos / DELTA_WORD_BITS] |= bit;
+		}
+	}
+
+	// Header of the file.
+	unsigned int version = DELTA_VERSION;
+	unsigned long long width = g->width() - 2, height = g->height() - 2;
+	fwrite( DELTA_MAGIC, 1, 8, this->f );
+	fwrite( &version, sizeof(version), 1, this->f );
+	fwrite( &this->keyframe_every, sizeof(this->keyframe_every), 1, this->f );
+	fwrite( &width, sizeof(width), 1, this->f );
+	fwrite( &height, sizeof(height), 1, this->f );
+	this->bytes = 8 + 2 * sizeof(unsigned int) + 2 * sizeof(unsigned long long);
+	this->write_record( 'K', 0, this->state.data(), this->state.size() * sizeof(unsigned long long) );
+	this->keyframes++;
+
+	for ( int b = 0; b < DELTA_QUEUE_SIZE; b++ )
+		this->free_buffers.push_back( new DeltaBuffer() );
+	this->writer = std::thread( &DeltaWriter::write_loop, this );
+}
+
+void DeltaWriter::record( unsigned int generation, DeltaBuffer& changes )
+{
+	// Take an empty buffer, waiting only if all of them are waiting to be written.
+	DeltaBuffer* buffer;
+	{
+		std::unique_lock<std::mutex> lock( this->mux );
+		this->cv_free.wait( lock, [this]{ return !this->free_buffers.empty(); } );
+		buffer = this->free_buffers.back();
+		this->free_buffers.pop_back();
+	}
+
+	// Exchange the contents, so that the caller gets an empty buffer that keeps its capacity.
+	buffer->swap( changes );
+	changes.clear();
+
+	std::lock_guard<std::mutex> lock( this->mux );
+	this->queue.push_back( std::make_pair( generation, buffer ) );
+	this->cv_queue.notify_one();
+}
+
+void DeltaWriter::write_loop()
+{
+	while ( true )
+	{
+		std::pair<unsigned int, DeltaBuffer*> item;
+		{
+			std::unique_lock<std::mutex> lock( this->mux );
+			this->cv_queue.wait( lock, [this]{ return !this->queue.empty() || this->stop; } );
+			if ( this->queue.empty() ) break;
+			item = this->queue.front();
+			this->queue.pop_front();
+		}
+
+		this->encode( item.first, *item.second );
+		item.second->clear();
+
+		std::lock_guard<std::mutex> lock( this->mux );
+		this->free_buffers.push_back( item.second );
+		this->cv_free.notify_one();
+	}
+}
+
+void DeltaWriter::encode( unsigned int generation, DeltaBuffer& changes )
+{
+	// The tasks record their words in any order, and the words at the boundary of two tasks appear twice.
+	std::sort( changes.begin(), changes.end(), word_order );
+	this->payload.clear();
+	unsigned long long previous = 0;
+	for ( size_t c = 0; c < changes.size(); )
+	{
+		unsigned long long word = changes[c].word, mask = 0;
+		for ( ; c < changes.size() && changes[c].word == word; c++ )
+			mask |= changes[c].mask;
+		// The kernel also computes the border, which is then overwritten by the copy of the border.
+		mask &= this->interior[word];
+		if ( mask == 0 ) continue;
+		this->state[word] ^= mask;
+
+		// Distance from the previous word, 7 bits per byte.
+		unsigned long long gap = word - previous;
+		previous = word;
+		while ( gap >= 0x80 )
+		{
+			this->payload.push_back( (unsigned char) ( gap | 0x80 ) );
+			gap >>= 7;
+		}
+		this->payload.push_back( (unsigned char) gap );
+
+		// Only the bytes of the mask that are not zero.
+		size_t flags = this->payload.size();
+		this->payload.push_back( 0 );
+		for ( int k = 0; k < 8; k++ )
+		{
+			unsigned char byte = (unsigned char) ( mask >> ( 8 * k ) );
+			if ( byte == 0 ) continue;
+			this->payload[flags] |= (unsigned char) ( 1 << k );
+			this->payload.push_back( byte );
+		}
+	}
+
+	// A keyframe is written also when it is smaller than the changes, as in the chaotic first generations.
+	size_t keyframe_size = this->state.size() * sizeof(unsigned long long);
+	if ( generation % this->keyframe_every == 0 || this->payload.size() >= keyframe_size )
+	{
+		this->write_record( 'K', generation, this->state.data(), keyframe_size );
+		this->keyframes++;
+	}
+	else
+		this->write_record( 'D', generation, this->payload.data(), this->payload.size() );
+}
+
+void DeltaWriter::write_record( char type, unsigned int generation, const void* data, unsigned long long size )
+{
+	bool ok = ( fwrite( &type, 1, 1, this->f ) == 1 );
+	ok = ok && ( fwrite( &generation, sizeof(generation), 1, this->f ) == 1 );
+	ok = ok && ( fwrite( &size, sizeof(size), 1, this->f ) == 1 );
+	ok = ok && ( size == 0 || fwrite( data, 1, size, this->f ) == size );
+	if ( !ok )
+	{
+		std::cerr << "Error: it is not possible to write the file " << this->path << "." << std::endl;
+		exit( 1 );
+	}
+	this->bytes += 1 + sizeof(generation) + sizeof(size) + size;
+	this->generations++;
+}
+
+DeltaWriter::~DeltaWriter()
+{
+	// Let the thread write the generations in the queue and terminate.
+	{
+		std::lock_guard<std::mutex> lock( this->mux );
+		this->stop = true;
+		this->cv_queue.notify_all();
+	}
+	this->writer.join();
+	fclose( this->f );
+	std::cout << "Written " << this->generations << " generations ( " << this->keyframes << " keyframes, "
+			  << this->bytes << " bytes ) to " << this->path << "." << std::endl;
+
+	for ( size_t b = 0; b < this->free_buffers.size(); b++ )
+		delete this->free_buffers[b];
+}
+
+/**
+ * Report a record of the delta file that cannot be decoded and terminate.
+ * @param generation	generation of the record.
+ */
+static void corrupt_generation( unsigned int generation )
+{
+	std::cerr << "Error: the generation " << generation << " of the delta file is corrupt." << std::endl;
+	exit( 1 );
+}
+
+DeltaReader::DeltaReader( const char* path )
+{
+	this->f = fopen( path, "rb" );
+	char magic[8];
+	unsigned int version, keyframe_every;
+	unsigned long long width, height;
+	if ( this->f == NULL || fread( magic, 1, 8, this->f ) != 8 || memcmp( magic, DELTA_MAGIC, 8 ) != 0
+		 || fread( &version, sizeof(version), 1, this->f ) != 1 || version != DELTA_VERSION
+		 || fread( &keyframe_every, sizeof(keyframe_every), 1, this->f ) != 1
+		 || fread( &width, sizeof(width), 1, this->f ) != 1 || fread( &height, sizeof(height), 1, this->f ) != 1 )
+	{
+		std::cerr << "Error: " << path << " is not a delta file of this version." << std::endl;
+		exit( 1 );
+	}
+	this->rows = height;
+	this->cols = width;
+
+	// Index of the records: a truncated record, as the last one of an interrupted run, is ignored.
+	while ( true )
+	{
+		Record r;
+		if ( fread( &r.type, 1, 1, this->f ) != 1 || fread( &r.generation, sizeof(r.generation), 1, this->f ) != 1
+			 || fread( &r.size, sizeof(r.size), 1, this->f ) != 1 )
+			break;
+		r.offset = ftell( this->f );
+		if ( fseek( this->f, r.size, SEEK_CUR ) != 0 || ftell( this->f ) - r.offset != (long) r.size ) break;
+		this->records.push_back( r );
+	}
+	fseek( this->f, 0, SEEK_END );
+	if ( this->records.empty() || this->records[0].type != 'K' )
+	{
+		std::cerr << "Error: " << path << " does not contain any generation." << std::endl;
+		exit( 1 );
+	}
+
+	size_t cells = ( this->rows + 2 ) * ( this->cols + 2 );
+	this->state.assign( ( cells + DELTA_WORD_BITS - 1 ) / DELTA_WORD_BITS, 0 );
+	this->line = new bool[this->cols];
+	this->current = -1;
+}
+
+unsigned int DeltaReader::last_generation() const
+{
+	return this->records.back().generation;
+}
+
+unsigned int DeltaReader::keyframes() const
+{
+	unsigned int k = 0;
+	for ( size_t r = 0; r < this->records.size(); r++ )
+		k += ( this->records[r].type == 'K' );
+	return k;
+}
+
+bool DeltaReader::seek( unsigned int generation )
+{
+	// The records are one for each generation, in order.
+	if ( generation > this->last_generation() ) return false;
+	long target = (long) generation;
+	long start = target;
+	while ( this->records[start].type != 'K' ) start--;
+	// Go on from the current generation, if it is between the keyframe and the target.
+	if ( this->current >= start && this->current <= target ) start = this->current + 1;
+	for ( long r = start; r <= target; r++ )
+		this->apply( r );
+	this->current = target;
+	return true;
+}
+
+void DeltaReader::apply( size_t r )
+{
+	const Record& rec = this->records[r];
+	std::vector<unsigned char> payload( rec.size );
+	fseek( this->f, rec.offset, SEEK_SET );
+	if ( rec.size > 0 && fread( payload.data(), 1, rec.size, this->f ) != rec.size )
+	{
+		std::cerr << "Error: it is not possible to read the generation " << rec.generation << "." << std::endl;
+		exit( 1 );
+	}
+
+	if ( rec.type == 'K' )
+	{
+		if ( rec.size != this->state.size() * sizeof(unsigned long long) ) corrupt_generation( rec.generation );
+		memcpy( this->state.data(), payload.data(), rec.size );
+		return;
+	}
+
+	// Each change is the distance from the previous word ( 7 bits per byte ), the flags of the bytes of the mask
+	// that are not zero and those bytes: a change cut short or out of the bitmap means that the record is damaged.
+	unsigned long long word = 0;
+	const size_t n = payload.size();
+	for ( size_t p = 0; p < n; )
+	{
+		unsigned long long gap = 0;
+		unsigned char byte = 0x80;
+		for ( int shift = 0; p < n && byte >= 0x80 && shift < 64; shift += 7 )
+		{
+			byte = payload[p++];
+			gap |= (unsigned long long) ( byte & 0x7F ) << shift;
+		}
+		if ( byte >= 0x80 || p >= n || gap >= this->state.size() - word ) corrupt_generation( rec.generation );
+		word += gap;
+
+		unsigned char flags = payload[p++];
+		unsigned long long mask = 0;
+		for ( int k = 0; k < 8; k++ )
+			if ( flags & ( 1 << k ) )
+			{
+				if ( p >= n ) corrupt_generation( rec.generation );
+				mask |= (unsigned long long) payload[p++] << ( 8 * k );
+			}
+		this->state[word] ^= mask;
+	}
+}
+
+size_t DeltaReader::height() const
+{
+	return this->rows;
+}
+
+size_t DeltaReader::width() const
+{
+	return this->cols;
+}
+
+void DeltaReader::set_alive( size_t, size_t, size_t ) { }
+
+const bool* DeltaReader::row( size_t i )
+{
+	size_t pos = ( i + 1 ) * ( this->cols + 2 ) + 1;
+	for ( size_t j = 0; j < this->cols; j++, pos++ )
+		this->line[j] = ( this->state[pos / DELTA_WORD_BITS] >> ( pos % DELTA_WORD_BITS ) ) & 1;
+	return this->line;
+}
+
+DeltaReader::~DeltaReader()
+{
+	delete[] this->line;
+	fclose( this->f );
+}
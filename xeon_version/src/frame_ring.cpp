@@ -0,0 +1,246 @@
+/**
+ *	@file frame_ring.cpp
+ *  @brief Implementation of \see FrameRing and \see FrameRingReader classes.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../include/frame_ring.h"
+
+/**
+ * Return the value of the sequence of a slot once the n-th frame has been written:
+ * each slot is written once every <em>slots</em> frames, and each write adds two.
+ * @param n			index of the frame, from zero.
+ * @param slots		number of slots.
+ * @return	the sequence of the slot.
+ */
+static inline uint64_t written_sequence( uint64_t n, uint64_t slots )
+{
+	return 2 * ( n / slots + 1 );
+}
+
+static inline uint64_t align( uint64_t size )
+{
+	return ( size + FRAME_RING_ALIGNMENT - 1 ) / FRAME_RING_ALIGNMENT * FRAME_RING_ALIGNMENT;
+}
+
+FrameRing::FrameRing( SnapshotPublisher* publisher, unsigned int reader, const char* name, unsigned int scale, unsigned int slots, bool replace )
+	: publisher(publisher), reader(reader), name(name)
+{
+	scale = std::max( scale, 1u );
+	slots = std::max( slots, 1u );
+	// The snapshots have the border, which is not exported.
+	Snapshot s = publisher->acquire( reader );
+	publisher->release( reader );
+	uint64_t width = ( s.width - 2 + scale - 1 ) / scale, height = ( s.height - 2 + scale - 1 ) / scale;
+	uint64_t slot_bytes = align( sizeof(FrameSlot) ) + align( width * height );
+	uint64_t slots_offset = align( sizeof(FrameRingHeader) );
+	this->size = slots_offset + slots * slot_bytes;
+
+	// A new object is filled with zeros, so all the sequences start from zero.
+	// An existing ring can belong to another simulation, so it is removed only on request.
+	if ( replace ) shm_unlink( name );
+	int fd = shm_open( name, O_CREAT | O_EXCL | O_RDWR, 0644 );
+	if ( fd < 0 && errno == EEXIST )
+	{
+		std::cerr << "Error: the shared memory ring " << name << " already exists, use --shm-replace to remove it." << std::endl;
+		exit( 1 );
+	}
+	if ( fd < 0 || ftruncate( fd, this->size ) != 0 )
+	{
+		std::cerr << "Error: it is not possible to create the shared memory " << name << "." << std::endl;
+		exit( 1 );
+	}
+	void* m = mmap( NULL, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	close( fd );
+	if ( m == MAP_FAILED )
+	{
+		std::cerr << "Error: it is not possible to map the shared memory " << name << "." << std::endl;
+		exit( 1 );
+	}
+	this->memory = (unsigned char*) m;
+	this->header = (FrameRingHeader*) m;
+	this->header->version = FRAME_RING_VERSION;
+	this->header->slots = slots;
+	this->header->width = width;
+	this->header->height = height;
+	this->header->scale = scale;
+	this->header->slot_bytes = slot_bytes;
+	this->header->slots_offset = slots_offset;
+	// The consumers look at the magic string before the rest of the header.
+	std::atomic_thread_fence( std::memory_order_release );
+	memcpy( this->header->magic, FRAME_RING_MAGIC, sizeof( FRAME_RING_MAGIC ) );
+
+	// The initial configuration is the first frame.
+	this->last = 0;
+	this->write_latest();
+	this->stop.store( false );
+	this->writer = std::thread( &FrameRing::write_loop, this );
+}
+
+void FrameRing::write_loop()
+{
+	while ( !this->stop.load() )
+	{
+		if ( this->publisher->latest_generation() != this->last )
+			this->write_latest();
+		else
+			std::this_thread::sleep_for( std::chrono::microseconds( FRAME_RING_POLL_US ) );
+	}
+}
+
+void FrameRing::write_latest()
+{
+	FrameRingHeader* h = this->header;
+	uint64_t n = h->frames.load( std::memory_order_relaxed );
+	if ( n > 0 && this->publisher->latest_generation() == this->last ) return;
+
+	// The snapshot stays valid until it is released, while the workers compute the next generations.
+	Snapshot s = this->publisher->acquire( this->reader );
+	FrameSlot* slot = (FrameSlot*) ( this->memory + h->slots_offset + ( n % h->slots ) * h->slot_bytes );
+	unsigned char* frame = (unsigned char*) slot + align( sizeof(FrameSlot) );
+
+	// Odd sequence: the consumers of this slot know that it is changing.
+	slot->sequence.store( written_sequence( n, h->slots ) - 1, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+	slot->generation = s.generation;
+
+	size_t rows = s.height - 2, cols = s.width - 2, scale = h->scale;
+	for ( size_t y = 0; y < h->height; y++ )
+	{
+		unsigned char* line = frame + y * h->width;
+		size_t i0 = y * scale, i1 = std::min( i0 + scale, rows );
+		if ( scale == 1 )
+		{
+			const bool* row = s.cells + ( i0 + 1 ) * s.width + 1;
+			for ( size_t x = 0; x < cols; x++ )
+				line[x] = row[x] ? 255 : 0;
+			continue;
+		}
+		// Each pixel is the density of its block of cells.
+		for ( size_t x = 0; x < h->width; x++ )
+		{
+			size_t j0 = x * scale, j1 = std::min( j0 + scale, cols ), count = 0;
+			for ( size_t i = i0; i < i1; i++ )
+			{
+				const bool* row = s.cells + ( i + 1 ) * s.width + 1;
+				for ( size_t j = j0; j < j1; j++ )
+					count += row[j];
+			}
+			line[x] = (unsigned char) ( count * 255 / ( ( i1 - i0 ) * ( j1 - j0 ) ) );
+		}
+	}
+	this->publisher->release( this->reader );
+	this->last = s.generation;
+
+	slot->sequence.store( written_sequence( n, h->slots ), std::memory_order_release );
+	h->frames.store( n + 1, std::memory_order_release );
+}
+
+FrameRing::~FrameRing()
+{
+	this->stop.store( true );
+	this->writer.join();
+	// The last generations can be published after the last look of the thread.
+	this->write_latest();
+	this->header->finished.store( 1, std::memory_order_release );
+	std::cout << "Exported " << this->header->frames.load() << " frames to the shared memory " << this->name << "." << std::endl;
+
+	// The consumers that have mapped the ring can still read it.
+	munmap( this->memory, this->size );
+	shm_unlink( this->name.c_str() );
+}
+
+FrameRingReader::FrameRingReader( const char* name )
+{
+	int fd = shm_open( name, O_RDONLY, 0 );
+	struct stat st;
+	if ( fd < 0 || fstat( fd, &st ) != 0 || (size_t) st.st_size < sizeof(FrameRingHeader) )
+	{
+		std::cerr << "Error: it is not possible to open the shared memory " << name << "." << std::endl;
+		exit( 1 );
+	}
+	this->size = st.st_size;
+	void* m = mmap( NULL, this->size, PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );
+	if ( m == MAP_FAILED )
+	{
+		std::cerr << "Error: it is not possible to map the shared memory " << name << "." << std::endl;
+		exit( 1 );
+	}
+	this->memory = (const unsigned char*) m;
+	this->header = (const FrameRingHeader*) m;
+
+	if ( memcmp( this->header->magic, FRAME_RING_MAGIC, sizeof( FRAME_RING_MAGIC ) ) != 0 || this->header->version != FRAME_RING_VERSION )
+	{
+		std::cerr << "Error: " << name << " is not a ring of frames of this version." << std::endl;
+		exit( 1 );
+	}
+	std::atomic_thread_fence( std::memory_order_acquire );
+}
+
+const unsigned char* FrameRingReader::begin_read( uint64_t& generation, uint64_t& token ) const
+{
+	while ( true )
+	{
+		uint64_t frames = this->header->frames.load( std::memory_order_acquire );
+		if ( frames == 0 ) return NULL;
+
+		// If the slot is already being reused, a newer frame is complete: look again.
+		uint64_t n = frames - 1;
+		const FrameSlot* slot = this->slot_at( n % this->header->slots );
+		if ( slot->sequence.load( std::memory_order_acquire ) != written_sequence( n, this->header->slots ) ) continue;
+		generation = slot->generation;
+		token = n;
+		return (const unsigned char*) slot + align( sizeof(FrameSlot) );
+	}
+}
+
+bool FrameRingReader::end_read( uint64_t token ) const
+{
+	std::atomic_thread_fence( std::memory_order_acquire );
+	const FrameSlot* slot = this->slot_at( token % this->header->slots );
+	return slot->sequence.load( std::memory_order_relaxed ) == written_sequence( token, this->header->slots );
+}
+
+bool FrameRingReader::copy_latest( unsigned char* frame, uint64_t& generation ) const
+{
+	uint64_t token;
+	const unsigned char* f;
+	do
+	{
+		f = this->begin_read( generation, token );
+		if ( f == NULL ) return false;
+		memcpy( frame, f, this->header->width * this->header->height );
+	}
+	while ( !this->end_read( token ) );
+	return true;
+}
+
+FrameRingReader::~FrameRingReader()
+{
+	munmap( (void*) this->memory, this->size );
+}
@@ -45,6 +45,11 @@ void Grid::init( unsigned int seed )
 		this->Read[i] = (rand() > RAND_MAX_HALF);
 }
 
+void Grid::clear()
+{
+	std::fill( this->Read, this->Read + this->numCells, false );
+}
+
 #if VECTORIZATION
 void Grid::init_vect( unsigned int seed )
 {
@@ -0,0 +1,99 @@
+/**
+ *	@file latency_histogram.cpp
+ *  @brief Implementation of \see LatencyHistogram class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cctype>
+#include <algorithm>
+
+#include "../include/latency_histogram.h"
+#include "../include/metrics.h"
+
+LatencyHistogram generation_latency;
+
+LatencyHistogram::LatencyHistogram()
+{
+	std::fill( this->buckets, this->buckets + HISTOGRAM_BUCKETS, 0ULL );
+	this->count = 0;
+	this->max = 0;
+}
+
+LatencyHistogram& LatencyHistogram::operator+=( const LatencyHistogram& h )
+{
+	for ( unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++ )
+		this->buckets[i] += h.buckets[i];
+	this->count += h.count;
+	this->max = std::max( this->max, h.max );
+	return *this;
+}
+
+unsigned long long LatencyHistogram::percentile( double percentile ) const
+{
+	if ( this->count == 0 ) return 0;
+
+	// Rank of the value, starting from one.
+	unsigned long long rank = (unsigned long long) ceil( percentile / 100.0 * this->count );
+	rank = std::min( std::max( rank, 1ULL ), this->count );
+
+	unsigned long long seen = 0;
+	for ( unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++ )
+	{
+		seen += this->buckets[i];
+		if ( seen < rank ) continue;
+		if ( i < HISTOGRAM_SUB_BUCKETS ) return i;
+		// Highest value of the bucket, which cannot exceed the maximum recorded value.
+		unsigned int shift = i / HISTOGRAM_SUB_BUCKETS - 1;
+		unsigned long long low = (unsigned long long) ( i % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS ) << shift;
+		return std::min( low + ( 1ULL << shift ) - 1, this->max );
+	}
+	return this->max;
+}
+
+void LatencyHistogram::report( const char* name ) const
+{
+	if ( this->count == 0 ) return;
+
+	const double percentiles[3] = { 50, 90, 99 };
+	const char* keys[3] = { "p50", "p90", "p99" };
+	std::ostringstream line, json;
+	line << std::fixed << std::setprecision( 2 );
+	json << std::fixed << std::setprecision( 3 ) << "{ \"count\": " << this->count;
+	line << "Latency of " << name << " ( " << this->count << " samples ):";
+	for ( int p = 0; p < 3; p++ )
+	{
+		double value = this->percentile( percentiles[p] ) / 1000.0;
+		line << " " << keys[p] << " " << value << ",";
+		json << ", \"" << keys[p] << "_us\": " << value;
+	}
+	line << " max " << this->max / 1000.0 << " microseconds.";
+	json << ", \"max_us\": " << this->max / 1000.0 << " }";
+	std::cout << line.str() << std::endl;
+
+	if ( run_metrics != NULL )
+	{
+		// Convert the name into a key, as the phases of the metrics.
+		std::string key( name );
+		for ( size_t i = 0; i < key.size(); i++ )
+			key[i] = ( key[i] == ' ' ) ? '_' : (char) tolower( key[i] );
+		run_metrics->set_section( ( key + "_latency" ).c_str(), json.str() );
+	}
+}
@@ -0,0 +1,108 @@
+/**
+ *	@file load_profile.cpp
+ *  @brief Implementation of \see LoadProfile class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <iomanip>
+#include <algorithm>
+
+#include "../include/load_profile.h"
+
+LoadProfile::LoadProfile( unsigned int nw, unsigned int iterations )
+{
+	this->nw = nw;
+	this->iterations = iterations;
+	this->generations = 0;
+	this->samples = new WorkerSample[nw * iterations];
+	std::fill( this->samples, this->samples + nw * iterations, WorkerSample{ 0, 0 } );
+	this->generation_time = new long[iterations];
+	this->serial_time = new long[iterations];
+}
+
+void LoadProfile::add_generation( unsigned int generation, std::chrono::high_resolution_clock::time_point t1,
+								  std::chrono::high_resolution_clock::time_point t2, std::chrono::high_resolution_clock::time_point t3 )
+{
+	this->generation_time[generation] = (long) std::chrono::duration_cast<std::chrono::microseconds>( t3 - t1 ).count();
+	this->serial_time[generation] = (long) std::chrono::duration_cast<std::chrono::microseconds>( t3 - t2 ).count();
+	this->generations = generation + 1;
+}
+
+void LoadProfile::report() const
+{
+	if ( this->generations == 0 ) return;
+
+	// Max/mean busy ratio of each generation: 1 means perfect balance.
+	double sum_ratio = 0, worst_ratio = 0;
+	unsigned int worst_generation = 0;
+	long total_time = 0, total_serial = 0;
+	for ( unsigned int k = 0; k < this->generations; k++ )
+	{
+		long max_busy = 0, sum_busy = 0;
+		for ( unsigned int w = 0; w < this->nw; w++ )
+		{
+			long busy = this->samples[w * this->iterations + k].busy;
+			max_busy = std::max( max_busy, busy );
+			sum_busy += busy;
+		}
+		double ratio = ( sum_busy > 0 ) ? max_busy / ( sum_busy / (double) this->nw ) : 1;
+		sum_ratio += ratio;
+		if ( ratio > worst_ratio )
+		{
+			worst_ratio = ratio;
+			worst_generation = k + 1;
+		}
+		total_time += this->generation_time[k];
+		total_serial += this->serial_time[k];
+	}
+
+	std::cout << std::fixed << std::setprecision( 3 );
+	std::cout << "Load imbalance over " << this->generations << " generations and " << this->nw << " workers:" << std::endl;
+	std::cout << "\t max/mean busy ratio: mean " << sum_ratio / this->generations << ", worst " << worst_ratio;
+	std::cout << " ( generation " << worst_generation << " ) ;" << std::endl;
+	std::cout << std::setprecision( 2 );
+	std::cout << "\t serial end_generation: " << ( ( total_time > 0 ) ? 100.0 * total_serial / total_time : 0.0 ) << "% of the critical path ;" << std::endl;
+	std::cout << "\t worker \t tasks \t busy(us) \t wait(us) \t busy% \t histogram of the busy fraction per generation ( 0-10% ... 90-100% )" << std::endl;
+	for ( unsigned int w = 0; w < this->nw; w++ )
+	{
+		unsigned long long tasks = 0;
+		long busy = 0;
+		unsigned int histogram[IMBALANCE_BINS] = { 0 };
+		for ( unsigned int k = 0; k < this->generations; k++ )
+		{
+			const WorkerSample& s = this->samples[w * this->iterations + k];
+			tasks += s.tasks;
+			busy += s.busy;
+			double fraction = ( this->generation_time[k] > 0 ) ? s.busy / (double) this->generation_time[k] : 0;
+			histogram[std::min( (int) ( fraction * IMBALANCE_BINS ), IMBALANCE_BINS - 1 )]++;
+		}
+		std::cout << "\t " << w << " \t " << tasks << " \t " << busy << " \t " << total_time - busy << " \t ";
+		std::cout << ( ( total_time > 0 ) ? 100.0 * busy / total_time : 0.0 ) << " \t";
+		for ( int b = 0; b < IMBALANCE_BINS; b++ )
+			std::cout << " " << histogram[b];
+		std::cout << std::endl;
+	}
+	std::cout.unsetf( std::ios_base::floatfield );
+}
+
+LoadProfile::~LoadProfile()
+{
+	delete[] this->samples;
+	delete[] this->generation_time;
+	delete[] this->serial_time;
+}
@@ -0,0 +1,454 @@
+/**
+ *	@file main_bench.cpp
+ *	@brief Contains the main() function of the in-process benchmark suite of Game of Life.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#include "../include/grid.h"
+#include "../include/shared_functions.h"
+#include "../include/thread_pool.h"
+#include "../attempts/layouts.h"
+#if FASTFLOW
+#include <ff/farm.hpp>
+#include "../include/master.h"
+#include "../include/worker.h"
+#endif // FASTFLOW
+
+#define DEFAULT_WARMUP 2
+#define DEFAULT_REPETITIONS 10
+/// Layout of the application, see \see Grid; the other layouts are those of \see create_layout.
+#define GRID_LAYOUT "grid"
+
+#if FASTFLOW
+#define DEFAULT_SCHEDULERS "thread,ff"
+#else
+#define DEFAULT_SCHEDULERS "thread"
+#endif // FASTFLOW
+
+/// Configuration of a benchmark case.
+struct BenchCase
+{
+	/// Scheduler of the tasks: "sequential", "thread" ( \see ThreadPool ) or "ff" ( FastFlow farm ).
+	std::string scheduler;
+	/// Data structure of the grid: GRID_LAYOUT or one of the layouts of the attempts.
+	std::string layout;
+	/// Kernel used to compute the generations: "scalar", "vect" or "stats".
+	std::string kernel;
+	size_t width, height;
+	/// Number of threads, zero for the sequential version.
+	unsigned int nw;
+	/// Number of tasks in which each generation is split ( zero for one task per thread ).
+	unsigned int grain;
+};
+
+/// Samples of a benchmark case, in microseconds.
+struct BenchSamples
+{
+	/// Time to compute the generations of each sample.
+	std::vector<double> total;
+	/// Time spent by each sample in end_generation, empty if the scheduler does not expose it.
+	std::vector<double> serial;
+	/// Time to create the scheduler, negative if it is not measured.
+	double setup;
+};
+
+/// Summary of the samples of a benchmark case, in microseconds.
+struct BenchResult
+{
+	double median, mean, ci_low, ci_high, min, max;
+};
+
+/**
+ * Convert a list of numbers.
+ * @param words		the numbers, as strings.
+ * @return	the numbers of the list.
+ */
+std::vector<size_t> to_numbers( const std::vector<std::string>& words );
+
+/**
+ * Run a benchmark case on the \see Grid of the application: the grid and the threads are created once,
+ * then <em>warmup</em> samples are discarded and <em>reps</em> samples are measured. Each sample starts
+ * from the same initial grid, whose initialization is not measured, and computes <em>iterations</em>
+ * generations, end_generation included.
+ * @param c				the case to run.
+ * @param seed, iterations, warmup, reps		benchmark parameters.
+ * @param samples		where to store the measured samples.
+ * @return	<code>false</code> if the case cannot be run.
+ */
+bool run_case( BenchCase& c, unsigned int seed, unsigned int iterations, unsigned int warmup, unsigned int reps, BenchSamples& samples );
+
+/**
+ * Run a benchmark case on one of the layouts of the attempts, see \see run_layout.
+ * @param c				the case to run.
+ * @param seed, iterations, warmup, reps		benchmark parameters.
+ * @param samples		where to store the measured samples.
+ * @return	<code>false</code> if the case cannot be run.
+ */
+bool run_layout_case( BenchCase& c, unsigned int seed, unsigned int iterations, unsigned int warmup, unsigned int reps, BenchSamples& samples );
+
+/**
+ * Compute median, mean, minimum, maximum and the 95% confidence interval of the mean ( Student's t ).
+ * @param samples		the samples to summarize.
+ * @return	the summary.
+ */
+BenchResult summarize( std::vector<double> samples );
+
+int main( int argc, char** argv )
+{
+	ProgramOptions po( argc, argv );
+
+	// Print help message if the "--help" option is present.
+	if ( po.exists( "--help" ) )
+	{
+		std::cerr << "Usage: " << argv[0] << " [options] " << std::endl;
+		std::cerr << "Possible options ( lists are comma separated, FIRST:STEP:LAST is a range ):" << std::endl;
+		std::cerr << "\t --sizes LIST \t\t grid sizes, as side or WIDTHxHEIGHT ( default 1000 ) ;" << std::endl;
+		std::cerr << "\t --threads LIST \t number of threads, zero for the sequential version ( default 0,1,2,4 ) ;" << std::endl;
+		std::cerr << "\t --grains LIST \t\t number of tasks per generation, zero for one per thread ( default 0 ) ;" << std::endl;
+		std::cerr << "\t --schedulers LIST \t schedulers of the tasks among " << DEFAULT_SCHEDULERS << " ( default all ) ;" << std::endl;
+#if VECTORIZATION
+		std::cerr << "\t --kernels LIST \t kernels among scalar, vect, stats ( default scalar,vect ) ;" << std::endl;
+#else
+		std::cerr << "\t --kernels LIST \t kernels among scalar, stats ( default scalar ) ;" << std::endl;
+#endif // VECTORIZATION
+		std::cerr << "\t --layouts LIST \t data structures among " << GRID_LAYOUT << ", " << LAYOUT_NAMES << " ( default " << GRID_LAYOUT << " ) ;" << std::endl;
+		std::cerr << "\t -i NUM, --iterations NUM \t generations computed by each sample ( default 100 ) ;" << std::endl;
+		std::cerr << "\t --warmup NUM \t\t samples discarded before measuring ( default " << DEFAULT_WARMUP << " ) ;" << std::endl;
+		std::cerr << "\t --reps NUM \t\t measured samples ( default " << DEFAULT_REPETITIONS << " ) ;" << std::endl;
+		std::cerr << "\t -s NUM, --seed NUM \t seed used to initialize the grid ( default 1 ) ;" << std::endl;
+		std::cerr << "\t --output FILE \t\t CSV file where to write the results ( default standard output ) ;" << std::endl;
+		std::cerr << "\t --help \t\t this help view ;" << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> sizes = po.get_list( "--sizes", "1000" );
+	std::vector<size_t> threads = to_numbers( po.get_list( "--threads", "0,1,2,4" ) );
+	std::vector<size_t> grains = to_numbers( po.get_list( "--grains", "0" ) );
+	std::vector<std::string> schedulers = po.get_list( "--schedulers", DEFAULT_SCHEDULERS );
+#if VECTORIZATION
+	std::vector<std::string> kernels = po.get_list( "--kernels", "scalar,vect" );
+#else
+	std::vector<std::string> kernels = po.get_list( "--kernels", "scalar" );
+#endif // VECTORIZATION
+	std::vector<std::string> layouts = po.get_list( "--layouts", GRID_LAYOUT );
+	unsigned int iterations = (unsigned int) po.get_number( "-i", "--iterations", 100 );
+	unsigned int warmup = (unsigned int) po.get_number( "--warmup", DEFAULT_WARMUP );
+	unsigned int reps = (unsigned int) po.get_number( "--reps", DEFAULT_REPETITIONS );
+	unsigned int seed = (unsigned int) po.get_number( "-s", "--seed", 1 );
+	const char* output = po.get( "--output" );
+	assert( iterations > 0 && reps > 0 );
+
+	std::ofstream file;
+	if ( output != NULL )
+	{
+		file.open( output );
+		if ( file.fail() )
+		{
+			std::cerr << "Error: it is not possible to create the file " << output << "." << std::endl;
+			return 1;
+		}
+	}
+	std::ostream& csv = ( output != NULL ) ? file : std::cout;
+	csv << "scheduler,layout,kernel,width,height,threads,tasks,iterations,warmup,reps,setup_us,";
+	csv << "median_us,mean_us,ci95_low_us,ci95_high_us,min_us,max_us,serial_median_us,cells_per_s" << std::endl;
+	csv << std::fixed << std::setprecision( 1 );
+
+	// Every case is a combination of the lists; the lists that do not apply to a case are not expanded.
+	std::vector<BenchCase> cases;
+	for ( size_t s = 0; s < sizes.size(); s++ )
+	{
+		BenchCase c;
+		char* x = NULL;
+		c.width = strtoul( sizes[s].c_str(), &x, 10 );
+		c.height = ( *x == 'x' ) ? strtoul( x + 1, NULL, 10 ) : c.width;
+		if ( c.width == 0 || c.height == 0 )
+		{
+			std::cerr << "Error: invalid grid size " << sizes[s] << "." << std::endl;
+			return 1;
+		}
+
+		for ( size_t l = 0; l < layouts.size(); l++ )
+		{
+			c.layout = layouts[l];
+			for ( size_t t = 0; t < threads.size(); t++ )
+			{
+				c.nw = (unsigned int) threads[t];
+				// The layouts of the attempts have their own kernel, and one band of rows for each thread.
+				if ( c.layout != GRID_LAYOUT )
+				{
+					c.scheduler = ( c.nw == 0 ) ? "sequential" : "thread";
+					c.kernel = "";
+					c.grain = c.nw;
+					cases.push_back( c );
+					continue;
+				}
+				for ( size_t k = 0; k < kernels.size(); k++ )
+					for ( size_t n = 0; n < grains.size(); n++ )
+						for ( size_t h = 0; h < schedulers.size(); h++ )
+						{
+							// The grain and the scheduler are meaningless for the sequential version.
+							if ( c.nw == 0 && ( n > 0 || h > 0 ) ) continue;
+							c.scheduler = ( c.nw == 0 ) ? "sequential" : schedulers[h];
+							c.kernel = kernels[k];
+							c.grain = (unsigned int) grains[n];
+							cases.push_back( c );
+						}
+			}
+		}
+	}
+
+	for ( size_t i = 0; i < cases.size(); i++ )
+	{
+		BenchCase& c = cases[i];
+		BenchSamples samples;
+		samples.setup = -1;
+		bool ok = ( c.layout == GRID_LAYOUT ) ? run_case( c, seed, iterations, warmup, reps, samples )
+											  : run_layout_case( c, seed, iterations, warmup, reps, samples );
+		if ( !ok ) return 1;
+		// A case that does not apply, as a layout that cannot be computed in parallel, has no samples.
+		if ( samples.total.empty() ) continue;
+		BenchResult r = summarize( samples.total );
+		double cells = (double) c.width * c.height * iterations;
+
+		csv << c.scheduler << "," << c.layout << "," << c.kernel << "," << c.width << "," << c.height << ",";
+		csv << c.nw << "," << c.grain << "," << iterations << "," << warmup << "," << reps << ",";
+		if ( samples.setup >= 0 ) csv << samples.setup;
+		csv << "," << r.median << "," << r.mean << "," << r.ci_low << "," << r.ci_high << "," << r.min << "," << r.max << ",";
+		if ( !samples.serial.empty() ) csv << summarize( samples.serial ).median;
+		csv << "," << std::setprecision( 0 ) << cells / r.median * 1e6 << std::setprecision( 1 ) << std::endl;
+		std::cerr << c.width << "x" << c.height << " " << c.scheduler << " " << c.layout << " " << c.kernel;
+		std::cerr << " threads " << c.nw << " tasks " << c.grain << ": median " << r.median << " us" << std::endl;
+	}
+
+	return 0;
+}
+
+std::vector<size_t> to_numbers( const std::vector<std::string>& words )
+{
+	std::vector<size_t> numbers;
+	for ( size_t i = 0; i < words.size(); i++ )
+		numbers.push_back( (size_t) std::atol( words[i].c_str() ) );
+	return numbers;
+}
+
+bool run_case( BenchCase& c, unsigned int seed, unsigned int iterations, unsigned int warmup, unsigned int reps, BenchSamples& samples )
+{
+	bool vectorization = ( c.kernel == "vect" ), statistics = ( c.kernel == "stats" );
+#if !VECTORIZATION
+	if ( vectorization )
+	{
+		std::cerr << "Error: the vect kernel requires the VECTORIZATION flag." << std::endl;
+		return false;
+	}
+#endif // VECTORIZATION
+	if ( !vectorization && !statistics && c.kernel != "scalar" )
+	{
+		std::cerr << "Error: unknown kernel " << c.kernel << "." << std::endl;
+		return false;
+	}
+	if ( c.scheduler != "sequential" && c.scheduler != "thread" && c.scheduler != "ff" )
+	{
+		std::cerr << "Error: unknown scheduler " << c.scheduler << "." << std::endl;
+		return false;
+	}
+#if !FASTFLOW
+	if ( c.scheduler == "ff" )
+	{
+		std::cerr << "Error: the ff scheduler requires the FastFlow build ( make gol_bench_ff )." << std::endl;
+		return false;
+	}
+#endif // FASTFLOW
+	// The Master reduces the statistics only into the recorder of a single run.
+	if ( c.scheduler == "ff" && statistics )
+	{
+		std::cerr << "The stats kernel is not measured with the ff scheduler, skipped with " << c.nw << " threads." << std::endl;
+		return true;
+	}
+
+	// The initial configuration is computed once and restored before each sample.
+	Grid* g = new Grid( c.height, c.width );
+	g->init( seed );
+	g->copyBorder();
+	bool* initial = new bool[g->size()];
+	std::copy( g->Read, g->Read + g->size(), initial );
+
+	size_t start = g->width() + 1, end = g->size() - g->width() - 1;
+	size_t* chunks = NULL;
+	if ( c.nw > 0 )
+	{
+		unsigned int num_tasks = ( c.grain == 0 ) ? c.nw : c.grain;
+		setup_working_variable( g, num_tasks, c.nw, start, chunks );
+		c.grain = num_tasks;
+	}
+
+#if FASTFLOW
+	if ( c.scheduler == "ff" )
+	{
+		// The farm is frozen at the end of each sample and thawed by the next one, so the threads are started by the first sample.
+		std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+		std::vector<std::unique_ptr<ff::ff_node>> workers;
+		for ( unsigned int t = 0; t < c.nw; t++ )
+			workers.push_back( ff::make_unique<Worker>( t, g, vectorization, false, nullptr, nullptr, nullptr ) );
+		ff::ff_Farm<> farm( std::move( workers ) );
+		farm.remove_collector();
+		Master master( farm.getlb(), c.nw, g, iterations, start, chunks, c.grain, nullptr, nullptr, nullptr, nullptr, nullptr );
+		farm.add_emitter( master );
+		farm.wrap_around();
+		samples.setup = (double) std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::high_resolution_clock::now() - t0 ).count();
+
+		for ( unsigned int r = 0; r < warmup + reps; r++ )
+		{
+			std::copy( initial, initial + g->size(), g->Read );
+			std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+			if ( farm.run_then_freeze() < 0 )
+			{
+				std::cerr << "Error: running farm." << std::endl;
+				return false;
+			}
+			farm.wait_freezing();
+			std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+			if ( r >= warmup )
+				samples.total.push_back( (double) std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count() );
+		}
+		farm.wait();
+
+		delete[] chunks;
+		delete[] initial;
+		delete g;
+		return true;
+	}
+#endif // FASTFLOW
+
+	ThreadPool* pool = NULL;
+	if ( c.nw > 0 )
+	{
+		std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+		pool = new ThreadPool( g, c.nw, vectorization, statistics, NULL, NULL, NULL );
+		samples.setup = (double) std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::high_resolution_clock::now() - t0 ).count();
+	}
+	int* numNeighbours = vectorization ? new int[VLEN] : NULL;
+	GenerationStats stats;
+
+	for ( unsigned int r = 0; r < warmup + reps; r++ )
+	{
+		std::copy( initial, initial + g->size(), g->Read );
+
+		std::chrono::high_resolution_clock::duration serial( 0 );
+		std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+		for ( unsigned int k = 1; k <= iterations; k++ )
+		{
+			if ( pool != NULL )
+			{
+				pool->run_generation( start, chunks, c.grain );
+				if ( statistics ) pool->reduce_statistics( stats );
+			}
+			else
+				compute_chunk( g, numNeighbours, vectorization, start, end, statistics ? &stats : NULL );
+			if ( statistics ) exclude_border( g, start, end, stats );
+			std::chrono::high_resolution_clock::time_point ts = std::chrono::high_resolution_clock::now();
+			end_generation( g, k );
+			serial += std::chrono::high_resolution_clock::now() - ts;
+		}
+		std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+		if ( r >= warmup )
+		{
+			samples.total.push_back( (double) std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count() );
+			samples.serial.push_back( (double) std::chrono::duration_cast<std::chrono::microseconds>( serial ).count() );
+		}
+	}
+
+	delete pool;
+	delete[] chunks;
+	delete[] numNeighbours;
+	delete[] initial;
+	delete g;
+	return true;
+}
+
+bool run_layout_case( BenchCase& c, unsigned int seed, unsigned int iterations, unsigned int warmup, unsigned int reps, BenchSamples& samples )
+{
+	Layout* l = create_layout( c.layout, c.width, c.height );
+	if ( l == NULL )
+	{
+		std::cerr << "Error: unknown layout " << c.layout << "." << std::endl;
+		return false;
+	}
+	if ( c.nw > 0 && !l->parallel() )
+	{
+		std::cerr << "Layout " << c.layout << " cannot be computed in parallel, skipped with " << c.nw << " threads." << std::endl;
+		delete l;
+		return true;
+	}
+
+	// The same initial configuration of the harness of the attempts.
+	std::vector<bool> initial( c.width * c.height );
+	srand( seed );
+	for ( size_t i = 0; i < initial.size(); i++ )
+		initial[i] = ( rand() > RAND_MAX_HALF );
+
+	for ( unsigned int r = 0; r < warmup + reps; r++ )
+	{
+		for ( size_t i = 0; i < c.height; i++ )
+			for ( size_t j = 0; j < c.width; j++ )
+				l->set( i, j, initial[i * c.width + j] );
+		double us = run_layout( l, c.height, c.nw, iterations );
+		if ( r >= warmup ) samples.total.push_back( us );
+	}
+	delete l;
+	return true;
+}
+
+BenchResult summarize( std::vector<double> samples )
+{
+	// Two-sided 95% quantiles of the Student's t distribution, for 1..30 degrees of freedom.
+	static const double t95[30] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+									2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+									2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+	BenchResult r;
+	size_t n = samples.size();
+	std::sort( samples.begin(), samples.end() );
+	r.median = ( n % 2 == 1 ) ? samples[n / 2] : ( samples[n / 2 - 1] + samples[n / 2] ) / 2;
+	r.min = samples.front();
+	r.max = samples.back();
+
+	double sum = 0, sq = 0;
+	for ( size_t i = 0; i < n; i++ ) sum += samples[i];
+	r.mean = sum / n;
+	for ( size_t i = 0; i < n; i++ ) sq += ( samples[i] - r.mean ) * ( samples[i] - r.mean );
+	double half = 0;
+	if ( n > 1 )
+	{
+		double t = ( n - 1 <= 30 ) ? t95[n - 2] : 1.960;
+		half = t * sqrt( sq / ( n - 1 ) ) / sqrt( (double) n );
+	}
+	r.ci_low = r.mean - half;
+	r.ci_high = r.mean + half;
+	return r;
+}
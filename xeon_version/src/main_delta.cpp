@@ -0,0 +1,73 @@
+/**
+ *	@file main_delta.cpp
+ *	@brief Contains the main() function of the tool that reconstructs the generations recorded in a delta file.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <iostream>
+
+#include "../include/program_options.h"
+#include "../include/pattern_io.h"
+#include "../include/delta_stream.h"
+
+/**
+ * Print the content of a delta file written with --deltas and reconstruct one of its generations,
+ * exporting it as a pattern file.
+ */
+int main( int argc, char** argv )
+{
+	ProgramOptions po( argc, argv );
+
+	if ( po.exists( "--help" ) || !po.exists( "--input" ) )
+	{
+		std::cerr << "Usage: " << argv[0] << " --input FILE [options]" << std::endl;
+		std::cerr << "Possible options:" << std::endl;
+		std::cerr << "\t --input FILE \t\t delta file written by GOL_thread or GOL_ff with --deltas ;" << std::endl;
+		std::cerr << "\t --generation NUM \t generation to reconstruct ( default the last one ) ;" << std::endl;
+		std::cerr << "\t --export FILE \t\t export the generation as pattern ( RLE, .cells or .mc depending on the extension ) ;" << std::endl;
+		std::cerr << "\t --help \t\t this help view ;" << std::endl;
+		return 1;
+	}
+
+	DeltaReader reader( po.get( "--input" ) );
+	std::cout << "Grid of " << reader.width() << "x" << reader.height() << " cells, generations from 0 to " << reader.last_generation()
+			  << ", " << reader.keyframes() << " keyframes." << std::endl;
+
+	long generation = po.get_number( "--generation", reader.last_generation() );
+	if ( generation < 0 || !reader.seek( (unsigned int) generation ) )
+	{
+		std::cerr << "Error: the generation " << generation << " is not in the file." << std::endl;
+		return 1;
+	}
+
+	unsigned long long population = 0;
+	for ( size_t i = 0; i < reader.height(); i++ )
+	{
+		const bool* row = reader.row( i );
+		for ( size_t j = 0; j < reader.width(); j++ )
+			population += row[j];
+	}
+	std::cout << "Generation " << generation << ": " << population << " alive cells." << std::endl;
+
+	if ( po.exists( "--export" ) )
+	{
+		save_pattern( po.get( "--export" ), reader );
+		std::cout << "Exported the generation " << generation << " to " << po.get( "--export" ) << "." << std::endl;
+	}
+	return 0;
+}
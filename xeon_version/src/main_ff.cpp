@@ -39,14 +39,20 @@ int main( int argc, char** argv )
 	size_t width, height;
 	unsigned int num_tasks, seed, iterations, nw;
 	Grid* g;
+	Settings settings;
 	// Configure the variables depending on the program options.
-	if ( !menu( argc, argv, vectorization, num_tasks, width, height, seed, iterations, nw ) )
+	if ( !menu( argc, argv, vectorization, num_tasks, width, height, seed, iterations, nw, settings ) )
 		return 1;
-	initialization( vectorization, width, height, seed, g );
+
+	// Out-of-core version
+	if ( settings.store_path != NULL )
+		return ( out_of_core_version( settings, vectorization, width, height, seed, iterations ) ? 0 : 1 );
+
+	initialization( vectorization, width, height, seed, settings, g );
 
 	// Sequential version
 	if ( nw == 0 )
-		return ( sequential_version( g, iterations, vectorization ) ? 0 : 1 );
+		return ( sequential_version( g, iterations, vectorization, settings ) ? 0 : 1 );
 
 #if DEBUG
 	// Initialize the matrix that we will used as verifier.
@@ -60,10 +66,33 @@ int main( int argc, char** argv )
 	size_t* chunks;
 	setup_working_variable( g, num_tasks, nw, start, chunks );
 
+	// The statistics are accumulated by the Workers into the tasks and reduced by the Master.
+	GridPattern gp( g );
+	StatsRecorder* recorder = create_recorder( gp, iterations, settings );
+
+	// Per-worker time accounting, used for the load imbalance report.
+	LoadProfile* profile = settings.imbalance ? new LoadProfile( nw, iterations ) : NULL;
+
+	// Hardware counters of the Workers and of the Master.
+	PerfReport* perf = settings.perf ? new PerfReport() : NULL;
+
+	// Timeline of the tasks, barriers and end_generation phases.
+	Tracer* tracer = ( settings.trace_path != NULL ) ? new Tracer( nw ) : NULL;
+
+	// Readers of the generations, as the checkpoints and the shared memory.
+	SnapshotPublisher* publisher = create_publisher( g, settings );
+	Checkpointer* checkpointer = create_checkpointer( publisher, settings );
+	FrameRing* ring = create_frame_ring( publisher, settings );
+	// Changes of each generation, recorded by each Worker into its own buffer and collected by the Master.
+	DeltaWriter* writer = create_delta_writer( g, settings );
+	DeltaBuffer* worker_changes = ( writer != NULL ) ? new DeltaBuffer[nw] : NULL;
+
 	// Create Farm.
 	std::vector<std::unique_ptr<ff::ff_node>> workers;
 	for ( int t = 0; t < nw; t++ )
-		workers.push_back( ff::make_unique<Worker>( t, g, vectorization ) );
+		workers.push_back( ff::make_unique<Worker>( t, g, vectorization, recorder != NULL, profile, perf,
+													( tracer != NULL ) ? tracer->buffer( t + 1 ) : NULL,
+													( worker_changes != NULL ) ? &worker_changes[t] : NULL ) );
 	// Create the Farm.
 	ff::ff_Farm<> farm( std::move( workers ) );
 
@@ -71,7 +100,8 @@ int main( int argc, char** argv )
 	farm.remove_collector();
 
 	// The scheduler gets in input the internal load-balancer.
-	Master master( farm.getlb(), nw, g, iterations, start, chunks, num_tasks );
+	Master master( farm.getlb(), nw, g, iterations, start, chunks, num_tasks, recorder, profile, perf,
+				   ( tracer != NULL ) ? tracer->buffer( 0 ) : NULL, publisher, writer, worker_changes );
 	farm.add_emitter( master );
 
 	// Adds feedback channels between each worker and the scheduler.
@@ -86,6 +116,12 @@ int main( int argc, char** argv )
 
 	farm.wait();
 	delete[] chunks;
+	delete checkpointer;
+	delete ring;
+	delete publisher;
+	delete writer;
+	delete[] worker_changes;
+	unsigned int generations = ( recorder != NULL ) ? recorder->generations() : iterations;
 
 #if DEBUG
 	// Print only small Grid
@@ -95,7 +131,7 @@ int main( int argc, char** argv )
 		g->print( "OUTPUT" );
 	}
 	// Check if the output is correct.
-	verifier->GOL( iterations );
+	verifier->GOL( generations );
 	if ( verifier->equal() ) std::cout << "TEST OK !!! " << std::endl;
 	else
 	{
@@ -108,5 +144,26 @@ int main( int argc, char** argv )
 	// End - Game of Life
 	t2 = std::chrono::high_resolution_clock::now();
 	printTime( t1, t2, "complete Game of Life" );
+
+	if ( profile != NULL )
+	{
+		profile->report();
+		delete profile;
+	}
+
+	if ( perf != NULL )
+	{
+		perf->report( (unsigned long long) gp.width() * gp.height() * generations );
+		delete perf;
+	}
+
+	if ( tracer != NULL )
+	{
+		tracer->write( settings.trace_path );
+		delete tracer;
+	}
+
+	finalization( gp, settings, recorder );
+	delete recorder;
 	return 0;
 }
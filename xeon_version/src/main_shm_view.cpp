@@ -0,0 +1,82 @@
+/**
+ *	@file main_shm_view.cpp
+ *	@brief Contains the main() function of the viewer that reads the frames of a running Game of Life from the shared memory.
+ *	@author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include "../include/program_options.h"
+#include "../include/frame_ring.h"
+
+// Frames per second written in the header of the stream.
+#define VIEW_FPS 10
+// Time waited before looking again for a new frame, in milliseconds.
+#define VIEW_POLL_MS 1
+
+/**
+ * Write the frames of the ring on the standard output as a YUV4MPEG2 stream ( gray ), readable by ffmpeg or ffplay.
+ * Only the new frames are written: if the viewer is slower than the simulation, the intermediate ones are skipped.
+ */
+int main( int argc, char** argv )
+{
+	ProgramOptions po( argc, argv );
+
+	if ( po.exists( "--help" ) || !po.exists( "--shm" ) )
+	{
+		std::cerr << "Usage: " << argv[0] << " --shm NAME [options] > FILE.y4m" << std::endl;
+		std::cerr << "Possible options:" << std::endl;
+		std::cerr << "\t --shm NAME \t\t shared memory where GOL_thread or GOL_ff export the frames ;" << std::endl;
+		std::cerr << "\t --frames NUM \t\t stop after NUM frames ( default zero, until the end of the simulation ) ;" << std::endl;
+		std::cerr << "\t --help \t\t this help view ;" << std::endl;
+		return 1;
+	}
+
+	FrameRingReader ring( po.get( "--shm" ) );
+	const FrameRingHeader* h = ring.info();
+	long max_frames = po.get_number( "--frames", 0 );
+	std::cerr << "Frames of " << h->width << "x" << h->height << " pixels, " << h->scale << "x" << h->scale << " cells each." << std::endl;
+
+	std::vector<unsigned char> frame( h->width * h->height );
+	printf( "YUV4MPEG2 W%llu H%llu F%d:1 Ip A1:1 Cmono\n", (unsigned long long) h->width, (unsigned long long) h->height, VIEW_FPS );
+	uint64_t generation, last = 0;
+	long written = 0;
+	bool first = true;
+	while ( max_frames == 0 || written < max_frames )
+	{
+		// Read the flag before the frame, so that the last frame is not lost.
+		bool finished = ( h->finished.load( std::memory_order_acquire ) != 0 );
+		if ( ring.copy_latest( frame.data(), generation ) && ( first || generation != last ) )
+		{
+			fputs( "FRAME\n", stdout );
+			fwrite( frame.data(), 1, frame.size(), stdout );
+			fflush( stdout );
+			last = generation;
+			first = false;
+			written++;
+		}
+		else if ( finished ) break;
+		else std::this_thread::sleep_for( std::chrono::milliseconds( VIEW_POLL_MS ) );
+	}
+	std::cerr << "Written " << written << " frames, the last one is the generation " << last << "." << std::endl;
+	return 0;
+}
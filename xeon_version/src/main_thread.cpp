@@ -21,47 +21,15 @@
 
 #include <iostream>
 #include <chrono>
-#include <vector>
-#include <thread>
-#include <atomic>
 
 #include "../include/grid.h"
 #include "../include/shared_functions.h"
+#include "../include/thread_pool.h"
+#include "../include/probes.h"
 #if DEBUG
 #include "../include/matrix.h"
 #endif // DEBUG
 
-#define LOOSE_SOME_TIME 1000
-
-/**
- * Function executed by the thread.
- * @param id				thread identifier
- * @param g					shared object of \see Grid class.
- * @param vectorization		<code>true</code> if the function has to be parallelized.
- * @param start				location address where main() stores index of starting working area.
- * @param end				location address where main() stores index of ending working area.
- * @param terminate			shared atomic variable used to control the thread termination.
- * @param busy				shared atomic variable used to check if the thread is still working or assign to it work to do.
- */
-void thread_body( int id, Grid* g, bool vectorization, size_t* start, size_t* end, std::atomic<bool>* terminate, std::atomic<bool>* busy );
-
-/**
- * Find the first thread free ( not busy ).
- * We remind that each thread has its own element of the busy array, shared only with main().
- * It scan this busy array, looking for the first thread free, until it finds one.
- * @param busy		array of atomic variables.
- * @param nw		number of threads.
- */
-int find_first_thread_free( std::atomic<bool>* busy, unsigned int nw );
-
-/**
- * Wait until all threads have finish their jobs.
- * It wait the termination of the first thread, than wait for the second, and so on.
- * @param busy		array of atomic variables.
- * @param nw		number of threads.
- */
-long barrier( std::atomic<bool>* busy, unsigned int nw );
-
 int main( int argc, char** argv )
 {
 	std::chrono::high_resolution_clock::time_point t1, t2;
@@ -69,14 +37,20 @@ int main( int argc, char** argv )
 	size_t width, height;
 	unsigned int seed, iterations, nw, num_tasks;
 	Grid* g;
+	Settings settings;
 	// Configure the variables depending on the program options.
-	if ( !menu( argc, argv, vectorization, num_tasks, width, height, seed, iterations, nw ) )
+	if ( !menu( argc, argv, vectorization, num_tasks, width, height, seed, iterations, nw, settings ) )
 		return 1;
-	initialization( vectorization, width, height, seed, g );
+
+	// Out-of-core version
+	if ( settings.store_path != NULL )
+		return ( out_of_core_version( settings, vectorization, width, height, seed, iterations ) ? 0 : 1 );
+
+	initialization( vectorization, width, height, seed, settings, g );
 
 	// Sequential version
 	if ( nw == 0 )
-		return ( sequential_version( g, iterations, vectorization ) ? 0 : 1 );
+		return ( sequential_version( g, iterations, vectorization, settings ) ? 0 : 1 );
 
 #if DEBUG
 	// Initialize the matrix that we will used as verifier.
@@ -89,72 +63,116 @@ int main( int argc, char** argv )
 	size_t start;
 	size_t* chunks;
 	setup_working_variable( g, num_tasks, nw, start, chunks );
+	size_t end = g->size() - g->width() - 1;
+
+	// The statistics of each thread are reduced by the main() at the barrier.
+	GridPattern gp( g );
+	StatsRecorder* recorder = create_recorder( gp, iterations, settings );
 
-	// If busy[i] is true, means that the i-th thread has received a task or is still computing its task.
-	std::atomic<bool>* busy = new std::atomic<bool>[nw];
-	// If true, all thread has to terminate their execution.
-	std::atomic<bool> terminate;
-	terminate.store( false );
-	// Index of the starting and ending working area.
-	// The main() changes these values in order to control the work of the threads.
-	size_t* starts = new size_t[nw];
-	size_t* ends = new size_t[nw];
+	// Per-worker time accounting, used for the load imbalance report.
+	LoadProfile* profile = settings.imbalance ? new LoadProfile( nw, iterations ) : NULL;
+
+	// Hardware counters of the workers and of this thread, which scatters the tasks and executes the serial phase.
+	PerfReport* perf = settings.perf ? new PerfReport() : NULL;
+	PerfCounters* counters = settings.perf ? new PerfCounters() : NULL;
+
+	// Timeline of the tasks, barriers and end_generation phases.
+	Tracer* tracer = ( settings.trace_path != NULL ) ? new Tracer( nw ) : NULL;
+
+	// Readers of the generations, as the checkpoints and the shared memory.
+	SnapshotPublisher* publisher = create_publisher( g, settings );
+	Checkpointer* checkpointer = create_checkpointer( publisher, settings );
+	FrameRing* ring = create_frame_ring( publisher, settings );
+	// Changes of each generation, collected from the threads and handed over to the writer of the delta file.
+	DeltaWriter* writer = create_delta_writer( g, settings );
+	DeltaBuffer changes;
 
 	// Create and start the workers.
-	std::vector<std::thread> tid;
-	for( int t = 0; t < nw; t++ )
-	{
-		busy[t].store( false );
-		tid.push_back( std::thread( thread_body, t, g, vectorization, &starts[t], &ends[t], &terminate, &busy[t] ) );
-	}
+	ThreadPool* pool = new ThreadPool( g, nw, vectorization, recorder != NULL, profile, perf, tracer, writer != NULL );
 
 	// End - Creating Threads.
 	t2 = std::chrono::high_resolution_clock::now();
 	printTime( t1, t2, "creating threads" );
 
 	// Compute GOL
-	long copyborder_time = 0, barrier_time = 0;
+	unsigned long long copyborder_time = 0, barrier_time = 0;
+	std::chrono::high_resolution_clock::time_point tg, ts, te;
 	for ( unsigned int k = 1; k <= iterations; k++ )
 	{
-		unsigned int counter_sent_tasks = 0;
-		size_t start_chunk, end_chunk = start;
-
-		while ( counter_sent_tasks < num_tasks )
+		tg = std::chrono::high_resolution_clock::now();
+		PROBE_GENERATION_START( k );
+		if ( counters != NULL ) counters->start();
+		barrier_time += pool->run_generation( start, chunks, num_tasks );
+		if ( counters != NULL ) counters->stop( PERF_BARRIER );
+		bool stop = false;
+		if ( recorder != NULL )
 		{
-			int t = find_first_thread_free( busy, nw );
-			start_chunk = end_chunk;
-			end_chunk = start_chunk + chunks[counter_sent_tasks];
-			counter_sent_tasks++;
-			starts[t] = start_chunk;
-			ends[t] = end_chunk;
-			busy[t].store( true );
+			// Reduce the statistics of the threads.
+			GenerationStats stats;
+			pool->reduce_statistics( stats );
+			exclude_border( g, start, end, stats );
+			stop = recorder->record( stats );
 		}
-
-		barrier_time += barrier( busy, nw );
-		copyborder_time += end_generation( g, k );
+		ts = std::chrono::high_resolution_clock::now();
+		if ( writer != NULL )
+		{
+			pool->collect_changes( changes );
+			writer->record( k, changes );
+		}
+		copyborder_time += end_generation( g, k, publisher );
+		if ( counters != NULL ) counters->stop( PERF_SERIAL );
+		te = std::chrono::high_resolution_clock::now();
+		PROBE_GENERATION_END( k );
+		record_generation( tg, te );
+		if ( profile != NULL )
+			profile->add_generation( k - 1, tg, ts, te );
+		if ( tracer != NULL )
+			tracer->buffer( 0 )->add( "end_generation", ts, te, k - 1 );
+		if ( stop ) break;
 	}
 
-	// Terminate all threads.
-	for ( int t = 0; t < nw; t++ )
-		terminate.store( true );
-
-	// Await the threads termination.
-	for ( int t = 0; t < nw; t++ )
-		tid[t].join();
+	// Terminate all threads and await their termination.
+	delete pool;
 	delete[] chunks;
+	delete checkpointer;
+	delete ring;
+	delete publisher;
+	delete writer;
 
-#if TAKE_ALL_TIME
-	// Print the total time in order to compute the end_generation functions.
-	printTime( copyborder_time, "copy border" );
+	if ( take_all_time )
+	{
+		// Print the total time in order to compute the end_generation functions.
+		printTime( TscTimer::microseconds( copyborder_time ), "copy border" );
 
-	// Print the total time in order to compute the barrier phase.
-	printTime( barrier_time, "barrier phase" );
-#endif // TAKE_ALL_TIME
+		// Print the total time in order to compute the barrier phase.
+		printTime( TscTimer::microseconds( barrier_time ), "barrier phase" );
+	}
 
 	// End - Game of Life
 	t2 = std::chrono::high_resolution_clock::now();
 	printTime( t1, t2, "complete Game of Life" );
 
+	if ( profile != NULL )
+	{
+		profile->report();
+		delete profile;
+	}
+
+	unsigned int generations = ( recorder != NULL ) ? recorder->generations() : iterations;
+	if ( perf != NULL )
+	{
+		perf->add( *counters );
+		perf->report( (unsigned long long) gp.width() * gp.height() * generations );
+		delete counters;
+		delete perf;
+	}
+
+	if ( tracer != NULL )
+	{
+		tracer->write( settings.trace_path );
+		delete tracer;
+	}
+
 #if DEBUG
 	// Print only small Grid
 	if ( g->width() <= MAX_PRINTABLE_GRID && g->height() <= MAX_PRINTABLE_GRID )
@@ -164,7 +182,7 @@ int main( int argc, char** argv )
 	}
 
 	// Check if the output is correct.
-	verifier->GOL( iterations );
+	verifier->GOL( generations );
 	if ( verifier->equal() ) std::cout << "TEST OK !!! " << std::endl;
 	else
 	{
@@ -173,87 +191,8 @@ int main( int argc, char** argv )
 		return 1;
 	}
 #endif // DEBUG
-	return 0;
-}
-
-void thread_body( int id, Grid* g, bool vectorization, size_t* start, size_t* end, std::atomic<bool>* terminate, std::atomic<bool>* busy )
-{
-	int* numNeighbours = NULL;
-	if ( vectorization )
-		numNeighbours = new int[VLEN];
-
-	// Loop until the master does not say that it can terminate.
-	while ( !terminate->load() )
-	{
-		// Enters in a busy-looping until there is not work to do or has to terminate.
-		while ( !busy->load() && !terminate->load() );
-
-		// If does not have to terminate, it executes its job.
-		if ( !terminate->load() )
-		{
-#if VECTORIZATION
-			// Execute the job on the assigned chunk.
-			if ( vectorization )
-				compute_generation_vect( g, numNeighbours, *start, *end );
-			else
-				compute_generation( g, *start, *end );
-#else
-			compute_generation( g, *start, *end );
-#endif // VECTORIZATION
-
-			// Signal that now is free.
-			busy->store( false );
-		}
-	}
-
-	if ( vectorization )
-		delete[] numNeighbours;
-}
-
-int find_first_thread_free( std::atomic<bool>* busy, unsigned int nw )
-{
-	int found = -1;
-	// Repeat looking to a free thread until it founds one.
-	while ( found == -1 )
-	{
-		// Scan all threads sequentially.
-		for ( int i = 0; i < nw; i++ )
-		{
-			// We have finish when we found a not busy thread.
-			if ( !busy[i].load() )
-			{
-				found = i;
-				break;
-			}
-		}
-	}
-	return found;
-}
-
-long barrier( std::atomic<bool>* busy, unsigned int nw )
-{
-#if TAKE_ALL_TIME
-	std::chrono::high_resolution_clock::time_point t1, t2;
-	// Start - Barrier phase.
-	t1 = std::chrono::high_resolution_clock::now();
-#endif // TAKE_ALL_TIME
-
-	// Scan all threads sequentially and wait that all finish their jobs.
-	for ( int i = 0; i < nw; i++ )
-	{
-		// Wait until the thread has not finish its job, i.e. is not busy anymore.
-		while ( busy[i].load() )
-		{
-			// Loose some time before retrying.
-			for ( volatile unsigned int j = 0; j < LOOSE_SOME_TIME; j++ );
-		}
-	}
 
-#if TAKE_ALL_TIME
-	// End - Barrier phase.
-	t2 = std::chrono::high_resolution_clock::now();
-	return std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
-#else
+	finalization( gp, settings, recorder );
+	delete recorder;
 	return 0;
-#endif // TAKE_ALL_TIME
-}
\ No newline at end of file
+}
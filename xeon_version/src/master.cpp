@@ -21,19 +21,36 @@
 
 
 #include "../include/master.h"
+#include "../include/probes.h"
 
-Master::Master( ff::ff_loadbalancer* const lb, unsigned int nw, Grid* g, unsigned int iterations, size_t start, size_t* chunks, unsigned int num_tasks )
-			: lb(lb), num_workers(nw), g(g), iterations(iterations), start(start),
-			  chunks(chunks), num_tasks(num_tasks)
+Master::Master( ff::ff_loadbalancer* const lb, unsigned int nw, Grid* g, unsigned int iterations, size_t start, size_t* chunks, unsigned int num_tasks, StatsRecorder* recorder, LoadProfile* profile, PerfReport* perf, TraceBuffer* trace, SnapshotPublisher* publisher, DeltaWriter* deltas, DeltaBuffer* worker_changes )
+			: g(g), chunks(chunks), recorder(recorder), profile(profile), perf(perf), trace(trace), publisher(publisher), deltas(deltas),
+			  worker_changes(worker_changes), lb(lb), iterations(iterations), num_workers(nw), num_tasks(num_tasks), start(start)
 {
+	this->counters = nullptr;
+}
+
+int Master::svc_init()
+{
+	// The state of the run is reset here, so that a frozen farm can be run again.
 	this->completed_iterations = 0;
 	this->start_chunk = 0;
-	this->end_chunk = start;
+	this->end_chunk = this->start;
 	this->counter_complete_tasks = 0;
 	this->counter_sent_tasks = 0;
 	this->copyborder_time = 0;
-	this->barrier_time = 0;
+	this->barrier_timer = TscAccumulator();
 	this->first_worker = true;
+	// A run stopped by a cycle can leave the reductions of a partial generation.
+	this->stats.reset();
+	this->changes.clear();
+	if ( this->worker_changes != nullptr )
+		for ( unsigned int t = 0; t < this->num_workers; t++ )
+			this->worker_changes[t].clear();
+	// The counters have to be opened by the thread that they measure.
+	if ( this->perf != nullptr )
+		this->counters = new PerfCounters();
+	return 0;
 }
 
 Task_t* Master::svc( Task_t* task )
@@ -46,38 +63,56 @@ Task_t* Master::svc( Task_t* task )
 	}
 	else
 	{
-		// Increment the counter of complete tasks and delete the task.
+		// Increment the counter of complete tasks, reduce its statistics and delete the task.
 		this->counter_complete_tasks++;
+		if ( this->recorder != nullptr )
+			this->stats += task->stats;
 		delete( task );
 
 		// Get the worker identifier of who is responding.
 		int worker_id = lb->get_channel_id();
+		PROBE_TASK_COMPLETE( worker_id );
 
 		// If it did not complete scattering the Grid.
 		if ( this->counter_sent_tasks < this->num_tasks )
 		{
 			Task_t* task = create_new_task();
+			PROBE_TASK_DISPATCH( worker_id, task->start, task->end );
 			this->lb->ff_send_out_to( task, worker_id );
 		}
-#if TAKE_ALL_TIME
 		else if ( this->first_worker )
 		{
 			// When it has completed to scatter the Grid, it start counting the Barrier Phase
 			// from the first Worker that answer back.
 			// Start - Barrier Phase
-			t1 = std::chrono::high_resolution_clock::now();
+			if ( this->trace != nullptr )
+				t1 = std::chrono::high_resolution_clock::now();
 			this->first_worker = false;
+			PROBE_BARRIER_ENTER( this->completed_iterations + 1 );
+			if ( take_all_time ) this->barrier_timer.start();
 		}
-#endif // TAKE_ALL_TIME
 
 		// If the counter is equal to the total number of tasks, we complete the iteration.
 		if ( this->counter_complete_tasks == this->num_tasks )
 		{
-#if TAKE_ALL_TIME
 			// End - Barrier Phase
-			t2 = std::chrono::high_resolution_clock::now();
-			barrier_time += std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
-#endif // TAKE_ALL_TIME
+			PROBE_BARRIER_EXIT( this->completed_iterations + 1 );
+			if ( take_all_time ) this->barrier_timer.stop();
+			if ( this->trace != nullptr )
+			{
+				t2 = std::chrono::high_resolution_clock::now();
+				this->trace->add( "barrier", t1, t2, this->completed_iterations );
+			}
+			if ( this->counters != nullptr ) this->counters->stop( PERF_BARRIER );
+
+			// Record the statistics of the generation, before end_generation swaps the Grid.
+			bool stop = false;
+			if ( this->recorder != nullptr )
+			{
+				exclude_border( this->g, this->start, this->end_chunk, this->stats );
+				stop = this->recorder->record( this->stats );
+				this->stats.reset();
+			}
 
 			// Reset the accumulators that tracks the starting and ending point of the current chunk.
 			this->start_chunk = 0;
@@ -94,18 +129,33 @@ Task_t* Master::svc( Task_t* task )
 			this->completed_iterations++;
 
 			// Compute the action necessary to complete the computation of this generation.
-			copyborder_time += end_generation( g, this->completed_iterations );
-
-			// Send EOS if we completed all the iterations.
-			if ( this->completed_iterations == this->iterations )
+			std::chrono::high_resolution_clock::time_point ts = std::chrono::high_resolution_clock::now();
+			if ( this->deltas != nullptr )
+			{
+				this->collect_changes();
+				this->deltas->record( this->completed_iterations, this->changes );
+			}
+			copyborder_time += end_generation( g, this->completed_iterations, this->publisher );
+			if ( this->counters != nullptr ) this->counters->stop( PERF_SERIAL );
+			std::chrono::high_resolution_clock::time_point te = std::chrono::high_resolution_clock::now();
+			PROBE_GENERATION_END( this->completed_iterations );
+			record_generation( this->generation_start, te );
+			if ( this->profile != nullptr )
+				this->profile->add_generation( this->completed_iterations - 1, this->generation_start, ts, te );
+			if ( this->trace != nullptr )
+				this->trace->add( "end_generation", ts, te, this->completed_iterations - 1 );
+
+			// Send EOS if we completed all the iterations or the grid fell into a cycle.
+			if ( this->completed_iterations == this->iterations || stop )
 			{
-#if TAKE_ALL_TIME
-				// Print the total time in order to compute the end_generation functions.
-				printTime( copyborder_time, "copy border" );
+				if ( take_all_time )
+				{
+					// Print the total time in order to compute the end_generation functions.
+					printTime( TscTimer::microseconds( copyborder_time ), "copy border" );
 
-				// Print the total time in order to compute the barrier phase.
-				printTime( barrier_time, "barrier phase" );
-#endif // TAKE_ALL_TIME
+					// Print the total time in order to compute the barrier phase.
+					printTime( this->barrier_timer.microseconds(), "barrier phase" );
+				}
 
 				return EOS;
 			}
@@ -126,7 +176,17 @@ Task_t* Master::create_new_task()
 	this->start_chunk = this->end_chunk;
 	this->end_chunk = this->start_chunk + this->chunks[this->counter_sent_tasks];
 	this->counter_sent_tasks++;
-	return new Task_t( this->start_chunk, this->end_chunk );
+	return new Task_t( this->start_chunk, this->end_chunk, this->completed_iterations );
+}
+
+void Master::collect_changes()
+{
+	// The Workers have returned all the tasks of the generation, so their buffers are not being written.
+	for ( unsigned int t = 0; t < this->num_workers; t++ )
+	{
+		this->changes.insert( this->changes.end(), this->worker_changes[t].begin(), this->worker_changes[t].end() );
+		this->worker_changes[t].clear();
+	}
 }
 
 void Master::send_one_task_x_worker()
@@ -135,6 +195,7 @@ void Master::send_one_task_x_worker()
 	for ( int i = 0; i < this->num_workers; i++ )
 	{
 		Task_t* task = create_new_task();
+		PROBE_TASK_DISPATCH( i, task->start, task->end );
 		// Send Task to the next Worker.
 		this->lb->ff_send_out_to( task, i );
 	}
@@ -142,8 +203,22 @@ void Master::send_one_task_x_worker()
 
 void Master::send_tasks()
 {
+	// A new generation starts.
+	this->generation_start = std::chrono::high_resolution_clock::now();
+	PROBE_GENERATION_START( this->completed_iterations + 1 );
+	if ( this->counters != nullptr ) this->counters->start();
 	send_one_task_x_worker();
 	// If we have two task per Worker, do overbooking technique.
 	if ( this->num_tasks > 2*this->num_workers )
 		send_one_task_x_worker();
-}
\ No newline at end of file
+}
+
+void Master::svc_end()
+{
+	if ( this->counters != nullptr )
+	{
+		this->perf->add( *this->counters );
+		delete this->counters;
+		this->counters = nullptr;
+	}
+}
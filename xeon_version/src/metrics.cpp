@@ -0,0 +1,157 @@
+/**
+ *	@file metrics.cpp
+ *  @brief Implementation of \see Metrics class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <fstream>
+#include <cctype>
+#include <cstdio>
+#include <sys/resource.h>
+
+#include "../include/metrics.h"
+
+Metrics* run_metrics = NULL;
+
+Metrics::Metrics( const char* program, size_t width, size_t height )
+		: program(program), width(width), height(height)
+{
+	// Keep only the name of the executable.
+	size_t slash = this->program.find_last_of( '/' );
+	if ( slash != std::string::npos )
+		this->program = this->program.substr( slash + 1 );
+}
+
+void Metrics::set_config( const char* name, long value )
+{
+	this->config.push_back( std::make_pair( std::string( name ), std::to_string( (long long) value ) ) );
+}
+
+void Metrics::set_config( const char* name, bool value )
+{
+	this->config.push_back( std::make_pair( std::string( name ), std::string( value ? "true" : "false" ) ) );
+}
+
+void Metrics::add_phase( const char* name, long duration )
+{
+	// Convert the message into a key: lower case words separated by underscores.
+	std::string key( name );
+	for ( size_t i = 0; i < key.size(); i++ )
+		key[i] = ( key[i] == ' ' ) ? '_' : (char) tolower( key[i] );
+
+	for ( size_t i = 0; i < this->phases.size(); i++ )
+	{
+		if ( this->phases[i].first == key )
+		{
+			this->phases[i].second += duration;
+			return;
+		}
+	}
+	this->phases.push_back( std::make_pair( key, duration ) );
+}
+
+void Metrics::add_generation( long duration )
+{
+	this->generations.push_back( duration );
+}
+
+void Metrics::add_generation( std::chrono::high_resolution_clock::time_point t1, std::chrono::high_resolution_clock::time_point t2 )
+{
+	this->add_generation( (long) std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count() );
+}
+
+double Metrics::cells_per_second() const
+{
+	// Compute the throughput on the time of the complete Game of Life.
+	for ( size_t i = 0; i < this->phases.size(); i++ )
+		if ( this->phases[i].first == "complete_game_of_life" && this->phases[i].second > 0 )
+			return (double) this->width * this->height * this->generations.size() * 1e6 / this->phases[i].second;
+	return 0;
+}
+
+void Metrics::set_section( const char* name, const std::string& json )
+{
+	for ( size_t i = 0; i < this->sections.size(); i++ )
+	{
+		if ( this->sections[i].first == name )
+		{
+			this->sections[i].second = json;
+			return;
+		}
+	}
+	this->sections.push_back( std::make_pair( std::string( name ), json ) );
+}
+
+void Metrics::write( const char* path ) const
+{
+	std::ofstream f( path );
+	if ( f.fail() )
+	{
+		std::cerr << "Error: it is not possible to create the metrics file " << path << "." << std::endl;
+		exit( 1 );
+	}
+
+	// Peak resident set size, in kilobytes on Linux.
+	struct rusage usage;
+	getrusage( RUSAGE_SELF, &usage );
+
+	f << "{" << std::endl;
+	f << "\t\"program\": " << json_string( this->program ) << "," << std::endl;
+	f << "\t\"config\": { \"width\": " << this->width << ", \"height\": " << this->height;
+	for ( size_t i = 0; i < this->config.size(); i++ )
+		f << ", " << json_string( this->config[i].first ) << ": " << this->config[i].second;
+	f << " }," << std::endl;
+
+	f << "\t\"phases_us\": {";
+	for ( size_t i = 0; i < this->phases.size(); i++ )
+		f << ( ( i > 0 ) ? ", " : " " ) << json_string( this->phases[i].first ) << ": " << this->phases[i].second;
+	f << " }," << std::endl;
+
+	f << "\t\"generations\": " << this->generations.size() << "," << std::endl;
+	f << "\t\"generations_us\": [";
+	for ( size_t i = 0; i < this->generations.size(); i++ )
+		f << ( ( i > 0 ) ? ", " : " " ) << this->generations[i];
+	f << " ]," << std::endl;
+
+	for ( size_t i = 0; i < this->sections.size(); i++ )
+		f << "\t" << json_string( this->sections[i].first ) << ": " << this->sections[i].second << "," << std::endl;
+
+	f << "\t\"cells_per_second\": " << (unsigned long long) this->cells_per_second() << "," << std::endl;
+	f << "\t\"peak_rss_kb\": " << usage.ru_maxrss << std::endl;
+	f << "}" << std::endl;
+}
+
+std::string json_string( const std::string& s )
+{
+	std::string out( 1, '"' );
+	for ( size_t i = 0; i < s.size(); i++ )
+	{
+		unsigned char c = (unsigned char) s[i];
+		if ( c == '"' || c == '\\' ) out += '\\';
+		if ( c >= 0x20 )
+		{
+			out += (char) c;
+			continue;
+		}
+		// The control characters are written as \u00XX.
+		char code[8];
+		snprintf( code, sizeof(code), "\\u%04x", c );
+		out += code;
+	}
+	return out + '"';
+}
@@ -0,0 +1,640 @@
+/**
+ *	@file pattern_io.cpp
+ *  @brief Implementation of the functions that import and export GOL patterns ( RLE, plaintext .cells and Macrocell ).
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "../include/pattern_io.h"
+
+// Maximum length of the lines written in a RLE file.
+#define RLE_LINE_LENGTH 70
+// Size of the buffer used to read the pattern files.
+#define READ_BUFFER_SIZE 65536
+// Level of the Macrocell leaves ( 8x8 cells ).
+#define MC_LEAF_LEVEL 3
+
+namespace
+{
+	/// Buffered character reader used by the streaming parsers.
+	class CharReader
+	{
+	public:
+		CharReader( const char* path ) : pos(0), len(0), line(1)
+		{
+			this->f = fopen( path, "rb" );
+			if ( this->f == NULL )
+			{
+				std::cerr << "Error: it is not possible to open the pattern file " << path << "." << std::endl;
+				exit( 1 );
+			}
+		}
+
+		// Return the next character without consuming it, or EOF.
+		int peek()
+		{
+			if ( this->pos == this->len )
+			{
+				this->len = fread( this->buffer, 1, READ_BUFFER_SIZE, this->f );
+				this->pos = 0;
+				if ( this->len == 0 ) return EOF;
+			}
+			return (unsigned char) this->buffer[this->pos];
+		}
+
+		// Consume and return the next character, or EOF.
+		int get()
+		{
+			int c = this->peek();
+			if ( c != EOF ) this->pos++;
+			if ( c == '\n' ) this->line++;
+			return c;
+		}
+
+		// Read the rest of the current line, newline excluded.
+		bool getline( std::string& s )
+		{
+			s.clear();
+			int c = this->get();
+			if ( c == EOF ) return false;
+			while ( c != EOF && c != '\n' )
+			{
+				if ( c != '\r' ) s.push_back( (char) c );
+				c = this->get();
+			}
+			return true;
+		}
+
+		// Return the line number of the next character.
+		size_t line_number() const { return this->line; }
+
+		~CharReader() { fclose( this->f ); }
+
+	private:
+		FILE* f;
+		char buffer[READ_BUFFER_SIZE];
+		size_t pos, len, line;
+	};
+
+	/// Place the runs of alive cells into the grid, wrapping around the toroidal grid.
+	class Placer
+	{
+	public:
+		Placer( PatternGrid& grid, size_t row_offset, size_t col_offset )
+			: grid(grid), rows(grid.height()), cols(grid.width())
+		{
+			this->base_row = row_offset % this->rows;
+			this->base_col = col_offset % this->cols;
+		}
+
+		// Move the origin of the pattern by a signed displacement.
+		void shift( long long di, long long dj )
+		{
+			this->base_row = wrap( (long long) this->base_row + di, this->rows );
+			this->base_col = wrap( (long long) this->base_col + dj, this->cols );
+		}
+
+		// Set alive <em>count</em> cells of the pattern, starting from the cell (i, j) of the pattern.
+		void place( unsigned long long i, unsigned long long j, unsigned long long count )
+		{
+			size_t r = ( this->base_row + i % this->rows ) % this->rows;
+			size_t c = ( this->base_col + j % this->cols ) % this->cols;
+			// A run longer than the grid width would only overwrite itself.
+			count = std::min( count, (unsigned long long) this->cols );
+			while ( count > 0 )
+			{
+				size_t n = std::min( (size_t) count, this->cols - c );
+				this->grid.set_alive( r, c, n );
+				count -= n;
+				c = 0;
+			}
+		}
+
+		// Return the size of the grid.
+		size_t height() const { return this->rows; }
+		size_t width() const { return this->cols; }
+
+	private:
+		static size_t wrap( long long v, size_t n )
+		{
+			long long m = v % (long long) n;
+			return (size_t) ( m < 0 ? m + (long long) n : m );
+		}
+
+		PatternGrid& grid;
+		size_t rows, cols, base_row, base_col;
+	};
+
+	void parse_error( const char* path, size_t line, const std::string& msg )
+	{
+		std::cerr << "Error parsing pattern file " << path << " at line " << line << ": " << msg << std::endl;
+		exit( 1 );
+	}
+
+	bool has_extension( const char* path, const char* ext )
+	{
+		size_t lp = strlen( path ), le = strlen( ext );
+		if ( lp < le ) return false;
+		for ( size_t i = 0; i < le; i++ )
+			if ( tolower( path[lp - le + i] ) != ext[i] ) return false;
+		return true;
+	}
+
+	// Check that the rule is the one of Conway's Game of Life, otherwise warn the user.
+	void check_rule( std::string rule )
+	{
+		std::string r;
+		for ( char c : rule )
+			if ( !isspace( (unsigned char) c ) ) r.push_back( (char) toupper( (unsigned char) c ) );
+		if ( !r.empty() && r != "B3/S23" && r != "23/3" && r != "S23/B3" )
+			std::cerr << "Warning: pattern rule " << rule << " is not B3/S23, it will be evolved as Conway's Game of Life." << std::endl;
+	}
+
+	void load_rle( const char* path, Placer& placer )
+	{
+		CharReader in( path );
+		std::string s;
+		// Size of the pattern, which bounds the runs; without the header, it is the size of the grid.
+		unsigned long long width = placer.width(), height = placer.height();
+
+		// Header: comment lines, followed by the optional "x = m, y = n, rule = abc" line.
+		while ( in.peek() == '#' || in.peek() == 'x' || in.peek() == '\n' || in.peek() == '\r' )
+		{
+			in.getline( s );
+			if ( s.compare( 0, 6, "#CXRLE" ) == 0 )
+			{
+				size_t p = s.find( "Pos=" );
+				long long x, y;
+				if ( p != std::string::npos && sscanf( s.c_str() + p, "Pos=%lld,%lld", &x, &y ) == 2 )
+					placer.shift( y, x );
+			}
+			else if ( !s.empty() && s[0] == 'x' )
+			{
+				long long x, y;
+				if ( sscanf( s.c_str(), "x = %lld , y = %lld", &x, &y ) != 2 || x < 0 || y < 0 )
+					parse_error( path, in.line_number() - 1, "the header has to be \"x = m, y = n\"." );
+				width = (unsigned long long) x;
+				height = (unsigned long long) y;
+				size_t p = s.find( "rule" );
+				if ( p != std::string::npos && ( p = s.find( '=', p ) ) != std::string::npos )
+					check_rule( s.substr( p + 1 ) );
+				break;
+			}
+		}
+
+		// Body: <run_count><tag> items, where the tag is b (dead), o (alive) or $ (end of line).
+		// The runs cannot go past the size of the pattern, so a corrupt count is rejected before it wraps.
+		unsigned long long i = 0, j = 0, n = 0, limit = std::max( width, height );
+		for ( int c = in.get(); c != EOF && c != '!'; c = in.get() )
+		{
+			if ( isdigit( c ) )
+			{
+				unsigned long long digit = (unsigned long long) ( c - '0' );
+				if ( digit > limit || n > ( limit - digit ) / 10 )
+					parse_error( path, in.line_number(), "run count larger than the size of the pattern." );
+				n = n * 10 + digit;
+			}
+			else if ( isspace( c ) )
+				continue;
+			else
+			{
+				unsigned long long count = ( n == 0 ) ? 1 : n;
+				n = 0;
+				if ( c == '$' )
+				{
+					if ( count > height - i )
+						parse_error( path, in.line_number(), "the rows exceed the height of the pattern." );
+					i += count;
+					j = 0;
+					continue;
+				}
+				if ( !isalpha( c ) && c != '.' )
+					parse_error( path, in.line_number(), std::string( "unexpected character '" ) + (char) c + "'." );
+				if ( i >= height || count > width - j )
+					parse_error( path, in.line_number(), "the run exceeds the size of the pattern." );
+				// Any other state of multi-state rules is considered alive.
+				if ( c != 'b' && c != '.' )
+					placer.place( i, j, count );
+				j += count;
+			}
+		}
+	}
+
+	void load_cells( const char* path, Placer& placer )
+	{
+		CharReader in( path );
+		std::string s;
+		unsigned long long i = 0;
+		while ( in.getline( s ) )
+		{
+			// Lines starting with '!' are comments.
+			if ( !s.empty() && s[0] == '!' ) continue;
+			size_t j = 0;
+			while ( j < s.size() )
+			{
+				if ( s[j] == 'O' || s[j] == '*' )
+				{
+					size_t first = j;
+					while ( j < s.size() && ( s[j] == 'O' || s[j] == '*' ) ) j++;
+					placer.place( i, first, j - first );
+				}
+				else if ( s[j] == '.' || isspace( (unsigned char) s[j] ) )
+					j++;
+				else
+					parse_error( path, in.line_number() - 1, std::string( "unexpected character '" ) + s[j] + "'." );
+			}
+			i++;
+		}
+	}
+
+	/// Node of a Macrocell quadtree: a 8x8 leaf or a node with four children ( nw, ne, sw, se ).
+	struct MCNode
+	{
+		int level;
+		size_t child[4];
+		unsigned char bits[8];
+	};
+
+	void emit_macrocell( const std::vector<MCNode>& nodes, size_t index, unsigned long long i, unsigned long long j, Placer& placer )
+	{
+		if ( index == 0 ) return;
+		const MCNode& node = nodes[index];
+		if ( node.level == MC_LEAF_LEVEL && node.child[0] == 0 && node.child[1] == 0 && node.child[2] == 0 && node.child[3] == 0 )
+		{
+			// Leaf: forward every run of alive cells of its rows.
+			for ( int r = 0; r < 8; r++ )
+			{
+				int c = 0;
+				while ( c < 8 )
+				{
+					if ( node.bits[r] & ( 1 << c ) )
+					{
+						int first = c;
+						while ( c < 8 && ( node.bits[r] & ( 1 << c ) ) ) c++;
+						placer.place( i + r, j + first, c - first );
+					}
+					else c++;
+				}
+			}
+		}
+		else if ( node.level == 1 )
+		{
+			// Level one nodes of multi-state rules contain directly the cell states.
+			for ( int q = 0; q < 4; q++ )
+				if ( node.child[q] != 0 ) placer.place( i + q / 2, j + q % 2, 1 );
+		}
+		else
+		{
+			unsigned long long half = 1ULL << ( node.level - 1 );
+			emit_macrocell( nodes, node.child[0], i, j, placer );
+			emit_macrocell( nodes, node.child[1], i, j + half, placer );
+			emit_macrocell( nodes, node.child[2], i + half, j, placer );
+			emit_macrocell( nodes, node.child[3], i + half, j + half, placer );
+		}
+	}
+
+	void load_macrocell( const char* path, Placer& placer )
+	{
+		CharReader in( path );
+		std::string s;
+		// Node zero is the empty node.
+		std::vector<MCNode> nodes( 1 );
+
+		if ( !in.getline( s ) || s.compare( 0, 2, "[M" ) != 0 )
+			parse_error( path, 1, "missing [M2] header." );
+
+		while ( in.getline( s ) )
+		{
+			if ( s.empty() ) continue;
+			if ( s[0] == '#' )
+			{
+				if ( s.compare( 0, 2, "#R" ) == 0 ) check_rule( s.substr( 2 ) );
+				continue;
+			}
+
+			MCNode node;
+			memset( &node, 0, sizeof( node ) );
+			if ( s[0] == '.' || s[0] == '*' || s[0] == '$' )
+			{
+				// 8x8 leaf: rows terminated by '$', trailing dead cells and rows omitted.
+				node.level = MC_LEAF_LEVEL;
+				int r = 0, c = 0;
+				for ( char ch : s )
+				{
+					if ( ch == '$' ) { r++; c = 0; }
+					else if ( r < 8 && c < 8 && ( ch == '.' || ch == '*' ) )
+					{
+						if ( ch == '*' ) node.bits[r] |= (unsigned char) ( 1 << c );
+						c++;
+					}
+					else
+						parse_error( path, in.line_number() - 1, "malformed leaf node." );
+				}
+			}
+			else
+			{
+				unsigned long long c0, c1, c2, c3;
+				if ( sscanf( s.c_str(), "%d %llu %llu %llu %llu", &node.level, &c0, &c1, &c2, &c3 ) != 5 || node.level < 1 || node.level > 63 )
+					parse_error( path, in.line_number() - 1, "malformed node." );
+				node.child[0] = c0; node.child[1] = c1; node.child[2] = c2; node.child[3] = c3;
+				// Children of level one nodes are cell states, the others are previous nodes.
+				if ( node.level > 1 )
+					for ( int q = 0; q < 4; q++ )
+						if ( node.child[q] >= nodes.size() )
+							parse_error( path, in.line_number() - 1, "reference to an undefined node." );
+			}
+			nodes.push_back( node );
+		}
+
+		// The last node is the root of the quadtree.
+		emit_macrocell( nodes, nodes.size() - 1, 0, 0, placer );
+	}
+
+	/// Bounding box of the alive cells of a grid.
+	struct BoundingBox
+	{
+		bool empty;
+		size_t top, bottom, left, right;
+	};
+
+	BoundingBox bounding_box( PatternGrid& grid )
+	{
+		BoundingBox bb = { true, 0, 0, 0, 0 };
+		size_t cols = grid.width();
+		for ( size_t i = 0; i < grid.height(); i++ )
+		{
+			const bool* row = grid.row( i );
+			const bool* first = std::find( row, row + cols, true );
+			if ( first == row + cols ) continue;
+			size_t last = cols - 1;
+			while ( !row[last] ) last--;
+			if ( bb.empty )
+			{
+				bb.empty = false;
+				bb.top = i;
+				bb.left = first - row;
+				bb.right = last;
+			}
+			bb.bottom = i;
+			bb.left = std::min( bb.left, (size_t) ( first - row ) );
+			bb.right = std::max( bb.right, last );
+		}
+		return bb;
+	}
+
+	FILE* open_output( const char* path )
+	{
+		FILE* f = fopen( path, "w" );
+		if ( f == NULL )
+		{
+			std::cerr << "Error: it is not possible to create the pattern file " << path << "." << std::endl;
+			exit( 1 );
+		}
+		return f;
+	}
+
+	/// Write RLE items, wrapping the lines at RLE_LINE_LENGTH characters.
+	class RLEWriter
+	{
+	public:
+		RLEWriter( FILE* f ) : f(f), line_length(0) { }
+
+		void item( unsigned long long count, char tag )
+		{
+			char buffer[32];
+			int n = ( count > 1 ) ? sprintf( buffer, "%llu%c", count, tag ) : sprintf( buffer, "%c", tag );
+			if ( this->line_length + n > RLE_LINE_LENGTH )
+			{
+				fputc( '\n', this->f );
+				this->line_length = 0;
+			}
+			fputs( buffer, this->f );
+			this->line_length += n;
+		}
+
+	private:
+		FILE* f;
+		int line_length;
+	};
+
+	void save_rle( const char* path, PatternGrid& grid )
+	{
+		BoundingBox bb = bounding_box( grid );
+		FILE* f = open_output( path );
+		fprintf( f, "#C Generated by GameOfLife (https://github.com/Draxent/GameOfLife).\n" );
+		if ( bb.empty )
+		{
+			fprintf( f, "x = 0, y = 0, rule = B3/S23\n!\n" );
+			fclose( f );
+			return;
+		}
+		fprintf( f, "#CXRLE Pos=%zu,%zu\n", bb.left, bb.top );
+		fprintf( f, "x = %zu, y = %zu, rule = B3/S23\n", bb.right - bb.left + 1, bb.bottom - bb.top + 1 );
+
+		RLEWriter out( f );
+		size_t last_row = bb.top;
+		for ( size_t i = bb.top; i <= bb.bottom; i++ )
+		{
+			const bool* row = grid.row( i );
+			size_t j = bb.left, end = bb.right + 1;
+			// Skip the trailing dead cells of the row.
+			while ( end > j && !row[end - 1] ) end--;
+			if ( end == j ) continue;
+
+			// End of the previous line ( and of the empty lines in between ).
+			if ( i > last_row ) out.item( i - last_row, '$' );
+			last_row = i;
+
+			while ( j < end )
+			{
+				size_t first = j;
+				bool value = row[j];
+				while ( j < end && row[j] == value ) j++;
+				out.item( j - first, value ? 'o' : 'b' );
+			}
+		}
+		out.item( 1, '!' );
+		fputc( '\n', f );
+		fclose( f );
+	}
+
+	void save_cells( const char* path, PatternGrid& grid )
+	{
+		BoundingBox bb = bounding_box( grid );
+		FILE* f = open_output( path );
+		const char* name = strrchr( path, '/' );
+		fprintf( f, "!Name: %s\n!Generated by GameOfLife (https://github.com/Draxent/GameOfLife).\n", ( name == NULL ) ? path : name + 1 );
+		for ( size_t i = bb.top; !bb.empty && i <= bb.bottom; i++ )
+		{
+			const bool* row = grid.row( i );
+			size_t end = bb.right + 1;
+			while ( end > bb.left && !row[end - 1] ) end--;
+			if ( end == bb.left ) fputc( '.', f );
+			for ( size_t j = bb.left; j < end; j++ )
+				fputc( row[j] ? 'O' : '.', f );
+			fputc( '\n', f );
+		}
+		fclose( f );
+	}
+
+	/// Build a Macrocell quadtree with hash-consing, writing each node as soon as it is created.
+	class MacrocellWriter
+	{
+	public:
+		MacrocellWriter( FILE* f, PatternGrid& grid ) : f(f), grid(grid), num_nodes(0) { }
+
+		// Return the index of the node that represents the square of side 2^level at (i, j).
+		size_t build( int level, size_t i, size_t j )
+		{
+			if ( i >= this->grid.height() || j >= this->grid.width() ) return 0;
+			if ( level == MC_LEAF_LEVEL ) return this->leaf( i, j );
+
+			size_t half = (size_t) 1 << ( level - 1 );
+			size_t c[4] = { this->build( level - 1, i, j ), this->build( level - 1, i, j + half ),
+							this->build( level - 1, i + half, j ), this->build( level - 1, i + half, j + half ) };
+			if ( c[0] == 0 && c[1] == 0 && c[2] == 0 && c[3] == 0 ) return 0;
+
+			char key[64];
+			sprintf( key, "%d %zu %zu %zu %zu", level, c[0], c[1], c[2], c[3] );
+			auto it = this->internals.find( key );
+			if ( it != this->internals.end() ) return it->second;
+			fprintf( this->f, "%s\n", key );
+			return this->internals[key] = ++this->num_nodes;
+		}
+
+	private:
+		size_t leaf( size_t i, size_t j )
+		{
+			unsigned long long key = 0;
+			size_t cols = std::min( (size_t) 8, this->grid.width() - j );
+			for ( size_t r = 0; r < 8 && i + r < this->grid.height(); r++ )
+			{
+				const bool* row = this->grid.row( i + r ) + j;
+				for ( size_t c = 0; c < cols; c++ )
+					if ( row[c] ) key |= 1ULL << ( 8 * r + c );
+			}
+			if ( key == 0 ) return 0;
+
+			auto it = this->leaves.find( key );
+			if ( it != this->leaves.end() ) return it->second;
+
+			// Rows terminated by '$', trailing dead cells and trailing empty rows omitted.
+			std::string s;
+			int last_row = 7;
+			while ( ( ( key >> ( 8 * last_row ) ) & 0xFF ) == 0 ) last_row--;
+			for ( int r = 0; r <= last_row; r++ )
+			{
+				unsigned int bits = ( key >> ( 8 * r ) ) & 0xFF;
+				for ( int c = 0; bits >> c; c++ )
+					s.push_back( ( bits & ( 1u << c ) ) ? '*' : '.' );
+				s.push_back( '$' );
+			}
+			fprintf( this->f, "%s\n", s.c_str() );
+			return this->leaves[key] = ++this->num_nodes;
+		}
+
+		FILE* f;
+		PatternGrid& grid;
+		size_t num_nodes;
+		std::unordered_map<unsigned long long, size_t> leaves;
+		std::unordered_map<std::string, size_t> internals;
+	};
+
+	void save_macrocell( const char* path, PatternGrid& grid )
+	{
+		FILE* f = open_output( path );
+		fprintf( f, "[M2] (GameOfLife)\n#R B3/S23\n" );
+
+		// The root is the smallest square of side 2^level that contains the whole grid.
+		int level = MC_LEAF_LEVEL;
+		while ( ( (size_t) 1 << level ) < std::max( grid.height(), grid.width() ) ) level++;
+		MacrocellWriter writer( f, grid );
+		if ( writer.build( level, 0, 0 ) == 0 )
+			fprintf( f, "$\n" );
+		fclose( f );
+	}
+}
+
+GridPattern::GridPattern( Grid* g ) : g(g) { }
+
+size_t GridPattern::height() const
+{
+	return this->g->height() - 2;
+}
+
+size_t GridPattern::width() const
+{
+	return this->g->width() - 2;
+}
+
+void GridPattern::set_alive( size_t i, size_t j, size_t count )
+{
+	bool* first = this->g->Read + (i + 1) * this->g->width() + j + 1;
+	std::fill( first, first + count, true );
+}
+
+const bool* GridPattern::row( size_t i )
+{
+	return this->g->Read + (i + 1) * this->g->width() + 1;
+}
+
+PatternFormat pattern_format( const char* path )
+{
+	if ( has_extension( path, ".rle" ) ) return RLE_FORMAT;
+	if ( has_extension( path, ".cells" ) ) return CELLS_FORMAT;
+	if ( has_extension( path, ".mc" ) ) return MACROCELL_FORMAT;
+
+	// Unknown extension: look at the first meaningful line.
+	FILE* f = fopen( path, "rb" );
+	if ( f == NULL ) return RLE_FORMAT;
+	int c = fgetc( f );
+	while ( c == '#' || c == '\n' || c == '\r' )
+	{
+		while ( c != EOF && c != '\n' ) c = fgetc( f );
+		c = fgetc( f );
+	}
+	fclose( f );
+	if ( c == '[' ) return MACROCELL_FORMAT;
+	if ( c == '!' || c == '.' || c == 'O' || c == '*' ) return CELLS_FORMAT;
+	return RLE_FORMAT;
+}
+
+void load_pattern( const char* path, PatternGrid& grid, size_t row_offset, size_t col_offset )
+{
+	Placer placer( grid, row_offset, col_offset );
+	switch ( pattern_format( path ) )
+	{
+		case RLE_FORMAT: load_rle( path, placer ); break;
+		case CELLS_FORMAT: load_cells( path, placer ); break;
+		case MACROCELL_FORMAT: load_macrocell( path, placer ); break;
+	}
+}
+
+void save_pattern( const char* path, PatternGrid& grid )
+{
+	if ( has_extension( path, ".cells" ) ) save_cells( path, grid );
+	else if ( has_extension( path, ".mc" ) ) save_macrocell( path, grid );
+	else save_rle( path, grid );
+}
@@ -0,0 +1,226 @@
+/**
+ *	@file perf_counters.cpp
+ *  @brief Implementation of \see PerfCounters and \see PerfReport classes.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "../include/perf_counters.h"
+#include "../include/metrics.h"
+#include "../include/roofline.h"
+
+static const unsigned long long event_config[PERF_EVENTS] = {
+	PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static const char* const phase_names[PERF_PHASES] = { "kernel", "spin", "barrier", "serial" };
+
+PerfValues::PerfValues()
+{
+	for ( int e = 0; e < PERF_EVENTS; e++ )
+		this->count[e] = 0;
+	this->time = 0;
+}
+
+PerfValues& PerfValues::operator+=( const PerfValues& v )
+{
+	for ( int e = 0; e < PERF_EVENTS; e++ )
+		this->count[e] += v.count[e];
+	this->time += v.time;
+	return *this;
+}
+
+PerfCounters::PerfCounters()
+{
+	this->members = 0;
+	this->err = 0;
+	for ( int e = 0; e < PERF_EVENTS; e++ )
+	{
+		this->fd[e] = -1;
+		this->slot[e] = -1;
+
+		// The group cannot exist without its leader, i.e. the cycles.
+		if ( e > 0 && this->fd[0] == -1 ) continue;
+
+		struct perf_event_attr attr;
+		memset( &attr, 0, sizeof( attr ) );
+		attr.size = sizeof( attr );
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = event_config[e];
+		// Count only the user code of the calling thread, which is allowed also with perf_event_paranoid = 2.
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		this->fd[e] = (int) syscall( __NR_perf_event_open, &attr, 0, -1, this->fd[0], 0 );
+		if ( this->fd[e] != -1 )
+			this->slot[e] = this->members++;
+		else if ( e == 0 )
+			this->err = errno;
+	}
+	this->read( this->last );
+}
+
+bool PerfCounters::available() const
+{
+	return ( this->fd[0] != -1 );
+}
+
+int PerfCounters::error() const
+{
+	return this->err;
+}
+
+void PerfCounters::start()
+{
+	if ( this->available() )
+		this->read( this->last );
+}
+
+void PerfCounters::stop( PerfPhase phase )
+{
+	if ( !this->available() ) return;
+
+	PerfValues now;
+	this->read( now );
+	PerfValues& t = this->totals[phase];
+	for ( int e = 0; e < PERF_EVENTS; e++ )
+		t.count[e] += now.count[e] - this->last.count[e];
+	t.time += now.time - this->last.time;
+	this->last = now;
+}
+
+const PerfValues& PerfCounters::total( PerfPhase phase ) const
+{
+	return this->totals[phase];
+}
+
+void PerfCounters::read( PerfValues& v ) const
+{
+	v.time = (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch() ).count();
+	if ( !this->available() ) return;
+
+	// Layout of a group read: number of events, time enabled, time running, values.
+	unsigned long long buffer[3 + PERF_EVENTS];
+	if ( ::read( this->fd[0], buffer, sizeof( buffer ) ) < (ssize_t) ( ( 3 + this->members ) * sizeof( unsigned long long ) ) )
+		return;
+
+	// If there are more events than hardware counters, the kernel multiplexes them: scale the values.
+	long double scale = ( buffer[2] > 0 && buffer[2] < buffer[1] ) ? (long double) buffer[1] / buffer[2] : 1.0L;
+	for ( int e = 0; e < PERF_EVENTS; e++ )
+		v.count[e] = ( this->slot[e] != -1 ) ? (unsigned long long) ( buffer[3 + this->slot[e]] * scale ) : 0;
+}
+
+PerfCounters::~PerfCounters()
+{
+	for ( int e = 0; e < PERF_EVENTS; e++ )
+		if ( this->fd[e] != -1 )
+			close( this->fd[e] );
+}
+
+PerfReport::PerfReport()
+{
+	for ( int p = 0; p < PERF_PHASES; p++ )
+		this->threads[p] = 0;
+	this->missing = 0;
+	this->err = 0;
+}
+
+void PerfReport::add( const PerfCounters& c )
+{
+	std::lock_guard<std::mutex> lock( this->mutex );
+	if ( !c.available() )
+	{
+		this->missing++;
+		this->err = c.error();
+		return;
+	}
+	for ( int p = 0; p < PERF_PHASES; p++ )
+	{
+		const PerfValues& v = c.total( (PerfPhase) p );
+		if ( v.time == 0 ) continue;
+		this->totals[p] += v;
+		this->threads[p]++;
+	}
+}
+
+void PerfReport::report( unsigned long long cells ) const
+{
+	if ( this->missing > 0 )
+	{
+		std::cout << "Warning: hardware counters not available on " << this->missing << " threads ( perf_event_open: "
+				  << strerror( this->err ) << " )";
+		if ( this->err == EACCES || this->err == EPERM )
+			std::cout << ", check /proc/sys/kernel/perf_event_paranoid";
+		std::cout << "." << std::endl;
+	}
+
+	unsigned int measured = 0;
+	for ( int p = 0; p < PERF_PHASES; p++ )
+		measured += this->threads[p];
+	if ( measured == 0 ) return;
+
+	std::ostringstream json;
+	json << std::fixed << std::setprecision( 3 ) << "{";
+	bool first = true;
+	std::ios_base::fmtflags flags = std::cout.flags();
+	std::streamsize precision = std::cout.precision();
+	std::cout << "Hardware counters ( summed on all threads ):" << std::endl;
+	std::cout << std::fixed << std::setprecision( 3 );
+	for ( int p = 0; p < PERF_PHASES; p++ )
+	{
+		if ( this->threads[p] == 0 ) continue;
+		const PerfValues& v = this->totals[p];
+		unsigned long long cycles = v.count[0], instructions = v.count[1], llc_misses = v.count[2], branch_misses = v.count[3];
+		double ipc = ( cycles > 0 ) ? (double) instructions / cycles : 0;
+		double bytes = (double) llc_misses * CACHE_LINE_BYTES;
+		double bytes_per_cell = ( cells > 0 ) ? bytes / cells : 0;
+		// The threads of a phase run at the same time, so the bandwidth is computed on their mean time.
+		double bandwidth = ( v.time > 0 ) ? bytes * this->threads[p] / v.time : 0;
+
+		std::cout << "\t" << phase_names[p] << " ( " << this->threads[p] << " threads ): cycles " << cycles
+				  << ", instructions " << instructions << ", IPC " << ipc << ", LLC misses " << llc_misses
+				  << ", branch misses " << branch_misses << ", bytes/cell " << bytes_per_cell
+				  << ", bandwidth " << bandwidth << " GB/s" << std::endl;
+
+		json << ( first ? " " : ", " ) << "\"" << phase_names[p] << "\": { \"threads\": " << this->threads[p]
+			 << ", \"time_us\": " << v.time / 1000 << ", \"cycles\": " << cycles << ", \"instructions\": " << instructions
+			 << ", \"llc_misses\": " << llc_misses << ", \"branch_misses\": " << branch_misses << ", \"ipc\": " << ipc
+			 << ", \"bytes_per_cell\": " << bytes_per_cell << ", \"bandwidth_gb_s\": " << bandwidth << " }";
+		first = false;
+
+		// The traffic of the kernel replaces the model of the roofline, when the LLC misses are counted.
+		if ( p == PERF_KERNEL && llc_misses > 0 && run_roofline != NULL )
+			run_roofline->set_measured_traffic( bytes_per_cell );
+	}
+	json << " }";
+	std::cout.flags( flags );
+	std::cout.precision( precision );
+
+	if ( run_metrics != NULL )
+		run_metrics->set_section( "perf", json.str() );
+}
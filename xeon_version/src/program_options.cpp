@@ -20,6 +20,8 @@
  */
 
 
+#include <cstdio>
+
 #include "../include/program_options.h"
 
 ProgramOptions::ProgramOptions( int argc, char** argv )
@@ -71,4 +73,32 @@ long ProgramOptions::get_number( const std::string& option1, const std::string&
 {
 	char* s = this->get( option1, option2 );
 	return ( ( s != NULL ) ? ((size_t) std::atol(s)) : default_value );
-}
\ No newline at end of file
+}
+
+std::vector<std::string> ProgramOptions::get_list( const std::string& option, const char* default_value ) const
+{
+	std::vector<std::string> values;
+	char* s = this->get( option );
+	std::string list = ( s != NULL ) ? s : default_value;
+	size_t begin = 0;
+	while ( begin <= list.size() )
+	{
+		size_t comma = list.find( ',', begin );
+		if ( comma == std::string::npos ) comma = list.size();
+		std::string value = list.substr( begin, comma - begin );
+		begin = comma + 1;
+		if ( value.empty() ) continue;
+
+		// Expand the ranges, as the seq command does.
+		long first, step, last;
+		char end;
+		if ( sscanf( value.c_str(), "%ld:%ld:%ld%c", &first, &step, &last, &end ) == 3 && step > 0 )
+		{
+			for ( long v = first; v <= last; v += step )
+				values.push_back( std::to_string( (long long) v ) );
+		}
+		else
+			values.push_back( value );
+	}
+	return values;
+}
@@ -0,0 +1,208 @@
+/**
+ *	@file roofline.cpp
+ *  @brief Implementation of \see Roofline class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+
+#include "../include/roofline.h"
+#include "../include/shared_functions.h"
+
+Roofline* run_roofline = NULL;
+
+// Keeps the result of the integer microkernel alive, so that the compiler cannot remove it.
+static std::atomic<unsigned long long> sink( 0 );
+
+/**
+ * Run <em>body</em> on <em>nt</em> threads, which are created in advance and start together.
+ * @param nt		number of threads.
+ * @param body		function executed by each thread, receiving the thread index.
+ * @return	the time between the start signal and the end of the last thread, in seconds.
+ */
+static double run_parallel( unsigned int nt, const std::function<void( unsigned int )>& body )
+{
+	std::atomic<bool> go( false );
+	std::vector<std::thread> threads;
+	for ( unsigned int t = 0; t < nt; t++ )
+	{
+		threads.push_back( std::thread( [&go, &body, t]()
+		{
+			while ( !go.load() ) std::this_thread::yield();
+			body( t );
+		} ) );
+	}
+
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+	go.store( true );
+	for ( unsigned int t = 0; t < nt; t++ )
+		threads[t].join();
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>( t2 - t1 ).count() / 1e9;
+}
+
+KernelModel kernel_model( bool vectorization, bool statistics, bool deltas, bool out_of_core )
+{
+	// Every kernel reads Read and writes Write, whose lines are loaded before being written.
+	KernelModel m;
+	m.kernel = vectorization ? "vect" : "scalar";
+	m.read = 1;
+	m.write = 1;
+	m.allocate = 1;
+	m.ops = GOL_OPS_PER_CELL;
+	// The statistics compare the new and the old cell of the same block, still in cache: two comparisons and two additions.
+	if ( statistics )
+	{
+		m.kernel += "+stats";
+		m.ops += 4;
+	}
+	// The scalar kernel records the changes while computing; the others re-read Read and Write in a second pass.
+	if ( deltas )
+	{
+		m.kernel += "+deltas";
+		if ( vectorization || statistics ) m.read += 2;
+		m.ops += 3;
+	}
+	// Each band is read from the page cache into a window, and written back from the window to the page cache.
+	if ( out_of_core )
+	{
+		m.kernel += "+out-of-core";
+		m.read += 2;
+		m.write += 2;
+		m.allocate += 2;
+	}
+	return m;
+}
+
+Roofline::Roofline( unsigned int nt, const KernelModel& model )
+{
+	this->nt = nt;
+	this->model = model;
+	this->measured_bytes = -1;
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	// Memory bandwidth: STREAM triad, each thread works on its own slice, first touched by itself.
+	double *a = new double[ROOFLINE_ELEMENTS], *b = new double[ROOFLINE_ELEMENTS], *c = new double[ROOFLINE_ELEMENTS];
+	run_parallel( nt, [a, b, c, nt]( unsigned int t )
+	{
+		size_t begin = (size_t) ROOFLINE_ELEMENTS * t / nt, end = (size_t) ROOFLINE_ELEMENTS * ( t + 1 ) / nt;
+		for ( size_t i = begin; i < end; i++ )
+		{
+			a[i] = 0;
+			b[i] = 1;
+			c[i] = 2;
+		}
+	} );
+	double best = 0;
+	for ( int r = 0; r < ROOFLINE_REPS; r++ )
+	{
+		double time = run_parallel( nt, [a, b, c, nt]( unsigned int t )
+		{
+			size_t begin = (size_t) ROOFLINE_ELEMENTS * t / nt, end = (size_t) ROOFLINE_ELEMENTS * ( t + 1 ) / nt;
+			for ( size_t i = begin; i < end; i++ )
+				a[i] = b[i] + 3.0 * c[i];
+		} );
+		best = ( r == 0 ) ? time : std::min( best, time );
+	}
+	// As in STREAM, the write-allocate traffic is not counted.
+	this->bandwidth = 3.0 * sizeof( double ) * ROOFLINE_ELEMENTS / best;
+	delete[] a;
+	delete[] b;
+	delete[] c;
+
+	// Integer throughput: eight independent chains of shift, xor and add.
+	for ( int r = 0; r < ROOFLINE_REPS; r++ )
+	{
+		double time = run_parallel( nt, []( unsigned int t )
+		{
+			unsigned long long x[8];
+			for ( int k = 0; k < 8; k++ )
+				x[k] = t + k + 1;
+			for ( unsigned int i = 0; i < ROOFLINE_INT_ITERATIONS; i++ )
+				for ( int k = 0; k < 8; k++ )
+					x[k] += ( x[k] >> 1 ) ^ k;
+			unsigned long long sum = 0;
+			for ( int k = 0; k < 8; k++ )
+				sum += x[k];
+			sink += sum;
+		} );
+		best = ( r == 0 ) ? time : std::min( best, time );
+	}
+	this->int_ops = 3.0 * 8 * ROOFLINE_INT_ITERATIONS * nt / best;
+
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	std::ios_base::fmtflags flags = std::cout.flags();
+	std::streamsize precision = std::cout.precision();
+	std::cout << std::fixed << std::setprecision( 2 );
+	std::cout << "Roofline with " << nt << " threads: memory bandwidth " << this->bandwidth / 1e9 << " GB/s ( triad ), integer peak "
+			  << this->int_ops / 1e9 << " Gop/s, ridge point " << this->int_ops / this->bandwidth << " op/byte." << std::endl;
+	std::cout.flags( flags );
+	std::cout.precision( precision );
+	printTime( t1, t2, "roofline measure" );
+}
+
+void Roofline::set_measured_traffic( double bytes_per_cell )
+{
+	this->measured_bytes = bytes_per_cell;
+}
+
+void Roofline::report( Metrics& metrics ) const
+{
+	bool measured = ( this->measured_bytes > 0 );
+	double bytes_per_cell = measured ? this->measured_bytes : this->model.bytes();
+	double cells_per_second = metrics.cells_per_second();
+	double intensity = this->model.ops / bytes_per_cell;
+	double achieved_bandwidth = cells_per_second * bytes_per_cell;
+	double achieved_ops = cells_per_second * this->model.ops;
+	double bandwidth_percent = 100.0 * achieved_bandwidth / this->bandwidth;
+	double compute_percent = 100.0 * achieved_ops / this->int_ops;
+	// The attainable throughput is limited by the lower of the two roofs at the intensity of the kernel.
+	bool memory_bound = ( intensity * this->bandwidth < this->int_ops );
+	const char* source = measured ? "measured" : "model";
+
+	std::ios_base::fmtflags flags = std::cout.flags();
+	std::streamsize precision = std::cout.precision();
+	std::cout << std::fixed << std::setprecision( 2 );
+	std::cout << "Roofline of the run ( " << this->model.kernel << " kernel ): " << (unsigned long long) cells_per_second << " cells/s, "
+			  << bytes_per_cell << " bytes/cell ( " << source << " ), " << this->model.ops << " op/cell ( model ), "
+			  << intensity << " op/byte ;" << std::endl;
+	std::cout << "\t model traffic " << this->model.read << " read + " << this->model.write << " written + " << this->model.allocate
+			  << " write-allocate bytes/cell" << ( measured ? ", replaced by the LLC misses of the kernel phase" : "" ) << " ;" << std::endl;
+	std::cout << "\t achieved " << achieved_bandwidth / 1e9 << " GB/s = " << bandwidth_percent << "% of the bandwidth roof, "
+			  << achieved_ops / 1e9 << " Gop/s = " << compute_percent << "% of the compute roof ;" << std::endl;
+	std::cout << "\t at this intensity the kernel is " << ( memory_bound ? "memory" : "compute" ) << " bound." << std::endl;
+	std::cout.flags( flags );
+	std::cout.precision( precision );
+
+	std::ostringstream json;
+	json << std::fixed << std::setprecision( 3 );
+	json << "{ \"threads\": " << this->nt << ", \"kernel\": \"" << this->model.kernel << "\", \"bandwidth_gb_s\": " << this->bandwidth / 1e9
+		 << ", \"int_gops\": " << this->int_ops / 1e9 << ", \"bytes_per_cell\": " << bytes_per_cell << ", \"bytes_source\": \"" << source
+		 << "\", \"model_bytes\": { \"read\": " << this->model.read << ", \"write\": " << this->model.write
+		 << ", \"write_allocate\": " << this->model.allocate << " }, \"ops_per_cell\": " << this->model.ops << ", \"ops_source\": \"model\""
+		 << ", \"achieved_gb_s\": " << achieved_bandwidth / 1e9 << ", \"bandwidth_roof_percent\": " << bandwidth_percent
+		 << ", \"compute_roof_percent\": " << compute_percent << ", \"bound\": \"" << ( memory_bound ? "memory" : "compute" ) << "\" }";
+	metrics.set_section( "roofline", json.str() );
+}
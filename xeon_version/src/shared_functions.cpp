@@ -20,6 +20,16 @@
  */
 
 #include "../include/shared_functions.h"
+#include "../include/stream_grid.h"
+#include "../include/perf_counters.h"
+#include "../include/probes.h"
+
+#include <algorithm>
+
+// Number of cells computed by the inner loop of the statistics kernel.
+#define STATS_BLOCK 64
+
+bool take_all_time = false;
 
 void compute_generation( Grid* g, size_t start, size_t end )
 {
@@ -56,7 +66,154 @@ void compute_generation_vect( Grid* g, int* numNeighbours, size_t start, size_t
 }
 #endif // VECTORIZATION
 
-bool sequential_version( Grid* g, unsigned int iterations, bool vectorization )
+void compute_generation( Grid* g, size_t start, size_t end, GenerationStats& stats )
+{
+	size_t pos_top = start - g->width(), pos_bottom = start + g->width();
+	// Counters kept in registers, added to the shared statistics only once per working area.
+	unsigned long long births = 0, deaths = 0, hash = 0;
+
+	// The working area is computed in blocks, so the inner loop has no branches and can be vectorized by the compiler.
+	for ( size_t block = start; block < end; block += STATS_BLOCK )
+	{
+		size_t block_end = std::min( block + STATS_BLOCK, end );
+		// A block is smaller than 256 cells, so byte counters are enough and keep the vectorized loop narrow.
+		unsigned char block_births = 0, block_deaths = 0;
+		for ( size_t pos = block; pos < block_end; pos++, pos_top++, pos_bottom++ )
+		{
+			// Calculate #Neighbours.
+			int numNeighbor = g->countNeighbours( pos, pos_top, pos_bottom );
+			// Box ← (( #Neighbours == 3 ) OR ( Cell is alive AND #Neighbours == 2 )).
+			bool alive = g->Read[pos];
+			bool next = ( numNeighbor == 3 || ( alive && numNeighbor == 2 ) );
+			g->Write[pos] = next;
+			block_births += ( next & !alive );
+			block_deaths += ( alive & !next );
+		}
+		births += block_births;
+		deaths += block_deaths;
+
+		// The hash is updated incrementally, flipping the keys of the changed cells only.
+		if ( block_births + block_deaths > 0 )
+			for ( size_t pos = block; pos < block_end; pos++ )
+				if ( g->Write[pos] != g->Read[pos] )
+					hash ^= zobrist_key( pos + stats.key_offset );
+	}
+
+	stats.births += births;
+	stats.deaths += deaths;
+	stats.hash ^= hash;
+}
+
+#if VECTORIZATION
+void compute_generation_vect( Grid* g, int* numNeighbours, size_t start, size_t end, GenerationStats& stats )
+{
+	// Sum of the differences ( +1 birth, -1 death ) and of their squares ( +1 for each change ),
+	// from which births and deaths are obtained without any branch.
+	long long growth = 0, changes = 0;
+	unsigned long long hash = 0;
+	size_t index = start, index_top = start - g->width(), index_bottom = start + g->width();
+	for ( ; index + VLEN < end; index += VLEN, index_top += VLEN, index_bottom += VLEN )
+	{
+		// Save the computation of the neighbours counting into the numNeighbours array.
+		numNeighbours[0:VLEN] = g->countNeighbours( index, index_top, index_bottom, __sec_implicit_index(0) );
+		// Box ← (( #Neighbours == 3 ) OR ( Cell is alive AND #Neighbours == 2 )) in vector notations.
+		g->Write[index:VLEN] = ( numNeighbours[0:VLEN] == 3 || ( g->Read[index:VLEN] && numNeighbours[0:VLEN] == 2 ) );
+		// Reuse the numNeighbours array to store the differences between the new and the old values.
+		numNeighbours[0:VLEN] = g->Write[index:VLEN] - g->Read[index:VLEN];
+		growth += __sec_reduce_add( numNeighbours[0:VLEN] );
+		long long block_changes = __sec_reduce_add( numNeighbours[0:VLEN] * numNeighbours[0:VLEN] );
+		changes += block_changes;
+		// Flip the keys of the changed cells, which are rare once the grid has settled down.
+		if ( block_changes > 0 )
+			for ( int j = 0; j < VLEN; j++ )
+				if ( numNeighbours[j] != 0 )
+					hash ^= zobrist_key( index + j + stats.key_offset );
+	}
+	// Compute normally the last piece that does not fill the numNeighbours array.
+	for ( ; index < end; index++, index_top++, index_bottom++ )
+	{
+		// Calculate #Neighbours.
+		int numNeighbor = g->countNeighbours( index, index_top, index_bottom );
+		// Box ← (( #Neighbours == 3 ) OR ( Cell is alive AND #Neighbours == 2 )).
+		g->Write[index] = ( numNeighbor == 3 || ( g->Read[index] && numNeighbor == 2 ) );
+		int diff = g->Write[index] - g->Read[index];
+		growth += diff;
+		changes += diff * diff;
+		if ( diff != 0 )
+			hash ^= zobrist_key( index + stats.key_offset );
+	}
+
+	stats.births += ( changes + growth ) / 2;
+	stats.deaths += ( changes - growth ) / 2;
+	stats.hash ^= hash;
+}
+#endif // VECTORIZATION
+
+void compute_generation( Grid* g, size_t start, size_t end, DeltaBuffer& changes )
+{
+	size_t pos_top = start - g->width(), pos_bottom = start + g->width();
+
+	for ( size_t block = start; block < end; )
+	{
+		// The block ends with the word, so its changes are collected in a single mask.
+		size_t word = block / DELTA_WORD_BITS, block_end = std::min( ( word + 1 ) * DELTA_WORD_BITS, end );
+		unsigned long long mask = 0;
+		for ( size_t pos = block; pos < block_end; pos++, pos_top++, pos_bottom++ )
+		{
+			// Calculate #Neighbours.
+			int numNeighbor = g->countNeighbours( pos, pos_top, pos_bottom );
+			// Box ← (( #Neighbours == 3 ) OR ( Cell is alive AND #Neighbours == 2 )).
+			bool next = ( numNeighbor == 3 || ( g->Read[pos] && numNeighbor == 2 ) );
+			g->Write[pos] = next;
+			mask |= (unsigned long long) ( next != g->Read[pos] ) << ( pos % DELTA_WORD_BITS );
+		}
+		if ( mask != 0 )
+			changes.push_back( DeltaWord( word, mask ) );
+		block = block_end;
+	}
+}
+
+void record_changes( Grid* g, size_t start, size_t end, DeltaBuffer& changes )
+{
+	for ( size_t block = start; block < end; )
+	{
+		size_t word = block / DELTA_WORD_BITS, block_end = std::min( ( word + 1 ) * DELTA_WORD_BITS, end );
+		unsigned long long mask = 0;
+		for ( size_t pos = block; pos < block_end; pos++ )
+			mask |= (unsigned long long) ( g->Write[pos] != g->Read[pos] ) << ( pos % DELTA_WORD_BITS );
+		if ( mask != 0 )
+			changes.push_back( DeltaWord( word, mask ) );
+		block = block_end;
+	}
+}
+
+void compute_chunk( Grid* g, int* numNeighbours, bool vectorization, size_t start, size_t end, GenerationStats* stats, DeltaBuffer* changes )
+{
+#if !VECTORIZATION
+	// Only the vectorized kernel uses the array of the neighbours.
+	(void) numNeighbours;
+#endif // VECTORIZATION
+	// Only the scalar kernel records the changes while computing; the others are followed by a pass over the working area.
+	if ( changes != NULL && stats == NULL && !vectorization )
+	{
+		compute_generation( g, start, end, *changes );
+		return;
+	}
+#if VECTORIZATION
+	if ( vectorization )
+	{
+		if ( stats != NULL ) compute_generation_vect( g, numNeighbours, start, end, *stats );
+		else compute_generation_vect( g, numNeighbours, start, end );
+	}
+	else
+#endif // VECTORIZATION
+	if ( stats != NULL ) compute_generation( g, start, end, *stats );
+	else compute_generation( g, start, end );
+	if ( changes != NULL )
+		record_changes( g, start, end, *changes );
+}
+
+bool sequential_version( Grid* g, unsigned int iterations, bool vectorization, const Settings& settings )
 {
 	std::chrono::high_resolution_clock::time_point t1, t2;
 
@@ -68,37 +225,74 @@ bool sequential_version( Grid* g, unsigned int iterations, bool vectorization )
 	// Start - Game of Life
 	t1 = std::chrono::high_resolution_clock::now();
 
-	long copyborder_time = 0;
+	unsigned long long copyborder_time = 0;
 	size_t start = g->width() + 1, end = g->size() - g->width() - 1;
 	int* numNeighbours = NULL;
 	if ( vectorization )
 		numNeighbours = new int[VLEN];
 
+	GridPattern gp( g );
+	StatsRecorder* recorder = create_recorder( gp, iterations, settings );
+	GenerationStats stats;
+
+	// Hardware counters of the kernel and of the serial phase.
+	PerfCounters* counters = settings.perf ? new PerfCounters() : NULL;
+
+	// Readers of the generations, as the checkpoints and the shared memory.
+	SnapshotPublisher* publisher = create_publisher( g, settings );
+	Checkpointer* checkpointer = create_checkpointer( publisher, settings );
+	FrameRing* ring = create_frame_ring( publisher, settings );
+	// Changes of each generation, handed over to the writer of the delta file.
+	DeltaWriter* writer = create_delta_writer( g, settings );
+	DeltaBuffer changes;
+
+	std::chrono::high_resolution_clock::time_point tg;
 	for ( unsigned int k = 1; k <= iterations; k++ )
 	{
-#if VECTORIZATION
-		if ( vectorization )
-			compute_generation_vect( g, numNeighbours, start, end );
-		else
-			compute_generation( g, start, end );
-#else
-		compute_generation( g, start, end );
-#endif // VECTORIZATION
-		copyborder_time = copyborder_time + end_generation( g, k );
+		tg = std::chrono::high_resolution_clock::now();
+		PROBE_GENERATION_START( k );
+		if ( counters != NULL ) counters->start();
+		compute_chunk( g, numNeighbours, vectorization, start, end, ( recorder != NULL ) ? &stats : NULL, ( writer != NULL ) ? &changes : NULL );
+		if ( counters != NULL ) counters->stop( PERF_KERNEL );
+		bool stop = false;
+		if ( recorder != NULL )
+		{
+			exclude_border( g, start, end, stats );
+			stop = recorder->record( stats );
+			stats.reset();
+		}
+		if ( writer != NULL ) writer->record( k, changes );
+		copyborder_time = copyborder_time + end_generation( g, k, publisher );
+		if ( counters != NULL ) counters->stop( PERF_SERIAL );
+		PROBE_GENERATION_END( k );
+		record_generation( tg, std::chrono::high_resolution_clock::now() );
+		if ( stop ) break;
 	}
 
 	if ( vectorization )
 		delete[] numNeighbours;
+	delete checkpointer;
+	delete ring;
+	delete publisher;
+	delete writer;
 
-#if TAKE_ALL_TIME
 	// Print the total time in order to compute  the end_generation functions.
-	printTime( copyborder_time, "copy border" );
-#endif // TAKE_ALL_TIME
+	if ( take_all_time )
+		printTime( TscTimer::microseconds( copyborder_time ), "copy border" );
 
 	// End - Game of Life
 	t2 = std::chrono::high_resolution_clock::now();
 	printTime( t1, t2, "complete Game of Life" );
 
+	unsigned int generations = ( recorder != NULL ) ? recorder->generations() : iterations;
+	if ( counters != NULL )
+	{
+		PerfReport report;
+		report.add( *counters );
+		report.report( (unsigned long long) gp.width() * gp.height() * generations );
+		delete counters;
+	}
+
 #if DEBUG
 	// Print only small Grid
 	if ( g->width() <= MAX_PRINTABLE_GRID && g->height() <= MAX_PRINTABLE_GRID )
@@ -107,7 +301,7 @@ bool sequential_version( Grid* g, unsigned int iterations, bool vectorization )
 		g->print( "OUTPUT" );
 	}
 	// Check if the output is correct.
-	verifier->GOL( iterations );
+	verifier->GOL( generations );
 	if ( verifier->equal() ) std::cout << "TEST OK !!! " << std::endl;
 	else
 	{
@@ -117,16 +311,91 @@ bool sequential_version( Grid* g, unsigned int iterations, bool vectorization )
 	}
 #endif // DEBUG
 
+	finalization( gp, settings, recorder );
+	delete recorder;
 	return true;
 }
 
-long end_generation( Grid* g, unsigned int current_iteration )
+bool out_of_core_version( const Settings& settings, bool vectorization, size_t width, size_t height, unsigned int seed, unsigned int iterations )
 {
-#if TAKE_ALL_TIME
 	std::chrono::high_resolution_clock::time_point t1, t2;
-	// Start - End Generation
+
+	// Start - Initialization Phase
 	t1 = std::chrono::high_resolution_clock::now();
-#endif // TAKE_ALL_TIME
+	StreamGrid* sg = new StreamGrid( settings.store_path, height, width, settings.band_rows );
+	// The backing file is created empty, so the pattern can be directly placed on it.
+	if ( settings.pattern_path != NULL )
+		load_pattern( settings.pattern_path, *sg, settings.pattern_row, settings.pattern_col );
+	else
+		sg->init( seed );
+	// End - Initialization Phase
+	t2 = std::chrono::high_resolution_clock::now();
+	printTime( t1, t2, "initialization phase" );
+
+#if DEBUG
+	// Load the initial configuration into an in-memory Grid, used to initialize the verifier.
+	Grid* g = new Grid( height, width );
+	sg->store( g );
+	Matrix* verifier = new Matrix( g );
+#endif // DEBUG
+
+	// Start - Game of Life
+	t1 = std::chrono::high_resolution_clock::now();
+
+	StatsRecorder* recorder = create_recorder( *sg, iterations, settings );
+	GenerationStats stats;
+
+	unsigned long long wait_time = 0;
+	std::chrono::high_resolution_clock::time_point tg;
+	for ( unsigned int k = 1; k <= iterations; k++ )
+	{
+		tg = std::chrono::high_resolution_clock::now();
+		PROBE_GENERATION_START( k );
+		wait_time += sg->stream_generation( vectorization, ( recorder != NULL ) ? &stats : NULL );
+		PROBE_GENERATION_END( k );
+		record_generation( tg, std::chrono::high_resolution_clock::now() );
+		if ( recorder != NULL )
+		{
+			bool stop = recorder->record( stats );
+			stats.reset();
+			if ( stop ) break;
+		}
+	}
+
+	// Print the total time spent waiting for the read-ahead thread.
+	if ( take_all_time )
+		printTime( TscTimer::microseconds( wait_time ), "stream wait" );
+
+	// End - Game of Life
+	t2 = std::chrono::high_resolution_clock::now();
+	printTime( t1, t2, "complete Game of Life" );
+
+#if DEBUG
+	// Load the final configuration and check if the output is correct.
+	sg->store( g );
+	// Print only small Grid
+	if ( g->width() <= MAX_PRINTABLE_GRID && g->height() <= MAX_PRINTABLE_GRID )
+		g->print( "OUTPUT" );
+	verifier->GOL( ( recorder != NULL ) ? recorder->generations() : iterations );
+	if ( verifier->equal() ) std::cout << "TEST OK !!! " << std::endl;
+	else
+	{
+		std::cout << "Error: the verifier obtain this following different value for the GOL computation:" << std::endl;
+		verifier->print();
+		return false;
+	}
+#endif // DEBUG
+
+	finalization( *sg, settings, recorder );
+	delete recorder;
+	delete sg;
+	return true;
+}
+
+unsigned long long end_generation( Grid* g, unsigned int current_iteration, SnapshotPublisher* publisher )
+{
+	// Start - End Generation
+	unsigned long long t1 = take_all_time ? TscTimer::now() : 0;
 
 	// Swap the reading and writing matrixes.
 	g->swap();
@@ -134,6 +403,10 @@ long end_generation( Grid* g, unsigned int current_iteration )
 	// Every step we need to configure the border to properly respect the logic of the 2D toroidal grid
 	g->copyBorder();
 
+	// The generation is complete: the readers can access it while the next one is computed.
+	if ( publisher != NULL )
+		publisher->publish( current_iteration );
+
 #if DEBUG
 	// Print only small Grid
 	if ( g->width() <= MAX_PRINTABLE_GRID && g->height() <= MAX_PRINTABLE_GRID )
@@ -144,16 +417,11 @@ long end_generation( Grid* g, unsigned int current_iteration )
 	}
 #endif // DEBUG
 
-#if TAKE_ALL_TIME
 	// End - End Generation
-	t2 = std::chrono::high_resolution_clock::now();
-	return std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
-#else
-	return  0;
-#endif // TAKE_ALL_TIME
+	return take_all_time ? TscTimer::now() - t1 : 0;
 }
 
-bool menu( int argc, char** argv, bool& vectorization, unsigned int& num_tasks, size_t& width, size_t& height, unsigned int& seed, unsigned int& iterations, unsigned int& nw )
+bool menu( int argc, char** argv, bool& vectorization, unsigned int& num_tasks, size_t& width, size_t& height, unsigned int& seed, unsigned int& iterations, unsigned int& nw, Settings& settings )
 {
 	ProgramOptions po( argc, argv );
 
@@ -171,6 +439,24 @@ bool menu( int argc, char** argv, bool& vectorization, unsigned int& num_tasks,
 		std::cerr << "\t -i NUM, --iterations NUM \t number of iterations ;" << std::endl;
 		std::cerr << "\t -t NUM, --thread NUM \t number of threads ( zero for the sequential version ) ;" << std::endl;
 		std::cerr << "\t -n NUM, --num_tasks NUM \t  number of tasks generated ;" << std::endl;
+		std::cerr << "\t --out-of-core FILE \t keep the grid in FILE and stream it through memory band by band ;" << std::endl;
+		std::cerr << "\t --band NUM \t\t number of rows of each band streamed in out-of-core mode ;" << std::endl;
+		std::cerr << "\t --pattern FILE \t initialize the grid with a RLE, .cells or Macrocell pattern ;" << std::endl;
+		std::cerr << "\t --at-row NUM, --at-col NUM \t position of the top-left corner of the pattern ;" << std::endl;
+		std::cerr << "\t --export FILE \t\t export the final grid as pattern ( RLE, .cells or .mc depending on the extension ) ;" << std::endl;
+		std::cerr << "\t --stats FILE \t\t write population, births and deaths of each generation ( CSV, or JSON if FILE ends with .json ) ;" << std::endl;
+		std::cerr << "\t --stop-on-cycle \t end the computation when the grid repeats itself, reporting transient length and period ;" << std::endl;
+		std::cerr << "\t --metrics-json FILE \t write configuration, phase and generation times, cells/s and peak RSS as JSON ;" << std::endl;
+		std::cerr << "\t --latency \t\t print p50, p90, p99 and maximum latency of the generations ;" << std::endl;
+		std::cerr << "\t --imbalance \t\t account the work of each worker and print the load imbalance report ;" << std::endl;
+		std::cerr << "\t --perf \t\t count cycles, instructions, LLC and branch misses of each thread per phase ( perf_event_open ) ;" << std::endl;
+		std::cerr << "\t --trace FILE \t\t write the timeline of tasks, barriers and end_generation in Chrome trace format ;" << std::endl;
+		std::cerr << "\t --roofline \t\t measure memory bandwidth and integer peak, then report how close the run gets to them ;" << std::endl;
+		std::cerr << "\t --checkpoint FILE \t write the grid as pattern every --checkpoint-every NUM generations, from a background thread ;" << std::endl;
+		std::cerr << "\t --shm NAME \t\t export the frames into a shared memory ring of --shm-slots NUM frames, read by GOL_shm_view ;" << std::endl;
+		std::cerr << "\t --shm-scale NUM \t side of the block of cells of each pixel of the exported frames ;" << std::endl;
+		std::cerr << "\t --shm-replace \t\t remove an existing shared memory with the same name, instead of failing ;" << std::endl;
+		std::cerr << "\t --deltas FILE \t\t write the cells changed by each generation, with a keyframe every --keyframe-every NUM, read by GOL_delta ;" << std::endl;
 		std::cerr << "\t --help \t\t this help view ;" << std::endl;
 		return false;
 	}
@@ -182,8 +468,49 @@ bool menu( int argc, char** argv, bool& vectorization, unsigned int& num_tasks,
 	iterations = (unsigned int) po.get_number( "-i", "--iterations", 100 );
 	nw = (unsigned int) po.get_number( "-t", "--thread", 0 );
 	num_tasks = (unsigned int) po.get_number( "-n", "--num_chunks", nw );
+	settings.store_path = po.get( "--out-of-core" );
+	settings.band_rows = (size_t) po.get_number( "--band", DEFAULT_BAND_ROWS );
+	settings.pattern_path = po.get( "--pattern" );
+	settings.pattern_row = (size_t) po.get_number( "--at-row", 0 );
+	settings.pattern_col = (size_t) po.get_number( "--at-col", 0 );
+	settings.export_path = po.get( "--export" );
+	settings.stats_path = po.get( "--stats" );
+	settings.stop_on_cycle = po.exists( "--stop-on-cycle" );
+	settings.metrics_path = po.get( "--metrics-json" );
+	settings.latency = po.exists( "--latency" );
+	settings.imbalance = po.exists( "--imbalance" );
+	settings.perf = po.exists( "--perf" );
+	settings.trace_path = po.get( "--trace" );
+	settings.roofline = po.exists( "--roofline" );
+	settings.checkpoint_path = po.get( "--checkpoint" );
+	settings.checkpoint_every = (unsigned int) po.get_number( "--checkpoint-every", DEFAULT_CHECKPOINT_EVERY );
+	settings.shm_name = po.get( "--shm" );
+	settings.shm_scale = (unsigned int) po.get_number( "--shm-scale", 1 );
+	settings.shm_slots = (unsigned int) po.get_number( "--shm-slots", DEFAULT_FRAME_RING_SLOTS );
+	settings.shm_replace = po.exists( "--shm-replace" );
+	settings.delta_path = po.get( "--deltas" );
+	settings.keyframe_every = (unsigned int) po.get_number( "--keyframe-every", DEFAULT_KEYFRAME_EVERY );
 	// At least one task per Worker.
-	assert ( num_tasks >= 0 && nw >= 0 && width > 0 && height > 0 && iterations > 0 );
+	assert ( num_tasks >= 0 && nw >= 0 && width > 0 && height > 0 && iterations > 0 && settings.band_rows > 0 );
+
+	// The out-of-core version computes the bands on the calling thread and never keeps a whole generation in memory,
+	// so the options about the workers and the readers of the generations cannot be honored.
+	if ( settings.store_path != NULL )
+	{
+		const std::pair<bool, const char*> unsupported[] = {
+			std::make_pair( nw > 0, "-t, --thread" ), std::make_pair( po.exists( "-n", "--num_chunks" ), "-n, --num_tasks" ),
+			std::make_pair( settings.imbalance, "--imbalance" ), std::make_pair( settings.perf, "--perf" ),
+			std::make_pair( settings.trace_path != NULL, "--trace" ), std::make_pair( settings.checkpoint_path != NULL, "--checkpoint" ),
+			std::make_pair( settings.shm_name != NULL, "--shm" ), std::make_pair( settings.delta_path != NULL, "--deltas" ) };
+		bool valid = true;
+		for ( size_t u = 0; u < sizeof(unsupported) / sizeof(unsupported[0]); u++ )
+		{
+			if ( !unsupported[u].first ) continue;
+			std::cerr << "Error: " << unsupported[u].second << " is not supported by the out-of-core version." << std::endl;
+			valid = false;
+		}
+		if ( !valid ) return false;
+	}
 #if VECTORIZATION
 	vectorization = po.exists( "-v", "--vect" );
 	std::cout << "Vectorization: " << ( vectorization ? "true" : "false" ) << ", ";
@@ -191,11 +518,43 @@ bool menu( int argc, char** argv, bool& vectorization, unsigned int& num_tasks,
 	vectorization = false;
 #endif // VECTORIZATION
 	std::cout << "Width: " << width << ", Height: " << height << ", Seed: " << seed;
-	std::cout << ", #Iterations: " << iterations << ", #Workers: " << nw << ", #Tasks: " << num_tasks << "." << std::endl;
+	std::cout << ", #Iterations: " << iterations << ", #Workers: " << nw << ", #Tasks: " << num_tasks;
+	if ( settings.store_path != NULL )
+		std::cout << ", Out-of-core: " << settings.store_path << ", Band: " << settings.band_rows;
+	if ( settings.pattern_path != NULL )
+		std::cout << ", Pattern: " << settings.pattern_path << " at (" << settings.pattern_row << ", " << settings.pattern_col << ")";
+	std::cout << "." << std::endl;
+
+	// The roofline mode computes the throughput of the run from its metrics.
+	if ( settings.metrics_path != NULL || settings.roofline )
+	{
+		run_metrics = new Metrics( argv[0], width, height );
+		run_metrics->set_config( "seed", (long) seed );
+		run_metrics->set_config( "iterations", (long) iterations );
+		run_metrics->set_config( "threads", (long) nw );
+		run_metrics->set_config( "tasks", (long) num_tasks );
+		run_metrics->set_config( "vectorization", vectorization );
+		run_metrics->set_config( "out_of_core", settings.store_path != NULL );
+	}
+	// The phases are measured if the flag is on or if they are reported in the metrics JSON.
+#if TAKE_ALL_TIME
+	take_all_time = true;
+#else
+	take_all_time = ( run_metrics != NULL );
+#endif // TAKE_ALL_TIME
+	// Calibrate the timer of the phases before the run, so that the calibration does not perturb it.
+	if ( take_all_time )
+		TscTimer::calibrate();
+	if ( settings.roofline )
+	{
+		bool statistics = ( settings.stats_path != NULL || settings.stop_on_cycle );
+		KernelModel model = kernel_model( vectorization, statistics, settings.delta_path != NULL, settings.store_path != NULL );
+		run_roofline = new Roofline( ( nw > 0 && settings.store_path == NULL ) ? nw : 1, model );
+	}
 	return true;
 }
 
-void initialization( bool vectorization, size_t width, size_t height, unsigned int seed, Grid*& g )
+void initialization( bool vectorization, size_t width, size_t height, unsigned int seed, const Settings& settings, Grid*& g )
 {
 	std::chrono::high_resolution_clock::time_point t1, t2;
 	// Start - Initialization Phase
@@ -203,13 +562,21 @@ void initialization( bool vectorization, size_t width, size_t height, unsigned i
 
 	// Create and initialize the Grid object.
 	g = new Grid( height, width );
-	g->init( seed );
+	if ( settings.pattern_path != NULL )
+	{
+		GridPattern gp( g );
+		g->clear();
+		load_pattern( settings.pattern_path, gp, settings.pattern_row, settings.pattern_col );
+	}
+	else
+	{
 #if VECTORIZATION
-	if ( vectorization ) g->init_vect( seed );
-	else g->init( seed );
+		if ( vectorization ) g->init_vect( seed );
+		else g->init( seed );
 #else
-	g->init( seed );
+		g->init( seed );
 #endif // VECTORIZATION
+	}
 	// Configure the border to properly respect the logic of the 2D toroidal grid
 	g->copyBorder();
 
@@ -229,6 +596,64 @@ void initialization( bool vectorization, size_t width, size_t height, unsigned i
 	printTime( t1, t2, "initialization phase" );
 }
 
+StatsRecorder* create_recorder( PatternGrid& g, unsigned int iterations, const Settings& settings )
+{
+	if ( settings.stats_path == NULL && !settings.stop_on_cycle ) return NULL;
+	return new StatsRecorder( iterations, initial_statistics( g ), settings.stop_on_cycle );
+}
+
+SnapshotPublisher* create_publisher( Grid* g, const Settings& settings )
+{
+	// The checkpoints are the first reader, the shared memory the next one.
+	unsigned int readers = ( settings.checkpoint_path != NULL ) + ( settings.shm_name != NULL );
+	if ( readers == 0 ) return NULL;
+	return new SnapshotPublisher( g, readers );
+}
+
+Checkpointer* create_checkpointer( SnapshotPublisher* publisher, const Settings& settings )
+{
+	if ( settings.checkpoint_path == NULL ) return NULL;
+	return new Checkpointer( publisher, 0, settings.checkpoint_path, settings.checkpoint_every );
+}
+
+FrameRing* create_frame_ring( SnapshotPublisher* publisher, const Settings& settings )
+{
+	if ( settings.shm_name == NULL ) return NULL;
+	return new FrameRing( publisher, ( settings.checkpoint_path != NULL ) ? 1 : 0, settings.shm_name, settings.shm_scale, settings.shm_slots, settings.shm_replace );
+}
+
+DeltaWriter* create_delta_writer( Grid* g, const Settings& settings )
+{
+	if ( settings.delta_path == NULL ) return NULL;
+	return new DeltaWriter( g, settings.delta_path, settings.keyframe_every );
+}
+
+void finalization( PatternGrid& g, const Settings& settings, const StatsRecorder* recorder )
+{
+	// The percentiles are reported if requested, or if they are written in the metrics.
+	if ( settings.latency || run_metrics != NULL )
+		generation_latency.report( "generation" );
+	if ( run_roofline != NULL )
+		run_roofline->report( *run_metrics );
+
+	// The metrics are written first, so that the finalization phase does not perturb them.
+	if ( settings.metrics_path != NULL )
+		run_metrics->write( settings.metrics_path );
+
+	if ( settings.export_path == NULL && settings.stats_path == NULL ) return;
+
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	// Start - Finalization Phase
+	t1 = std::chrono::high_resolution_clock::now();
+	if ( settings.export_path != NULL )
+		save_pattern( settings.export_path, g );
+	if ( settings.stats_path != NULL )
+		recorder->write( settings.stats_path );
+	// End - Finalization Phase
+	t2 = std::chrono::high_resolution_clock::now();
+	printTime( t1, t2, "finalization phase" );
+}
+
 void setup_working_variable( Grid* g, unsigned int& num_tasks, unsigned int& nw, size_t& start, size_t*& chunks )
 {
 	size_t workingSize = g->size() - 2*g->width() - 2;
@@ -273,8 +698,18 @@ void setup_working_variable( Grid* g, unsigned int& num_tasks, unsigned int& nw,
 #endif // DEBUG
 }
 
+void record_generation( std::chrono::high_resolution_clock::time_point t1, std::chrono::high_resolution_clock::time_point t2 )
+{
+	generation_latency.record( t1, t2 );
+	if ( run_metrics != NULL )
+		run_metrics->add_generation( t1, t2 );
+}
+
 void printTime( long duration, const char *msg )
 {
+	if ( run_metrics != NULL )
+		run_metrics->add_phase( msg, duration );
+
 #if MACHINE_TIME
 	std::cout << "Time to " << msg << ": " << duration << std::endl;
 #else
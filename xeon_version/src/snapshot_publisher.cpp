@@ -0,0 +1,108 @@
+/**
+ *	@file snapshot_publisher.cpp
+ *  @brief Implementation of \see SnapshotPublisher class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "../include/snapshot_publisher.h"
+
+SnapshotPublisher::SnapshotPublisher( Grid* g, unsigned int readers ) : g(g), readers(readers)
+{
+	// The two arrays of the grid, plus one for each reader.
+	this->buffers.push_back( g->Read );
+	this->buffers.push_back( g->Write );
+	try
+	{
+		for ( unsigned int r = 0; r < readers; r++ )
+			this->buffers.push_back( new bool[g->size()] );
+	}
+	catch( std::bad_alloc& badAlloc )
+	{
+		std::cerr << "Error: not enough memory for the snapshots, reduce side value." << std::endl;
+		exit( 1 );
+	}
+	this->generations.assign( this->buffers.size(), 0 );
+	this->busy.assign( this->buffers.size(), false );
+
+	this->held = new std::atomic<int>[readers];
+	for ( unsigned int r = 0; r < readers; r++ )
+		this->held[r].store( -1 );
+	this->latest.store( 0 );
+	this->published.store( 0 );
+}
+
+int SnapshotPublisher::index_of( const bool* buffer ) const
+{
+	for ( size_t b = 0; b < this->buffers.size(); b++ )
+		if ( this->buffers[b] == buffer )
+			return (int) b;
+	return -1;
+}
+
+void SnapshotPublisher::publish( unsigned int generation )
+{
+	int read = this->index_of( this->g->Read );
+	this->generations[read] = generation;
+	this->latest.store( read );
+	this->published.store( generation, std::memory_order_release );
+
+	// The new writing array can be any one that is neither the latest snapshot nor held by a reader:
+	// there are two more arrays than readers, so at least one is free.
+	std::fill( this->busy.begin(), this->busy.end(), false );
+	this->busy[read] = true;
+	for ( unsigned int r = 0; r < this->readers; r++ )
+	{
+		int h = this->held[r].load();
+		if ( h >= 0 ) this->busy[h] = true;
+	}
+	// Prefer the previous reading array, as the plain swap does, to keep using the same two arrays.
+	int write = this->index_of( this->g->Write );
+	if ( this->busy[write] )
+		write = (int) ( std::find( this->busy.begin(), this->busy.end(), false ) - this->busy.begin() );
+	this->g->Write = this->buffers[write];
+}
+
+Snapshot SnapshotPublisher::acquire( unsigned int reader )
+{
+	int b;
+	do
+	{
+		b = this->latest.load();
+		this->held[reader].store( b );
+	}
+	while ( this->latest.load() != b );
+
+	Snapshot s = { this->buffers[b], this->g->width(), this->g->height(), this->generations[b] };
+	return s;
+}
+
+void SnapshotPublisher::release( unsigned int reader )
+{
+	this->held[reader].store( -1 );
+}
+
+SnapshotPublisher::~SnapshotPublisher()
+{
+	// The arrays used by the grid are freed by the grid itself.
+	for ( size_t b = 0; b < this->buffers.size(); b++ )
+		if ( this->buffers[b] != this->g->Read && this->buffers[b] != this->g->Write )
+			delete[] this->buffers[b];
+	delete[] this->held;
+}
@@ -0,0 +1,157 @@
+/**
+ *	@file statistics.cpp
+ *  @brief Implementation of \see GenerationStats struct and \see StatsRecorder class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+
+#include "../include/statistics.h"
+
+void GenerationStats::reset()
+{
+	this->population = 0;
+	this->births = 0;
+	this->deaths = 0;
+	this->hash = 0;
+}
+
+GenerationStats& GenerationStats::operator+=( const GenerationStats& s )
+{
+	this->population += s.population;
+	this->births += s.births;
+	this->deaths += s.deaths;
+	this->hash ^= s.hash;
+	return *this;
+}
+
+StatsRecorder::StatsRecorder( unsigned int iterations, const GenerationStats& initial, bool stop_on_cycle )
+{
+	this->series.reserve( iterations + 1 );
+	this->series.push_back( initial );
+	this->history[0] = initial.hash;
+	this->period = 0;
+	this->stop_on_cycle = stop_on_cycle;
+}
+
+bool StatsRecorder::record( GenerationStats s )
+{
+	const GenerationStats& previous = this->series.back();
+	s.population = previous.population + s.births - s.deaths;
+	s.hash ^= previous.hash;
+	this->series.push_back( s );
+
+	if ( this->period == 0 )
+	{
+		// Look for the same hash among the last CYCLE_HISTORY generations, starting from the nearest one.
+		unsigned int k = this->generations();
+		unsigned int depth = std::min( k, (unsigned int) CYCLE_HISTORY );
+		for ( unsigned int p = 1; p <= depth; p++ )
+		{
+			if ( this->history[(k - p) % CYCLE_HISTORY] == s.hash )
+			{
+				// Since this is the first repetition, the cycle starts at generation k - p.
+				this->period = p;
+				std::cout << "Cycle detected at generation " << k << ": transient length " << k - p << ", period " << p << "." << std::endl;
+				break;
+			}
+		}
+		this->history[k % CYCLE_HISTORY] = s.hash;
+	}
+
+	return ( this->period != 0 && this->stop_on_cycle );
+}
+
+unsigned int StatsRecorder::generations() const
+{
+	return (unsigned int) ( this->series.size() - 1 );
+}
+
+void StatsRecorder::write( const char* path ) const
+{
+	std::ofstream f( path );
+	if ( f.fail() )
+	{
+		std::cerr << "Error: it is not possible to create the statistics file " << path << "." << std::endl;
+		exit( 1 );
+	}
+
+	size_t len = strlen( path );
+	if ( len >= 5 && strcmp( path + len - 5, ".json" ) == 0 )
+	{
+		f << "{ \"generations\": [" << std::endl;
+		for ( size_t k = 0; k < this->series.size(); k++ )
+		{
+			const GenerationStats& s = this->series[k];
+			f << "\t{ \"generation\": " << k << ", \"population\": " << s.population;
+			f << ", \"births\": " << s.births << ", \"deaths\": " << s.deaths;
+			f << ", \"hash\": \"" << std::hex << std::setw(16) << std::setfill('0') << s.hash << std::dec << "\" }";
+			f << ( ( k + 1 < this->series.size() ) ? "," : "" ) << std::endl;
+		}
+		f << "] }" << std::endl;
+	}
+	else
+	{
+		f << "generation,population,births,deaths,hash" << std::endl;
+		for ( size_t k = 0; k < this->series.size(); k++ )
+		{
+			const GenerationStats& s = this->series[k];
+			f << k << "," << s.population << "," << s.births << "," << s.deaths << ",";
+			f << std::hex << std::setw(16) << std::setfill('0') << s.hash << std::dec << std::endl;
+		}
+	}
+}
+
+GenerationStats initial_statistics( PatternGrid& g )
+{
+	GenerationStats s;
+	size_t w = g.width() + 2;
+	for ( size_t i = 0; i < g.height(); i++ )
+	{
+		const bool* row = g.row( i );
+		for ( size_t j = 0; j < g.width(); j++ )
+		{
+			if ( !row[j] ) continue;
+			s.population++;
+			s.hash ^= zobrist_key( (i + 1) * w + j + 1 );
+		}
+	}
+	return s;
+}
+
+void exclude_border( Grid* g, size_t start, size_t end, GenerationStats& stats )
+{
+	size_t w = g->width();
+	for ( size_t i = start / w; i <= (end - 1) / w; i++ )
+	{
+		// Left and right border cells of the i-th row.
+		size_t border[2] = { i * w, i * w + w - 1 };
+		for ( int b = 0; b < 2; b++ )
+		{
+			size_t pos = border[b];
+			if ( pos < start || pos >= end ) continue;
+			stats.births -= ( g->Write[pos] && !g->Read[pos] );
+			stats.deaths -= ( g->Read[pos] && !g->Write[pos] );
+			if ( g->Write[pos] != g->Read[pos] )
+				stats.hash ^= zobrist_key( pos + stats.key_offset );
+		}
+	}
+}
@@ -0,0 +1,270 @@
+/**
+ *	@file stream_grid.cpp
+ *  @brief Implementation of \see StreamGrid class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../include/stream_grid.h"
+#include "../include/shared_functions.h"
+
+StreamGrid::StreamGrid( const char* path, size_t height, size_t width, size_t band_rows )
+{
+	// Initialize private variables
+	this->rows = height;
+	this->cols = width;
+	this->band_rows = std::min( band_rows, height );
+	this->num_bands = ( this->rows + this->band_rows - 1 ) / this->band_rows;
+	this->read_plane = 0;
+	this->row_buffer = new bool[this->cols];
+	this->alive_row = new bool[this->cols];
+	std::fill( this->alive_row, this->alive_row + this->cols, true );
+
+	// Create the backing file, big enough to contain the two planes.
+	this->fd = open( path, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+	if ( this->fd < 0 || ftruncate( this->fd, (off_t) ( 2 * this->rows * this->cols ) ) != 0 )
+	{
+		std::cerr << "Error: it is not possible to create the backing file " << path << "." << std::endl;
+		exit( 1 );
+	}
+
+	// Allocate the windows through which the bands are streamed.
+	for ( int i = 0; i < NUM_WINDOWS; i++ )
+	{
+		this->windows[i] = new Grid( this->band_rows, this->cols );
+		Band b = { this->windows[i], 0, 0 };
+		this->free_windows.push( b );
+	}
+
+	// Start the read-ahead and the write-behind stages, which wait for the first generation.
+	this->reader = std::thread( &StreamGrid::read_ahead, this );
+	this->writer = std::thread( &StreamGrid::write_behind, this );
+}
+
+void StreamGrid::init( unsigned int seed )
+{
+	// Initialize random seed
+	srand((seed == 0) ? time(NULL) : seed);
+
+	// Consume the random values in the same order of Grid::init, border included,
+	// but store only the values that fall into the grid.
+	bool* row = new bool[this->cols];
+	for ( size_t i = 0; i < this->rows + 2; i++ )
+	{
+		for ( size_t j = 0; j < this->cols + 2; j++ )
+		{
+			bool value = (rand() > RAND_MAX_HALF);
+			if ( j > 0 && j <= this->cols )
+				row[j - 1] = value;
+		}
+		if ( i > 0 && i <= this->rows )
+			this->write_bytes( row, this->cols, this->row_offset( this->read_plane, i - 1 ) );
+	}
+	delete[] row;
+}
+
+unsigned long long StreamGrid::stream_generation( bool vectorization, GenerationStats* stats )
+{
+	TscAccumulator wait;
+	size_t w = this->cols + 2;
+	int* numNeighbours = NULL;
+	if ( vectorization )
+		numNeighbours = new int[VLEN];
+
+	// Ask the read-ahead stage to stream the reading plane.
+	Band request = { NULL, 0, this->num_bands };
+	this->requests.push( request );
+
+	for ( size_t b = 0; b < this->num_bands; b++ )
+	{
+		// Wait for the next band.
+		wait.start();
+		Band band = this->loaded_bands.pop();
+		wait.stop();
+
+		// Compute the rows of the band, skipping the predecessor and successor rows.
+		size_t start = w + 1, end = ( band.count + 1 ) * w - 1;
+		if ( stats != NULL )
+		{
+			// The first row of the band is the second one of its window, so shift the cell keys
+			// to obtain the same hash of the in-memory version.
+			stats->key_offset = band.first * w;
+			compute_chunk( band.window, numNeighbours, vectorization, start, end, stats );
+			exclude_border( band.window, start, end, *stats );
+		}
+		else
+			compute_chunk( band.window, numNeighbours, vectorization, start, end, NULL );
+
+		this->computed_bands.push( band );
+	}
+
+	// Wait that the write-behind stage releases all the windows, so that the writing plane is complete.
+	Band windows[NUM_WINDOWS];
+	for ( int i = 0; i < NUM_WINDOWS; i++ )
+		windows[i] = this->free_windows.pop();
+	for ( int i = 0; i < NUM_WINDOWS; i++ )
+		this->free_windows.push( windows[i] );
+	if ( vectorization )
+		delete[] numNeighbours;
+
+	// Swap the reading and writing planes.
+	this->read_plane = 1 - this->read_plane;
+	return wait.ticks();
+}
+
+void StreamGrid::store( Grid* g ) const
+{
+	assert( g->height() == this->rows + 2 && g->width() == this->cols + 2 );
+	for ( size_t i = 0; i < this->rows; i++ )
+		this->read_bytes( g->Read + (i + 1) * g->width() + 1, this->cols, this->row_offset( this->read_plane, i ) );
+	g->copyBorder();
+}
+
+size_t StreamGrid::width() const
+{
+	return this->cols;
+}
+
+size_t StreamGrid::height() const
+{
+	return this->rows;
+}
+
+void StreamGrid::set_alive( size_t i, size_t j, size_t count )
+{
+	this->write_bytes( this->alive_row, count, this->row_offset( this->read_plane, i ) + (off_t) j );
+}
+
+const bool* StreamGrid::row( size_t i )
+{
+	this->read_bytes( this->row_buffer, this->cols, this->row_offset( this->read_plane, i ) );
+	return this->row_buffer;
+}
+
+void StreamGrid::read_ahead()
+{
+	size_t w = this->cols + 2;
+	for ( Band request = this->requests.pop(); request.count > 0; request = this->requests.pop() )
+	{
+		for ( size_t b = 0; b < request.count; b++ )
+		{
+			Band band = this->free_windows.pop();
+			band.first = b * this->band_rows;
+			band.count = std::min( this->band_rows, this->rows - band.first );
+
+			// Load the rows of the band together with its predecessor and successor rows,
+			// following the logic of the 2D toroidal grid.
+			for ( size_t i = 0; i < band.count + 2; i++ )
+			{
+				size_t r = ( band.first + this->rows + i - 1 ) % this->rows;
+				bool* row = band.window->Read + i * w;
+				this->read_bytes( row + 1, this->cols, this->row_offset( this->read_plane, r ) );
+				// Fill left & right borders.
+				row[0] = row[this->cols];
+				row[this->cols + 1] = row[1];
+			}
+
+			this->loaded_bands.push( band );
+		}
+	}
+}
+
+void StreamGrid::write_behind()
+{
+	size_t w = this->cols + 2;
+	for ( Band band = this->computed_bands.pop(); band.count > 0; band = this->computed_bands.pop() )
+	{
+		for ( size_t i = 0; i < band.count; i++ )
+			this->write_bytes( band.window->Write + (i + 1) * w + 1, this->cols, this->row_offset( 1 - this->read_plane, band.first + i ) );
+		this->free_windows.push( band );
+	}
+}
+
+void StreamGrid::read_bytes( bool* dst, size_t count, off_t offset ) const
+{
+	char* p = (char*) dst;
+	while ( count > 0 )
+	{
+		ssize_t n = pread( this->fd, p, count, offset );
+		if ( n <= 0 )
+		{
+			std::cerr << "Error: it is not possible to read from the backing file." << std::endl;
+			exit( 1 );
+		}
+		p += n;
+		offset += n;
+		count -= (size_t) n;
+	}
+}
+
+void StreamGrid::write_bytes( const bool* src, size_t count, off_t offset ) const
+{
+	const char* p = (const char*) src;
+	while ( count > 0 )
+	{
+		ssize_t n = pwrite( this->fd, p, count, offset );
+		if ( n <= 0 )
+		{
+			std::cerr << "Error: it is not possible to write onto the backing file." << std::endl;
+			exit( 1 );
+		}
+		p += n;
+		offset += n;
+		count -= (size_t) n;
+	}
+}
+
+off_t StreamGrid::row_offset( int plane, size_t i ) const
+{
+	return (off_t) ( ( plane * this->rows + i ) * this->cols );
+}
+
+void StreamGrid::BandQueue::push( const Band& b )
+{
+	std::lock_guard<std::mutex> lock( this->mux );
+	this->items.push_back( b );
+	this->cv.notify_one();
+}
+
+StreamGrid::Band StreamGrid::BandQueue::pop()
+{
+	std::unique_lock<std::mutex> lock( this->mux );
+	this->cv.wait( lock, [this] { return !this->items.empty(); } );
+	Band b = this->items.front();
+	this->items.pop_front();
+	return b;
+}
+
+StreamGrid::~StreamGrid()
+{
+	// Terminate the two stages.
+	Band end = { NULL, 0, 0 };
+	this->requests.push( end );
+	this->computed_bands.push( end );
+	this->reader.join();
+	this->writer.join();
+
+	for ( int i = 0; i < NUM_WINDOWS; i++ )
+		delete this->windows[i];
+	delete[] this->row_buffer;
+	delete[] this->alive_row;
+	close( this->fd );
+}
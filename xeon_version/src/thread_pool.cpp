@@ -0,0 +1,216 @@
+/**
+ *	@file thread_pool.cpp
+ *  @brief Implementation of \see ThreadPool class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <chrono>
+
+#include "../include/thread_pool.h"
+#include "../include/shared_functions.h"
+#include "../include/probes.h"
+
+ThreadPool::ThreadPool( Grid* g, unsigned int nw, bool vectorization, bool statistics, LoadProfile* profile, PerfReport* perf, Tracer* tracer, bool deltas )
+{
+	this->g = g;
+	this->nw = nw;
+	this->vectorization = vectorization;
+	this->generation = 0;
+	this->profile = profile;
+	this->perf = perf;
+	this->tracer = tracer;
+	this->busy = new std::atomic<bool>[nw];
+	this->terminate.store( false );
+	this->starts = new size_t[nw];
+	this->ends = new size_t[nw];
+	this->worker_stats = statistics ? new GenerationStats[nw] : NULL;
+	this->worker_changes = deltas ? new DeltaBuffer[nw] : NULL;
+
+	// Create and start the workers.
+	for( int t = 0; t < nw; t++ )
+	{
+		this->busy[t].store( false );
+		this->tid.push_back( std::thread( &ThreadPool::thread_body, this, t ) );
+	}
+}
+
+unsigned long long ThreadPool::run_generation( size_t start, const size_t* chunks, unsigned int num_tasks )
+{
+	unsigned int counter_sent_tasks = 0;
+	size_t start_chunk, end_chunk = start;
+
+	// The threads read the generation index only after receiving a task, so it is safely published by busy.
+	while ( counter_sent_tasks < num_tasks )
+	{
+		int t = this->find_first_thread_free();
+		start_chunk = end_chunk;
+		end_chunk = start_chunk + chunks[counter_sent_tasks];
+		counter_sent_tasks++;
+		this->starts[t] = start_chunk;
+		this->ends[t] = end_chunk;
+		PROBE_TASK_DISPATCH( t, start_chunk, end_chunk );
+		this->busy[t].store( true );
+	}
+
+	unsigned long long barrier_time;
+	PROBE_BARRIER_ENTER( this->generation + 1 );
+	if ( this->tracer != NULL )
+	{
+		std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+		barrier_time = this->barrier();
+		std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+		this->tracer->buffer( 0 )->add( "barrier", t1, t2, this->generation );
+	}
+	else
+		barrier_time = this->barrier();
+	PROBE_BARRIER_EXIT( this->generation + 1 );
+	this->generation++;
+	return barrier_time;
+}
+
+void ThreadPool::reduce_statistics( GenerationStats& stats )
+{
+	for ( int t = 0; t < this->nw; t++ )
+	{
+		stats += this->worker_stats[t];
+		this->worker_stats[t].reset();
+	}
+}
+
+void ThreadPool::collect_changes( DeltaBuffer& changes )
+{
+	for ( int t = 0; t < this->nw; t++ )
+	{
+		changes.insert( changes.end(), this->worker_changes[t].begin(), this->worker_changes[t].end() );
+		this->worker_changes[t].clear();
+	}
+}
+
+void ThreadPool::thread_body( int id )
+{
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	std::atomic<bool>* busy = &this->busy[id];
+	GenerationStats* stats = ( this->worker_stats != NULL ) ? &this->worker_stats[id] : NULL;
+	DeltaBuffer* changes = ( this->worker_changes != NULL ) ? &this->worker_changes[id] : NULL;
+	int* numNeighbours = NULL;
+	if ( this->vectorization )
+		numNeighbours = new int[VLEN];
+	// The counters have to be opened by the thread that they measure.
+	PerfCounters* counters = ( this->perf != NULL ) ? new PerfCounters() : NULL;
+	TraceBuffer* trace = ( this->tracer != NULL ) ? this->tracer->buffer( id + 1 ) : NULL;
+
+	// Loop until the master does not say that it can terminate.
+	while ( !this->terminate.load() )
+	{
+		// Enters in a busy-looping until there is not work to do or has to terminate.
+		while ( !busy->load() && !this->terminate.load() );
+
+		// If does not have to terminate, it executes its job.
+		if ( !this->terminate.load() )
+		{
+			// What has been counted since the previous task was spent waiting for this one.
+			if ( counters != NULL ) counters->stop( PERF_SPIN );
+
+			// Execute the job on the assigned chunk.
+			PROBE_TASK_START( id, this->starts[id], this->ends[id] );
+			if ( this->profile != NULL || trace != NULL )
+			{
+				t1 = std::chrono::high_resolution_clock::now();
+				compute_chunk( this->g, numNeighbours, this->vectorization, this->starts[id], this->ends[id], stats, changes );
+				t2 = std::chrono::high_resolution_clock::now();
+				if ( this->profile != NULL )
+					this->profile->add_task( id, this->generation, t1, t2 );
+				if ( trace != NULL )
+					trace->add( "task", t1, t2, this->generation, this->ends[id] - this->starts[id] );
+			}
+			else
+				compute_chunk( this->g, numNeighbours, this->vectorization, this->starts[id], this->ends[id], stats, changes );
+
+			PROBE_TASK_END( id, this->starts[id], this->ends[id] );
+			if ( counters != NULL ) counters->stop( PERF_KERNEL );
+
+			// Signal that now is free.
+			busy->store( false );
+		}
+	}
+
+	if ( this->vectorization )
+		delete[] numNeighbours;
+	if ( counters != NULL )
+	{
+		counters->stop( PERF_SPIN );
+		this->perf->add( *counters );
+		delete counters;
+	}
+}
+
+int ThreadPool::find_first_thread_free() const
+{
+	int found = -1;
+	// Repeat looking to a free thread until it founds one.
+	while ( found == -1 )
+	{
+		// Scan all threads sequentially.
+		for ( int i = 0; i < this->nw; i++ )
+		{
+			// We have finish when we found a not busy thread.
+			if ( !this->busy[i].load() )
+			{
+				found = i;
+				break;
+			}
+		}
+	}
+	return found;
+}
+
+unsigned long long ThreadPool::barrier() const
+{
+	// Start - Barrier phase.
+	unsigned long long t1 = take_all_time ? TscTimer::now() : 0;
+
+	// Scan all threads sequentially and wait that all finish their jobs.
+	for ( int i = 0; i < this->nw; i++ )
+	{
+		// Wait until the thread has not finish its job, i.e. is not busy anymore.
+		while ( this->busy[i].load() )
+		{
+			// Loose some time before retrying.
+			for ( volatile unsigned int j = 0; j < LOOSE_SOME_TIME; j++ );
+		}
+	}
+
+	// End - Barrier phase.
+	return take_all_time ? TscTimer::now() - t1 : 0;
+}
+
+ThreadPool::~ThreadPool()
+{
+	// Terminate all threads.
+	this->terminate.store( true );
+
+	// Await the threads termination.
+	for ( int t = 0; t < this->nw; t++ )
+		this->tid[t].join();
+
+	delete[] this->busy;
+	delete[] this->starts;
+	delete[] this->ends;
+	delete[] this->worker_stats;
+	delete[] this->worker_changes;
+}
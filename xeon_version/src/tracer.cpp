@@ -0,0 +1,114 @@
+/**
+ *	@file tracer.cpp
+ *  @brief Implementation of \see TraceBuffer and \see Tracer classes.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <fstream>
+#include <iomanip>
+
+#include "../include/tracer.h"
+#include "../include/metrics.h"
+
+TraceBuffer::TraceBuffer( std::chrono::high_resolution_clock::time_point origin )
+{
+	this->origin = origin;
+	this->events = new TraceEvent[TRACE_CAPACITY];
+	this->count = 0;
+}
+
+void TraceBuffer::write( std::ostream& out, unsigned int tid ) const
+{
+	unsigned long long oldest = ( this->count > TRACE_CAPACITY ) ? this->count - TRACE_CAPACITY : 0;
+	for ( unsigned long long k = oldest; k < this->count; k++ )
+	{
+		const TraceEvent& e = this->events[k % TRACE_CAPACITY];
+		// Complete events ( "X" ), with timestamp and duration in microseconds.
+		out << "," << std::endl;
+		out << "\t{ \"name\": " << json_string( e.name ) << ", \"cat\": \"gol\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid;
+		out << ", \"ts\": " << e.begin / 1000.0 << ", \"dur\": " << ( e.end - e.begin ) / 1000.0;
+		out << ", \"args\": { \"generation\": " << e.generation;
+		if ( e.cells > 0 )
+			out << ", \"cells\": " << e.cells;
+		out << " } }";
+	}
+}
+
+unsigned long long TraceBuffer::dropped() const
+{
+	return ( this->count > TRACE_CAPACITY ) ? this->count - TRACE_CAPACITY : 0;
+}
+
+TraceBuffer::~TraceBuffer()
+{
+	delete[] this->events;
+}
+
+Tracer::Tracer( unsigned int nw )
+{
+	this->nw = nw;
+	std::chrono::high_resolution_clock::time_point origin = std::chrono::high_resolution_clock::now();
+	// The buffers are allocated in advance, so the threads never allocate while they are traced.
+	this->buffers = new TraceBuffer*[nw + 1];
+	for ( unsigned int i = 0; i <= nw; i++ )
+		this->buffers[i] = new TraceBuffer( origin );
+}
+
+TraceBuffer* Tracer::buffer( unsigned int index )
+{
+	return this->buffers[index];
+}
+
+void Tracer::write( const char* path ) const
+{
+	std::ofstream f( path );
+	if ( f.fail() )
+	{
+		std::cerr << "Error: it is not possible to create the trace file " << path << "." << std::endl;
+		exit( 1 );
+	}
+	f << std::fixed << std::setprecision( 3 );
+
+	f << "{ \"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+	// Metadata events that name the threads.
+	f << std::endl << "\t{ \"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": { \"name\": \"Game of Life\" } }";
+	for ( unsigned int i = 0; i <= this->nw; i++ )
+	{
+		f << "," << std::endl << "\t{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i << ", \"args\": { \"name\": \"";
+		if ( i == 0 ) f << "Master";
+		else f << "Worker " << i - 1;
+		f << "\" } }";
+	}
+	for ( unsigned int i = 0; i <= this->nw; i++ )
+	{
+		this->buffers[i]->write( f, i );
+		if ( this->buffers[i]->dropped() > 0 )
+		{
+			std::cout << "Warning: the trace of thread " << i << " overflowed, its oldest "
+					  << this->buffers[i]->dropped() << " events have been discarded." << std::endl;
+		}
+	}
+	f << std::endl << "] }" << std::endl;
+}
+
+Tracer::~Tracer()
+{
+	for ( unsigned int i = 0; i <= this->nw; i++ )
+		delete this->buffers[i];
+	delete[] this->buffers;
+}
@@ -0,0 +1,61 @@
+/**
+ *	@file tsc_timer.cpp
+ *  @brief Implementation of \see TscTimer class.
+ *  @author Federico Conte (draxent)
+ *
+ *	Copyright 2015 Federico Conte
+ *	https://github.com/Draxent/GameOfLife
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "../include/tsc_timer.h"
+#if TSC_AVAILABLE
+#include <cpuid.h>
+#endif // TSC_AVAILABLE
+
+double TscTimer::ticks_per_us = 0;
+
+void TscTimer::calibrate()
+{
+	if ( TscTimer::ticks_per_us > 0 ) return;
+
+#if TSC_AVAILABLE
+	// Bit 8 of EDX of the leaf 0x80000007 tells if the counter ticks at a constant rate.
+	unsigned int eax, ebx, ecx, edx;
+	if ( !__get_cpuid( 0x80000007, &eax, &ebx, &ecx, &edx ) || !( edx & ( 1 << 8 ) ) )
+		std::cout << "Warning: the time stamp counter is not invariant, the phase times may be inaccurate." << std::endl;
+
+	// Count the ticks elapsed while the monotonic clock advances of TSC_CALIBRATION_US microseconds.
+	std::chrono::steady_clock::time_point t1, t2;
+	t1 = std::chrono::steady_clock::now();
+	unsigned long long c1 = TscTimer::now(), c2;
+	long elapsed;
+	do
+	{
+		t2 = std::chrono::steady_clock::now();
+		c2 = TscTimer::now();
+		elapsed = (long) std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
+	}
+	while ( elapsed < TSC_CALIBRATION_US );
+	TscTimer::ticks_per_us = (double) ( c2 - c1 ) / elapsed;
+#else
+	TscTimer::ticks_per_us = 1000;
+#endif // TSC_AVAILABLE
+}
+
+long TscTimer::microseconds( unsigned long long ticks )
+{
+	TscTimer::calibrate();
+	return (long) ( ticks / TscTimer::ticks_per_us );
+}
@@ -21,28 +21,59 @@
 
 
 #include "../include/worker.h"
+#include "../include/probes.h"
 
-Worker::Worker( int id, Grid* g, bool vectorization )
-		: id(id), g(g), vectorization(vectorization)
+Worker::Worker( int id, Grid* g, bool vectorization, bool statistics, LoadProfile* profile, PerfReport* perf, TraceBuffer* trace, DeltaBuffer* changes )
+		: id(id), vectorization(vectorization), statistics(statistics), g(g), profile(profile), perf(perf), trace(trace), changes(changes)
 {
+	this->counters = NULL;
+	this->numNeighbours = NULL;
 	if ( this->vectorization )
 		this->numNeighbours = new int[VLEN];
 }
 
+int Worker::svc_init()
+{
+	// The counters have to be opened by the thread that they measure.
+	if ( this->perf != NULL )
+		this->counters = new PerfCounters();
+	return 0;
+}
+
 Task_t* Worker::svc( Task_t* task )
 {
-#if VECTORIZATION
-	// The working size has to be significant in order to vectorized the thread_body function.
-	if ( this->vectorization )
-		compute_generation_vect( this->g, this->numNeighbours, task->start, task->end );
+	GenerationStats* stats = this->statistics ? &task->stats : NULL;
+	// What has been counted since the previous task was spent waiting for this one.
+	if ( this->counters != NULL ) this->counters->stop( PERF_SPIN );
+	PROBE_TASK_START( this->id, task->start, task->end );
+	if ( this->profile != NULL || this->trace != NULL )
+	{
+		std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+		compute_chunk( this->g, this->numNeighbours, this->vectorization, task->start, task->end, stats, this->changes );
+		std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+		if ( this->profile != NULL )
+			this->profile->add_task( this->id, task->generation, t1, t2 );
+		if ( this->trace != NULL )
+			this->trace->add( "task", t1, t2, task->generation, task->end - task->start );
+	}
 	else
-		compute_generation( this->g, task->start, task->end );
-#else
-	compute_generation( this->g, task->start, task->end );
-#endif // VECTORIZATION
+		compute_chunk( this->g, this->numNeighbours, this->vectorization, task->start, task->end, stats, this->changes );
+	PROBE_TASK_END( this->id, task->start, task->end );
+	if ( this->counters != NULL ) this->counters->stop( PERF_KERNEL );
 	return task;
 }
 
+void Worker::svc_end()
+{
+	if ( this->counters != NULL )
+	{
+		this->counters->stop( PERF_SPIN );
+		this->perf->add( *this->counters );
+		delete this->counters;
+		this->counters = NULL;
+	}
+}
+
 Worker::~Worker()
 {
 	if ( this->vectorization )